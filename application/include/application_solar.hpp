@@ -10,12 +10,69 @@
 #include "GeometryNode.hpp"
 #include "PointLightNode.hpp"
 #include "texture_loader.hpp"
+#include "icosphere.hpp"
+#include "geometry_pool.hpp"
+#include "culling.hpp"
+#include "bvh.hpp"
+#include "picking.hpp"
+#include "pixel_readback.hpp"
+#include "hiz_buffer.hpp"
+#include "query_ring.hpp"
+#include "asteroid_belt.hpp"
+#include "nbody.hpp"
+#include "gravity_compute.hpp"
+#include "ephemeris.hpp"
+#include "chebyshev.hpp"
+#include "scene_generator.hpp"
+#include "gpu_profiler.hpp"
+
+#include <array>
+#include <memory>
+
+// per planet data, read by the planet shader as instanced vertex attributes
+struct planet_draw_record {
+    glm::fmat4 model_matrix;
+    // x = texture layer, y = normal map layer, z = 1 if the planet has a normal map
+    glm::fvec4 draw_info;
+};
+
+// how small planets hidden behind others are skipped
+enum class occlusion_mode {
+    off,
+    // conditional rendering with last frames occlusion queries of bounding proxies
+    queries,
+    // tests against a cpu depth pyramid of the large planets, suited for many bodies
+    hierarchical_z
+};
+
+// occlusion culling results of the last frame
+struct occlusion_stats {
+    std::size_t tested = 0;
+    std::size_t occluded = 0;
+    // estimated fragments of all visible planets and of the skipped ones
+    float total_fragments = 0.0f;
+    float saved_fragments = 0.0f;
+};
+
+// what the application builds, the defaults are the solar system, benchmarks generate larger scenes
+struct scene_parameters {
+    // planets on generated orbits around the sun instead of the solar system, 0 keeps the solar system
+    std::size_t planets = 0;
+    // moons around each generated planet
+    unsigned moons_per_planet = 0;
+    std::size_t stars = 2000;
+    // width of the planet texture layers, they are half as high
+    std::size_t texture_width = 1024;
+    std::size_t asteroids = 10000;
+    // seed of the generated orbits
+    unsigned seed = 1;
+};
 
 // gpu representation of model
 class ApplicationSolar : public Application {
     public:
         // allocate and initialize objects
-        ApplicationSolar(std::string const& resource_path);
+        ApplicationSolar(std::string const& resource_path, scene_parameters const& scene = scene_parameters{});
         // free allocated objects
         ~ApplicationSolar();
 
@@ -23,31 +80,95 @@ class ApplicationSolar : public Application {
         void keyCallback(int key, int action, int mods);
         //handle delta mouse movement input
         void mouseCallback(double pos_x, double pos_y);
+        //handle mouse buttons
+        void mouseButtonCallback(int button, int action, int mods, double pos_x, double pos_y);
         //handle resizing
         void resizeCallback(unsigned width, unsigned height);
 
         // draw all objects
         void render() const;
         void renderSkybox() const;
-        void renderPlanets(std::list<std::shared_ptr<Node>> const& childrenList) const;
-        void renderOrbit(std::shared_ptr<Node> const& planet) const;
+        void renderPlanets() const;
+        void renderOrbit(glm::fmat4 const& orbit_matrix) const;
         void renderStars() const;
+        void renderAsteroids() const;
+        void renderCloud() const;
         void renderScreenQuad() const;
 
+        // planet hit by a ray through a pixel
+        struct pick_result {
+            bool hit = false;
+            std::string name;
+            std::string path;
+            // from the camera near plane to the planet surface
+            float distance = 0.0f;
+        };
+        // closest planet under the pixel (origin top left) in the last rendered frame
+        pick_result pickBody(glm::fvec2 const& pixel) const;
+        // read the planet id under the pixel from the id buffer, reported by a later frame
+        void requestGpuPick(glm::fvec2 const& pixel);
+        // print results of finished id buffer reads
+        void reportGpuPick() const;
+        // print culling counts and the other scene statistics of the last frame once per second
+        void reportCulling() const;
+
     protected:
         void initializeShaderPrograms();
         void initializeGeometry();
         void initializeSkybox();
         void initializePlanets();
+        // store the scene and collect its bodies
+        void initializeSceneGraph(Node const& root);
         void initializeTextures();
         void initializeFramebuffer(unsigned int width = 960u, unsigned int height = 840u);
         void initializeScreenQuad();
         void initializeStars();
         void initializeOrbits();
+        void initializePlanetDraws();
+        void initializeAsteroids();
+        // replace the belt with one of count asteroids
+        void generateBelt(std::size_t count);
+        // seed the n-body simulation with the current bodies on circular orbits around their parents
+        void initializePhysics();
+        // advance the n-body simulation in fixed steps up to the current time
+        void updatePhysics() const;
+        // replace the gpu gravity cloud with one of count particles
+        void generateCloud(std::size_t count);
+        // load the orbit table of the bodies from its file, or fit and save it if the file is missing or stale
+        void initializeOrbitTable();
+        void collectBodies(std::list<std::shared_ptr<Node>> const& childrenList);
 
-        glm::fmat4 transformPlanet(std::shared_ptr<Node> const& planet) const;
-        void loadPlanetTextures(std::list<std::shared_ptr<Node>> const& childrenList);
-        void loadNormalTextures(std::shared_ptr<Node> const& planet);
+        // model and orbit matrix of the body at the index in bodies_
+        glm::fmat4 transformPlanet(std::size_t index) const;
+        glm::fmat4 transformOrbit(std::size_t index) const;
+        // draw the sun with its own shader
+        void renderSun(glm::fmat4 const& model_matrix, icosphere::level const& lod, std::size_t index) const;
+        // bind the planet or impostor shader with its textures and light
+        void usePlanetProgram(std::string const& program) const;
+        // draw the planet commands in [first, last) of this frame with the planet or impostor shader
+        void renderPlanetBatch(std::string const& program, std::vector<draw_elements_command> const& commands,
+                               std::size_t first, std::size_t last) const;
+        // draw moons and small planets after the others with conditional rendering and issue new queries
+        void renderOccludees(std::vector<draw_elements_command> const& commands,
+                             std::vector<draw_elements_command> const& proxies,
+                             std::vector<std::size_t> const& bodies, std::vector<float> const& pixel_radii) const;
+        // enable the instanced planet record attributes on the bound vertex array
+        void enablePlanetRecords() const;
+        // let the planet attributes start at a record of a buffer with planet draw records
+        void pointPlanetRecords(std::size_t first_record, GLuint record_buffer) const;
+        // draw a single planet with the planet shader
+        void drawPlanetRecord(draw_elements_command const& command) const;
+        // window position of a sphere center and its distance to the camera, false if behind the camera
+        bool screenSphere(glm::fmat4 const& view_matrix, culling::sphere_batch const& spheres, std::size_t index,
+                          glm::fvec2& center, float& depth) const;
+        // pixels covered by a planet with this radius in pixels
+        float projectedArea(float pixel_radius) const;
+        // build or refit the hierarchy and mark the spheres inside the frustum
+        void cullHierarchy(bvh::tree& hierarchy, culling::sphere_batch const& spheres,
+                           culling::frustum const& view_frustum, std::vector<std::uint8_t>& visible) const;
+        // radius in pixels a planet with this model matrix covers on screen
+        float projectedRadius(glm::fmat4 const& model_matrix) const;
+        void loadPlanetTextures();
 
         // update uniform values
         void uploadUniforms();
@@ -58,12 +179,50 @@ class ApplicationSolar : public Application {
         // upload view matrix
         void uploadView();
 
-        // cpu representation of model
-        model_object planet_object;
-        model_object star_object;
-        model_object orbit_object;
-        model_object skybox_object;
-        model_object screenquad_object;
+        scene_parameters scene_;
+
+        // all meshes share the buffers and vertex array of the pool
+        geometry_pool geometryPool_;
+        mesh_range star_mesh;
+        mesh_range orbit_mesh;
+        mesh_range skybox_mesh;
+        mesh_range screenquad_mesh;
+        mesh_range impostor_mesh;
+
+        // detail levels of the planet sphere, offsets are relative to the pool
+        std::vector<icosphere::level> sphereLevels_;
+
+        // all planets with geometry (sun, planets and moons) 
+        std::vector<std::shared_ptr<Node>> bodies_;
+        // index of the origin of every body in bodies_, the size of bodies_ for the sun
+        std::vector<std::size_t> parentIndex_;
+        // index of the sun in bodies_, it has its own shader and is never an impostor or hidden
+        std::size_t sunIndex_;
+        // animated orbits of the bodies, in the order of bodies_
+        ephemeris::body_set bodyOrbits_;
+        //positions looked up in precomputed polynomials instead of evaluating the orbit chains, inside the table window
+        bool tableMode_;
+        chebyshev::table orbitTable_;
+
+        // instanced attributes and indirect commands for drawing all planets at once
+        GLuint planetRecordBuffer_;
+        GLuint planetCommandBuffer_;
+        // whether glMultiDrawElementsIndirect is available
+        bool multiDrawIndirect_;
+
+        // bounding spheres of planets and orbits, refilled every frame, in the order of bodies_
+        mutable culling::sphere_batch bodySpheres_;
+        mutable culling::sphere_batch orbitSpheres_;
+        mutable std::vector<std::uint8_t> bodyVisible_;
+        mutable std::vector<std::uint8_t> orbitVisible_;
+        mutable std::vector<std::uint32_t> cullIndices_;
+        // hierarchies over the bounding spheres for culling, the planet one also serves picking
+        mutable bvh::tree bodyHierarchy_;
+        mutable bvh::tree orbitHierarchy_;
+        // culling results of the last frame
+        mutable culling::cull_stats bodyCullStats_;
+        mutable culling::cull_stats orbitCullStats_;
+        mutable double lastCullReport_;
 
         GeometryNode SkyBox_;
 
@@ -78,6 +237,8 @@ class ApplicationSolar : public Application {
         glm::fmat4 m_view_transform;
         // camera projection matrix
         glm::fmat4 m_view_projection;
+        // size of the window in pixels
+        glm::uvec2 viewportSize_;
 
         PointLightNode sun_l;
 
@@ -100,6 +261,76 @@ class ApplicationSolar : public Application {
         texture_object FBTexture_;
         texture_object FBRenderbuffer_;
         texture_object framebuffer_;
+        //planet id + 1 per pixel, 0 where no planet is
+        texture_object FBIdTexture_;
+
+        //planet textures resized to one size, so every planet can be drawn with the same bindings
+        texture_object planetTextureArray_;
+        texture_object normalTextureArray_;
+        //layer of the first moon in the planet texture array, the gravity cloud is textured with it
+        int moonLayer_;
+
+        //write planet ids while rendering and pick with them
+        bool idBuffer_;
+        //reads ids without stalling, polled every frame
+        mutable pixel_readback idReadback_;
+
+        occlusion_mode occlusionMode_;
+        mutable occlusion_stats occlusionStats_;
+        //one query per planet in two sets, alternating every frame
+        std::array<std::vector<GLuint>, 2> occlusionQueries_;
+        mutable std::array<std::vector<std::uint8_t>, 2> queryIssued_;
+        mutable std::size_t occlusionFrame_;
+        //depth pyramid for the hierarchical z mode
+        mutable hiz_buffer hizBuffer_;
+
+        //planets sorted by distance and the skybox last, otherwise skybox first and scene order
+        bool frontToBack_;
+        //fragment shader invocations of the scene pass, only with pipeline statistics queries
+        mutable std::unique_ptr<query_ring> fragmentQueries_;
+        mutable GLuint64 fragmentInvocations_;
+
+        //planets with a smaller radius in pixels are ray cast on a camera facing quad
+        float impostorPixels_;
+        //which planets were impostors last frame, for the hysteresis
+        mutable std::vector<std::uint8_t> impostors_;
+        mutable std::size_t impostorCount_;
+
+        //procedural asteroid belt, propagated on the cpu and drawn instanced per rock variant
+        asteroid_belt::belt belt_;
+        //index into the belt sizes the b key cycles through
+        std::size_t beltSize_;
+        std::vector<mesh_range> rockMeshes_;
+        texture_object rockTextureArray_;
+        GLuint asteroidBuffer_;
+        //pool vertex array with only the asteroid attributes, so no other pass reads the belt buffer
+        GLuint asteroidVertexArray_;
+        mutable std::vector<asteroid_belt::instance> asteroidInstances_;
+        //cpu update and gpu draw time of the belt in the last frame
+        mutable std::unique_ptr<query_ring> asteroidTimer_;
+        mutable double asteroidUpdateMs_;
+        mutable GLuint64 asteroidDrawNs_;
+
+        //bodies move under mutual gravity instead of along the animated orbits, in the order of bodies_
+        bool physicsMode_;
+        mutable nbody::simulation gravity_;
+        //simulated time, behind the clock by less than a step
+        mutable double physicsClock_;
+
+        //dust under all pairs gravity, stepped by a compute shader that writes the draw records in place
+        mutable gravity_compute cloud_;
+        //pool vertex array whose planet record attributes read the particle records
+        GLuint cloudVertexArray_;
+        //index into the cloud sizes the c key cycles through
+        std::size_t cloudSize_;
+        mutable std::unique_ptr<query_ring> cloudTimer_;
+        mutable GLuint64 cloudStepNs_;
+
+        //gpu time of each render pass, shown as bars with the p key and written to files with the f key
+        mutable gpu_profiler passProfiler_;
+        bool showPassProfile_;
+        //scene statistics on stdout once per second, toggled with the l key, off so headless runs only print their results
+        bool reportScene_;
 
 };
 
@@ -1,5 +1,7 @@
 #include "application_solar.hpp"
 #include "window_handler.hpp"
+#include "frame_clock.hpp"
+#include "trace.hpp"
 
 #include "utils.hpp"
 #include "shader_loader.hpp"
@@ -16,18 +18,78 @@ using namespace gl;
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/matrix_inverse.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/constants.hpp>
 #include <memory>
 #include <glm/glm.hpp>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <random>
+#include <stdexcept>
+
+// planets smaller than this radius in pixels and all moons are tested for occlusion
+static float const small_body_pixels = 16.0f;
+// window pixels per texel of the cpu depth pyramid
+static float const hiz_texel_pixels = 4.0f;
+// the coarsest sphere is an icosahedron, this scale moves its faces onto the unit sphere so it encloses the planet
+static float const icosahedron_enclosing_scale = 1.2584f;
+// planets smaller than this radius in pixels are ray cast on a quad instead of drawn as mesh
+static float const default_impostor_pixels = 8.0f;
+// impostors turn back into meshes only when this much larger, so planets near the threshold do not flicker
+static float const impostor_hysteresis = 1.25f;
+// asteroid counts the belt cycles through, the first is used at startup
+static std::size_t const belt_sizes[] = {10000, 100000, 1000000, 2000000, 0};
+// rock meshes and textures of the belt
+static unsigned const rock_variants = 3;
+static unsigned const rock_layers = 4;
+// gravity of the sun in the n-body mode, keeps mercury, venus and earth close to their animated speed
+static double const sun_gravity = 25.0;
+// gravity of planets and moons per cubed radius, jupiter gets about a thousandth of the sun
+static double const body_gravity_density = 0.0145;
+// fixed time step of the n-body mode and the most steps per frame before it falls behind the clock
+static double const physics_step = 1.0 / 60.0;
+static unsigned const max_physics_steps = 8;
+// file of the precomputed orbit table in the working directory, the table covers the first hour
+static char const* const orbit_table_file = "orbit_table.bin";
+// particle counts of the gpu gravity cloud the c key cycles through, none at startup
+static std::size_t const cloud_sizes[] = {0, 1024, 4096, 16384};
+// the cloud is drawn with the planet shader straight from the records the compute shader writes
+static_assert(sizeof(gravity_compute::record) == sizeof(planet_draw_record), "cloud records must match planet draw records");
 
 // Constructor
-ApplicationSolar::ApplicationSolar(std::string const& resource_path):
+ApplicationSolar::ApplicationSolar(std::string const& resource_path, scene_parameters const& scene):
     Application{resource_path},
-    planet_object{},
-    star_object{},
-    orbit_object{},
-    skybox_object{},
+    scene_(scene),
+    geometryPool_{},
+    star_mesh{},
+    orbit_mesh{},
+    skybox_mesh{},
+    screenquad_mesh{},
+    impostor_mesh{},
+    sphereLevels_{},
+    bodies_{},
+    parentIndex_{},
+    sunIndex_{0},
+    bodyOrbits_{},
+    tableMode_{false},
+    orbitTable_{},
+    planetRecordBuffer_{0},
+    planetCommandBuffer_{0},
+    multiDrawIndirect_{false},
+    bodySpheres_{},
+    orbitSpheres_{},
+    bodyVisible_{},
+    orbitVisible_{},
+    cullIndices_{},
+    bodyHierarchy_{},
+    orbitHierarchy_{},
+    bodyCullStats_{},
+    orbitCullStats_{},
+    lastCullReport_{0.0},
     SkyBox_{"Skybox", m_resource_path + "textures/skybox_up.png", m_resource_path + "textures/skybox_down.png", m_resource_path + "textures/skybox_right.png",
             m_resource_path + "textures/skybox_left.png", m_resource_path + "textures/skybox_front.png", m_resource_path + "textures/skybox_back.png" },
     sceneGraph_{},
@@ -43,10 +105,49 @@ ApplicationSolar::ApplicationSolar(std::string const& resource_path):
     shaderMode_cell{false}, //Cell-shading
     m_view_transform{glm::translate(glm::fmat4{}, glm::fvec3{0.0f, 0.0f, 50.0f})}, //Camera
     m_view_projection{utils::calculate_projection_matrix(initial_aspect_ratio)},
+    viewportSize_{initial_resolution},
     FBTexture_{},
     FBRenderbuffer_{},
+    FBIdTexture_{},
     framebuffer_{},
-    screenquad_object{}
+    planetTextureArray_{},
+    normalTextureArray_{},
+    moonLayer_{0},
+    idBuffer_{false},
+    idReadback_{},
+    occlusionMode_{occlusion_mode::queries},
+    occlusionStats_{},
+    occlusionQueries_{},
+    queryIssued_{},
+    occlusionFrame_{0},
+    hizBuffer_{},
+    frontToBack_{true},
+    fragmentQueries_{},
+    fragmentInvocations_{0},
+    impostorPixels_{default_impostor_pixels},
+    impostors_{},
+    impostorCount_{0},
+    belt_{},
+    beltSize_{0},
+    rockMeshes_{},
+    rockTextureArray_{},
+    asteroidBuffer_{0},
+    asteroidVertexArray_{0},
+    asteroidInstances_{},
+    asteroidTimer_{},
+    asteroidUpdateMs_{0.0},
+    asteroidDrawNs_{0},
+    physicsMode_{false},
+    gravity_{},
+    physicsClock_{0.0},
+    cloud_{1.0f, 0.05f},
+    cloudVertexArray_{0},
+    cloudSize_{0},
+    cloudTimer_{},
+    cloudStepNs_{0},
+    passProfiler_{},
+    showPassProfile_{false},
+    reportScene_{false}
     {
         initializeGeometry();
         initializeSkybox();
@@ -55,6 +156,10 @@ ApplicationSolar::ApplicationSolar(std::string const& resource_path):
         initializeScreenQuad();
         initializeStars();
         initializeOrbits();
+        //all meshes are added, move them to the gpu
+        geometryPool_.upload();
+        initializePlanetDraws();
+        initializeAsteroids();
         initializeFramebuffer();
         initializeShaderPrograms();
 
@@ -62,15 +167,19 @@ ApplicationSolar::ApplicationSolar(std::string const& resource_path):
 
 // Destructor
 ApplicationSolar::~ApplicationSolar() {
-    glDeleteBuffers(1, &planet_object.vertex_BO);
-    glDeleteBuffers(1, &planet_object.element_BO);
-    glDeleteVertexArrays(1, &planet_object.vertex_AO);
+    //geometry buffers are freed by the pool
+    glDeleteBuffers(1, &planetRecordBuffer_);
+    glDeleteBuffers(1, &planetCommandBuffer_);
+    for(auto const& queries: occlusionQueries_){
+        glDeleteQueries(GLsizei(queries.size()), queries.data());
+    }
 
-    glDeleteBuffers(1, &orbit_object.vertex_BO);
-    glDeleteVertexArrays(1, &orbit_object.vertex_AO);
+    glDeleteBuffers(1, &asteroidBuffer_);
 
-    glDeleteBuffers(1, &star_object.vertex_BO);
-    glDeleteVertexArrays(1, &star_object.vertex_AO);
+    glDeleteTextures(1, &planetTextureArray_.handle);
+    glDeleteTextures(1, &rockTextureArray_.handle);
+    glDeleteTextures(1, &FBIdTexture_.handle);
+    glDeleteTextures(1, &normalTextureArray_.handle);
 }
 
 
@@ -78,31 +187,83 @@ ApplicationSolar::~ApplicationSolar() {
 // ---------------------- RENDER ------------------------
 void ApplicationSolar::render() const {
 
+    // ---- report planets picked on the gpu in earlier frames ----
+    reportGpuPick();
+
+    // ---- catch the n-body simulation up with the clock ----
+    updatePhysics();
+
+    // ---- gpu time of the passes, read back frames later ----
+    passProfiler_.begin_frame();
+
     // ---- Bind Framebuffer Object to render the scene to it ----
     glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_.handle);
     //clear Framebuffer Attachments before drawing them
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    // ----- upload and render skybox -----
-    renderSkybox();
+    //every mesh is stored in the pool, so the vertex array is bound only once
+    geometryPool_.bind();
 
-    // ------ render planets and orbits ------
-    // get the Scenegraph and start recursive traversal
-    auto solarSystem = sceneGraph_.getRoot().getChildrenList();
-    renderPlanets(solarSystem);
+    // ---- count shaded fragments of the scene, results arrive a few frames later ----
+    if(fragmentQueries_){
+        fragmentQueries_->poll(fragmentInvocations_);
+    }
+    bool counting = fragmentQueries_ && fragmentQueries_->begin();
+
+    if(frontToBack_){
+        // ------ render planets and orbits nearest first ------
+        renderPlanets();
+        renderAsteroids();
+        renderCloud();
+        // ------ render stars ------
+        passProfiler_.begin("stars");
+        renderStars();
+        passProfiler_.end("stars");
+        // ----- skybox only fills the pixels nothing else covered -----
+        passProfiler_.begin("skybox");
+        renderSkybox();
+        passProfiler_.end("skybox");
+    }else{
+        // ----- upload and render skybox -----
+        passProfiler_.begin("skybox");
+        renderSkybox();
+        passProfiler_.end("skybox");
+        // ------ render planets and orbits ------
+        renderPlanets();
+        renderAsteroids();
+        renderCloud();
+        // ------ render stars ------
+        passProfiler_.begin("stars");
+        renderStars();
+        passProfiler_.end("stars");
+    }
 
-    // ------ render stars ------
-    renderStars();
+    if(counting){
+        fragmentQueries_->end();
+    }
+    if(reportScene_){
+        reportCulling();
+    }
 
     // ---- Apply Framebuffer Color Texture to Screen Quad and render it to screen ----
+    passProfiler_.begin("screenquad");
     renderScreenQuad();
+    passProfiler_.end("screenquad");
+    passProfiler_.end_frame();
 
+    // bars of the pass times on top of the finished frame, not part of the measured frame
+    if(showPassProfile_){
+        passProfiler_.draw_overlay(viewportSize_);
+    }
 }
 
 void ApplicationSolar::renderSkybox() const{
+    TRACE_ZONE("renderSkybox");
 
     //disable writing to the depth buffers (to draw transparent objects like skybox)
     glDepthMask(GL_FALSE);
+    //skybox lies on the far plane, it passes only where the depth buffer is still cleared
+    glDepthFunc(GL_LEQUAL);
 
     glUseProgram(m_shaders.at("skybox").handle);
     glActiveTexture(GL_TEXTURE0);
@@ -116,136 +277,663 @@ void ApplicationSolar::renderSkybox() const{
     glUniformMatrix4fv(m_shaders.at("skybox").u_locs.at("ModelMatrix"),
                 1, GL_FALSE, glm::value_ptr(model_matrix));
     
-    glBindVertexArray(skybox_object.vertex_AO);
-    glDrawElements(skybox_object.draw_mode, skybox_object.num_elements, model::INDEX.type, NULL);
+    geometryPool_.draw(skybox_mesh);
 
     //enable writing to depth buffer again so the non-transparent objects (planets) can be rendered
     glDepthMask(GL_TRUE);
+    glDepthFunc(GL_LESS);
 }
 
-void ApplicationSolar::renderPlanets(std::list<std::shared_ptr<Node>> const& childrenList) const{
+void ApplicationSolar::renderPlanets() const{
+    TRACE_ZONE("renderPlanets");
+
+    // ---- culling: bounding spheres of all planets and of their orbits ----
+    std::vector<glm::fmat4> model_matrices{};
+    std::vector<glm::fmat4> orbit_matrices{};
+    model_matrices.reserve(bodies_.size());
+    orbit_matrices.reserve(bodies_.size());
+    bodySpheres_.clear();
+    orbitSpheres_.clear();
+
+    for(std::size_t i = 0; i < bodies_.size(); ++i){
+        //compute tranformations for each planet
+        model_matrices.push_back(transformPlanet(i));
+        //planets are unit spheres, the scale of the model matrix is the radius
+        bodySpheres_.push_back(glm::fvec3{model_matrices.back()[3]}, glm::length(glm::fvec3{model_matrices.back()[0]}));
+
+        //orbits are unit circles around the parent, the scale is the distance to it
+        orbit_matrices.push_back(transformOrbit(i));
+        orbitSpheres_.push_back(glm::fvec3{orbit_matrices.back()[3]}, glm::length(glm::fvec3{orbit_matrices.back()[0]}));
+    }
 
-    // recursive traversal through SceneGraph
-    // visit each child in children_ and check whether they themselves have children which have to be visited
-    for(auto const& planet: childrenList){
+    // test against the frustum in world space
+    culling::frustum view_frustum = culling::extract_frustum(m_view_projection * glm::inverse(m_view_transform));
+    cullHierarchy(bodyHierarchy_, bodySpheres_, view_frustum, bodyVisible_);
+    cullHierarchy(orbitHierarchy_, orbitSpheres_, view_frustum, orbitVisible_);
+
+    // per planet data and draw commands for all planets except the sun
+    std::vector<planet_draw_record> records{};
+    std::vector<draw_elements_command> commands{};
+    // small planets drawn after the others, depending on occlusion queries
+    std::vector<draw_elements_command> occludee_commands{};
+    std::vector<draw_elements_command> proxy_commands{};
+    std::vector<std::size_t> occludee_bodies{};
+    bodyCullStats_ = culling::cull_stats{};
+    orbitCullStats_ = culling::cull_stats{};
+
+    //render the orbit for each planet, an orbit can be in view while its planet is not
+    passProfiler_.begin("orbits");
+    for(std::size_t i = 0; i < bodies_.size(); ++i){
+        if(orbitVisible_[i]){
+            renderOrbit(orbit_matrices[i]);
+            ++orbitCullStats_.visible;
+        }else{
+            ++orbitCullStats_.culled;
+        }
+    }
+    passProfiler_.end("orbits");
+    passProfiler_.begin("planets");
+
+    //planets additionally write their id for gpu picking, after orbits so those leave no id behind
+    GLenum draw_buffers[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    if(idBuffer_){
+        glDrawBuffers(2, draw_buffers);
+        GLuint no_planet[4] = {0, 0, 0, 0};
+        glClearBufferuiv(GL_COLOR, 1, no_planet);
+    }
 
-        auto childPlanets = planet->getChildrenList();
+    // ---- occlusion: small planets and moons are tested against the planets in front of them ----
+    glm::fmat4 view_matrix = glm::inverse(m_view_transform);
+    std::vector<float> pixel_radii(bodies_.size(), 0.0f);
+    std::vector<std::uint8_t> occludees(bodies_.size(), 0);
+    occlusionStats_ = occlusion_stats{};
 
-        if(childPlanets.size() > 0){   
-            renderPlanets(childPlanets); //recursive call
+    for(std::size_t i = 0; i < bodies_.size(); ++i){
+        if(!bodyVisible_[i]){
+            continue;
+        }
+        pixel_radii[i] = projectedRadius(model_matrices[i]);
+        occlusionStats_.total_fragments += projectedArea(pixel_radii[i]);
+        // small planets are ray cast on a quad, the sun keeps its mesh
+        float impostor_pixels = impostors_[i] ? impostorPixels_ * impostor_hysteresis : impostorPixels_;
+        impostors_[i] = i != sunIndex_ && pixel_radii[i] < impostor_pixels;
+        // the sun is never hidden, impostors cost about as much as a query proxy so they are not queried
+        occludees[i] = occlusionMode_ != occlusion_mode::off && i != sunIndex_ &&
+                       (bodies_[i]->getDepth() == 4 || pixel_radii[i] < small_body_pixels) &&
+                       !(impostors_[i] && occlusionMode_ == occlusion_mode::queries);
+    }
+
+    if(occlusionMode_ == occlusion_mode::hierarchical_z){
+        // large planets are the occluders, drawn as discs at the depth of their center
+        hizBuffer_.clear();
+        for(std::size_t i = 0; i < bodies_.size(); ++i){
+            glm::fvec2 center{};
+            float depth = 0.0f;
+            if(bodyVisible_[i] && !occludees[i] && screenSphere(view_matrix, bodySpheres_, i, center, depth)){
+                hizBuffer_.add_disc(center / hiz_texel_pixels, pixel_radii[i] / hiz_texel_pixels, depth);
+            }
         }
+        hizBuffer_.build();
+    }
 
-        //ignoring the holding Nodes
-        if(planet->getDepth() == 2 || planet->getDepth() == 4){
+    // front to back, so planets hidden by nearer ones fail the depth test before shading
+    std::vector<std::size_t> draw_order{};
+    std::vector<float> nearest_depths(bodies_.size(), 0.0f);
+    for(std::size_t i = 0; i < bodies_.size(); ++i){
+        glm::fvec4 view_center = view_matrix * glm::fvec4{bodySpheres_.x[i], bodySpheres_.y[i], bodySpheres_.z[i], 1.0f};
+        nearest_depths[i] = -view_center.z - bodySpheres_.radius[i];
+        draw_order.push_back(i);
+    }
+    if(frontToBack_){
+        std::stable_sort(draw_order.begin(), draw_order.end(),
+                         [&nearest_depths](std::size_t a, std::size_t b){ return nearest_depths[a] < nearest_depths[b]; });
+    }
 
-            //compute tranformations for each planet
-            glm::fmat4 model_matrix = transformPlanet(planet);
+    // the sun has its own shader, it is drawn between the batched planets in front of and behind it
+    bool sun_visible = false;
+    std::size_t sun_split = 0;
+    icosphere::level sun_lod{};
+    std::vector<draw_elements_command> impostor_commands{};
 
-            //extra matrix for normal transformation to keep them orthogonal to surface
-            glm::fmat4 normal_matrix = glm::inverseTranspose(glm::inverse(m_view_transform)* model_matrix);
+    for(std::size_t i: draw_order){
 
-            if(planet->getName() == "sun"){
-                // bind shader to upload uniforms
-                glUseProgram(m_shaders.at("sun").handle);
-                //give matrices to shaders
-                glUniformMatrix4fv(m_shaders.at("sun").u_locs.at("ModelMatrix"),
-                            1, GL_FALSE, glm::value_ptr(model_matrix));
+        auto const& planet = bodies_[i];
 
-                glUniformMatrix4fv(m_shaders.at("sun").u_locs.at("NormalMatrix"),
-                            1, GL_FALSE, glm::value_ptr(normal_matrix));
+        //skip planets outside of the view
+        if(!bodyVisible_[i]){
+            ++bodyCullStats_.culled;
+            continue;
+        }
+        ++bodyCullStats_.visible;
+
+        glm::fmat4 const& model_matrix = model_matrices[i];
+
+        // skip small planets completely behind the occluders
+        if(occludees[i] && occlusionMode_ == occlusion_mode::hierarchical_z){
+            ++occlusionStats_.tested;
+            glm::fvec2 center{};
+            float depth = 0.0f;
+            float radius = bodySpheres_.radius[i];
+            if(screenSphere(view_matrix, bodySpheres_, i, center, depth) && depth > radius){
+                glm::fvec2 extent{pixel_radii[i]};
+                if(hizBuffer_.occluded((center - extent) / hiz_texel_pixels, (center + extent) / hiz_texel_pixels, depth - radius)){
+                    ++occlusionStats_.occluded;
+                    occlusionStats_.saved_fragments += projectedArea(pixel_radii[i]);
+                    continue;
+                }
+            }
+        }
 
-            }else{
-                 // bind shader to upload uniforms
-                glUseProgram(m_shaders.at("planet").handle);
-                //give matrices to shaders
-                glUniformMatrix4fv(m_shaders.at("planet").u_locs.at("ModelMatrix"),
-                            1, GL_FALSE, glm::value_ptr(model_matrix));
+        // choose sphere detail from the area the planet covers on screen
+        icosphere::level const& lod = sphereLevels_[icosphere::select_level(sphereLevels_, pixel_radii[i])];
 
-                glUniformMatrix4fv(m_shaders.at("planet").u_locs.at("NormalMatrix"),
-                            1, GL_FALSE, glm::value_ptr(normal_matrix));
+        if(i == sunIndex_){
+            sun_visible = true;
+            sun_split = commands.size();
+            sun_lod = lod;
+            continue;
+        }
 
-                // glUniform3f(m_shaders.at("planet").u_locs.at("PlanetColor"), planet->getColor().x, planet->getColor().y, planet->getColor().z);
-            }
+        // remember everything the planet shader needs, planets are drawn together afterwards
+        planet_draw_record record{};
+        record.model_matrix = model_matrix;
+        record.draw_info = glm::fvec4{float(planet->getTextureLayer()), float(planet->getNormalTextureLayer()),
+                                      planet->hasNormapMapping() ? 1.0f : 0.0f, float(i + 1)};
+        records.push_back(record);
+
+        // instance index selects the record of this planet
+        draw_elements_command command{GLuint(lod.num_indices), 1, lod.first_index, lod.base_vertex, GLuint(records.size() - 1)};
+
+        if(impostors_[i]){
+            impostor_commands.push_back(geometry_pool::command(impostor_mesh, GLuint(records.size() - 1)));
+        }else if(occludees[i] && occlusionMode_ == occlusion_mode::queries){
+            // drawn one by one after the occluders, each depending on its query
+            occludee_commands.push_back(command);
+            occludee_bodies.push_back(i);
+
+            // bounding proxy for the next query, the coarsest sphere scaled to enclose the planet
+            record.model_matrix = glm::scale(model_matrix, glm::fvec3{icosahedron_enclosing_scale});
+            records.push_back(record);
+            icosphere::level const& proxy = sphereLevels_.front();
+            proxy_commands.push_back(draw_elements_command{GLuint(proxy.num_indices), 1, proxy.first_index, proxy.base_vertex,
+                                                          GLuint(records.size() - 1)});
+        }else{
+            commands.push_back(command);
+        }
+    }
 
-            //upload textures to shader:
-            //activate texture unit
-            glActiveTexture(GL_TEXTURE0);
-            //bind for accessing
-            glBindTexture(GL_TEXTURE_2D, planet->getTextureObject().handle);
-
-            if(planet->getName() == "sun"){
-                //upload texture unit data to shader
-                glUniform1i(m_shaders.at("sun").u_locs.at("SunTexture"), 0); //0 because 0 is the texture slot we defined in glActiveTexture for this
-            }else{
-                //upload texture unit data to shader
-                glUniform1i(m_shaders.at("planet").u_locs.at("PlanetTexture"), 0); //0 because 0 is the texture slot we defined in glActiveTexture for this
-
-                //activate normal-mapping texture unit
-                glActiveTexture(GL_TEXTURE1);
-                //bind for accessing
-                glBindTexture(GL_TEXTURE_2D, planet->getNormalTextureObject().handle);
-                //upload normal map texture unit data to shader
-                glUniform1i(m_shaders.at("planet").u_locs.at("NormalTexture"), 1); //1 because 1 is the texture slot we defined in glActiveTexture for this
-                //upload if planet has a normal map or not
-                glUniform1i(m_shaders.at("planet").u_locs.at("HasNormalMap"), planet->hasNormapMapping()); 
-
-                //upload light units to shader (TO DO:create separate function for this!)
-                glUniform3f(m_shaders.at("planet").u_locs.at("LightColor"), sun_l.getLightColor().x, sun_l.getLightColor().y, sun_l.getLightColor().z);
-                glUniform1f(m_shaders.at("planet").u_locs.at("LightIntensity"), sun_l.getLightIntensity());
+    // impostors are drawn with their own shader after all meshes
+    std::size_t first_impostor = commands.size();
+    commands.insert(commands.end(), impostor_commands.begin(), impostor_commands.end());
+    impostorCount_ = impostor_commands.size();
+
+    if(!records.empty()){
+        // replace last frames records, instanced attributes of the pool vertex array read from this buffer
+        glBindBuffer(GL_ARRAY_BUFFER, planetRecordBuffer_);
+        glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(sizeof(planet_draw_record) * records.size()), records.data(), GL_STREAM_DRAW);
+        if(multiDrawIndirect_){
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, planetCommandBuffer_);
+            glBufferData(GL_DRAW_INDIRECT_BUFFER, GLsizeiptr(sizeof(draw_elements_command) * commands.size()), commands.data(), GL_STREAM_DRAW);
+        }
+    }
+
+    renderPlanetBatch("planet", commands, 0, sun_split);
+    if(sun_visible){
+        renderSun(model_matrices[sunIndex_], sun_lod, sunIndex_);
+    }
+    renderPlanetBatch("planet", commands, sun_split, first_impostor);
+    renderPlanetBatch("impostor", commands, first_impostor, commands.size());
+    if(!occludee_commands.empty()){
+        renderOccludees(occludee_commands, proxy_commands, occludee_bodies, pixel_radii);
+    }else{
+        //no proxy is tested this frame, results of older frames must not decide over the next one
+        for(auto& issued: queryIssued_){
+            std::fill(issued.begin(), issued.end(), 0);
+        }
+    }
+
+    //stars and skybox only write color
+    glDrawBuffers(1, draw_buffers);
+    passProfiler_.end("planets");
+    TRACE_COUNTER("visible planets", bodyCullStats_.visible);
+    TRACE_COUNTER("impostors", impostorCount_);
+}
+
+void ApplicationSolar::renderAsteroids() const{
+    TRACE_ZONE("renderAsteroids");
+
+    if(belt_.size() == 0){
+        return;
+    }
+    passProfiler_.begin("asteroids");
+
+    // ---- cpu: move every asteroid along its orbit, timed on the wall clock since the animation clock may be fixed ----
+    std::chrono::steady_clock::time_point update_start = std::chrono::steady_clock::now();
+    belt_.propagate(frame_clock::now(), asteroidInstances_);
+    TRACE_COUNTER("asteroids", belt_.size());
+    asteroidUpdateMs_ = utils::milliseconds(std::chrono::steady_clock::now() - update_start);
+
+    // ---- gpu: upload positions and draw each rock variant instanced, timed without waiting ----
+    if(asteroidTimer_){
+        asteroidTimer_->poll(asteroidDrawNs_);
+    }
+    bool timing = asteroidTimer_ && asteroidTimer_->begin();
+
+    glBindVertexArray(asteroidVertexArray_);
+    glBindBuffer(GL_ARRAY_BUFFER, asteroidBuffer_);
+    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(sizeof(asteroid_belt::instance) * asteroidInstances_.size()),
+                 asteroidInstances_.data(), GL_STREAM_DRAW);
+
+    glUseProgram(m_shaders.at("asteroid").handle);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, rockTextureArray_.handle);
+    glUniform1i(m_shaders.at("asteroid").u_locs.at("RockTextures"), 0);
+    glUniform1f(m_shaders.at("asteroid").u_locs.at("MaxSize"), belt_.params().max_size);
+    glUniform1f(m_shaders.at("asteroid").u_locs.at("Time"), float(frame_clock::now()));
+    glUniform3f(m_shaders.at("asteroid").u_locs.at("LightColor"), sun_l.getLightColor().x, sun_l.getLightColor().y, sun_l.getLightColor().z);
+    glUniform1f(m_shaders.at("asteroid").u_locs.at("LightIntensity"), sun_l.getLightIntensity());
+
+    for(unsigned variant = 0; variant < rockMeshes_.size(); ++variant){
+        std::size_t count = belt_.variant_count(variant);
+        if(count == 0){
+            continue;
+        }
+        // instances of a variant are contiguous, the attributes start at its first asteroid
+        uintptr_t offset = uintptr_t(belt_.variant_first(variant)) * sizeof(asteroid_belt::instance);
+        glVertexAttribPointer(10, 3, GL_FLOAT, GL_FALSE, sizeof(asteroid_belt::instance), (GLvoid*)offset);
+        glVertexAttribIPointer(11, 1, GL_UNSIGNED_INT, sizeof(asteroid_belt::instance),
+                               (GLvoid*)(offset + offsetof(asteroid_belt::instance, packed)));
+
+        mesh_range const& rock = rockMeshes_[variant];
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, rock.num_elements, model::INDEX.type,
+                                          (GLvoid*)(uintptr_t(rock.first_index) * model::INDEX.size), GLsizei(count), rock.base_vertex);
+    }
+
+    geometryPool_.bind();
+
+    if(timing){
+        asteroidTimer_->end();
+    }
+    passProfiler_.end("asteroids");
+}
+
+void ApplicationSolar::renderSun(glm::fmat4 const& model_matrix, icosphere::level const& lod, std::size_t index) const{
+
+    //extra matrix for normal transformation to keep them orthogonal to surface
+    glm::fmat4 normal_matrix = glm::inverseTranspose(glm::inverse(m_view_transform) * model_matrix);
+
+    // bind shader to upload uniforms
+    glUseProgram(m_shaders.at("sun").handle);
+    //give matrices to shaders
+    glUniformMatrix4fv(m_shaders.at("sun").u_locs.at("ModelMatrix"),
+                1, GL_FALSE, glm::value_ptr(model_matrix));
+
+    glUniformMatrix4fv(m_shaders.at("sun").u_locs.at("NormalMatrix"),
+                1, GL_FALSE, glm::value_ptr(normal_matrix));
+
+    //upload textures to shader:
+    //activate texture unit
+    glActiveTexture(GL_TEXTURE0);
+    //bind for accessing
+    glBindTexture(GL_TEXTURE_2D, bodies_[index]->getTextureObject().handle);
+    //upload texture unit data to shader
+    glUniform1i(m_shaders.at("sun").u_locs.at("SunTexture"), 0); //0 because 0 is the texture slot we defined in glActiveTexture for this
+    //id for gpu picking, 0 means no planet
+    glUniform1ui(m_shaders.at("sun").u_locs.at("BodyId"), GLuint(index + 1));
+
+    // draw the sun on its own, it has a different shader
+    glDrawElementsBaseVertex(GL_TRIANGLES, lod.num_indices, model::INDEX.type,
+                             (GLvoid*)(uintptr_t(lod.first_index) * model::INDEX.size), lod.base_vertex);
+}
+
+void ApplicationSolar::renderCloud() const{
+    TRACE_ZONE("renderCloud");
+
+    if(cloud_.size() == 0){
+        return;
+    }
+    passProfiler_.begin("cloud");
+
+    // ---- gpu: one fixed step, the shader leaves the model matrices in the record buffer ----
+    if(cloudTimer_){
+        cloudTimer_->poll(cloudStepNs_);
+    }
+    bool timing = cloudTimer_ && cloudTimer_->begin();
+    cloud_.step(m_shaders.at("gravity"), float(physics_step));
+    if(timing){
+        cloudTimer_->end();
+    }
+
+    // ---- draw every particle as the coarsest sphere with the planet shader, reading the records in place ----
+    usePlanetProgram("planet");
+    glBindVertexArray(cloudVertexArray_);
+    pointPlanetRecords(0, cloud_.record_buffer());
+    icosphere::level const& lod = sphereLevels_.front();
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, lod.num_indices, model::INDEX.type,
+                                      (GLvoid*)(uintptr_t(lod.first_index) * model::INDEX.size), GLsizei(cloud_.size()), lod.base_vertex);
+    geometryPool_.bind();
+    passProfiler_.end("cloud");
+}
+
+void ApplicationSolar::usePlanetProgram(std::string const& program) const{
+
+    // bind shader to upload uniforms
+    glUseProgram(m_shaders.at(program).handle);
+
+    //all planet textures are layers of two array textures
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, planetTextureArray_.handle);
+    glUniform1i(m_shaders.at(program).u_locs.at("PlanetTextures"), 0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, normalTextureArray_.handle);
+    glUniform1i(m_shaders.at(program).u_locs.at("NormalTextures"), 1);
+
+    //upload light units to shader (TO DO:create separate function for this!)
+    glUniform3f(m_shaders.at(program).u_locs.at("LightColor"), sun_l.getLightColor().x, sun_l.getLightColor().y, sun_l.getLightColor().z);
+    glUniform1f(m_shaders.at(program).u_locs.at("LightIntensity"), sun_l.getLightIntensity());
+}
+
+void ApplicationSolar::renderPlanetBatch(std::string const& program, std::vector<draw_elements_command> const& commands,
+                                         std::size_t first, std::size_t last) const{
+
+    if(first >= last){
+        return;
+    }
+    usePlanetProgram(program);
+
+    if(multiDrawIndirect_){
+        // one call draws all planets of the range, each with its own detail level
+        pointPlanetRecords(0, planetRecordBuffer_);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, planetCommandBuffer_);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, model::INDEX.type, (GLvoid*)(first * sizeof(draw_elements_command)),
+                                    GLsizei(last - first), 0);
+    }else{
+        // without base instances the record attributes are moved to the planet before each draw
+        for(std::size_t c = first; c < last; ++c){
+            drawPlanetRecord(commands[c]);
+        }
+    }
+}
+
+void ApplicationSolar::renderOccludees(std::vector<draw_elements_command> const& commands,
+                                       std::vector<draw_elements_command> const& proxies,
+                                       std::vector<std::size_t> const& bodies, std::vector<float> const& pixel_radii) const{
+
+    // queries alternate between two sets, the set of the last frame is finished or almost finished
+    std::vector<GLuint> const& current_queries = occlusionQueries_[occlusionFrame_ % 2];
+    std::vector<GLuint> const& previous_queries = occlusionQueries_[(occlusionFrame_ + 1) % 2];
+    std::vector<std::uint8_t>& current_issued = queryIssued_[occlusionFrame_ % 2];
+    std::vector<std::uint8_t> const& previous_issued = queryIssued_[(occlusionFrame_ + 1) % 2];
+    ++occlusionFrame_;
+    std::fill(current_issued.begin(), current_issued.end(), 0);
+
+    usePlanetProgram("planet");
+    for(std::size_t c = 0; c < commands.size(); ++c){
+        std::size_t body = bodies[c];
+        if(!previous_issued[body]){
+            // no proxy was tested last frame, so the planet is drawn
+            drawPlanetRecord(commands[c]);
+            continue;
+        }
+
+        ++occlusionStats_.tested;
+        // only for reporting, results which are not available yet are not waited for
+        GLuint available = 0;
+        glGetQueryObjectuiv(previous_queries[body], GL_QUERY_RESULT_AVAILABLE, &available);
+        if(available){
+            GLuint samples = 0;
+            glGetQueryObjectuiv(previous_queries[body], GL_QUERY_RESULT, &samples);
+            if(samples == 0){
+                ++occlusionStats_.occluded;
+                occlusionStats_.saved_fragments += projectedArea(pixel_radii[body]);
             }
+        }
+
+        // gpu skips the draw if no sample of last frames proxy passed, without waiting for the result
+        glBeginConditionalRender(previous_queries[body], GL_QUERY_NO_WAIT);
+        drawPlanetRecord(commands[c]);
+        glEndConditionalRender();
+    }
+
+    // test the proxies against the finished depth buffer for the next frame
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+    for(std::size_t c = 0; c < proxies.size(); ++c){
+        std::size_t body = bodies[c];
+        glBeginQuery(GL_SAMPLES_PASSED, current_queries[body]);
+        drawPlanetRecord(proxies[c]);
+        glEndQuery(GL_SAMPLES_PASSED);
+        current_issued[body] = 1;
+    }
+    glDepthMask(GL_TRUE);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+void ApplicationSolar::pointPlanetRecords(std::size_t first_record, GLuint record_buffer) const{
+
+    uintptr_t record_offset = uintptr_t(first_record) * sizeof(planet_draw_record);
+    glBindBuffer(GL_ARRAY_BUFFER, record_buffer);
+    for(GLuint column = 0; column < 4; ++column){
+        glVertexAttribPointer(5 + column, 4, GL_FLOAT, GL_FALSE, sizeof(planet_draw_record),
+                              (GLvoid*)(record_offset + sizeof(glm::fvec4) * column));
+    }
+    glVertexAttribPointer(9, 4, GL_FLOAT, GL_FALSE, sizeof(planet_draw_record),
+                          (GLvoid*)(record_offset + offsetof(planet_draw_record, draw_info)));
+}
+
+void ApplicationSolar::drawPlanetRecord(draw_elements_command const& command) const{
+
+    // attributes start at the record, so instance 0 reads it
+    pointPlanetRecords(command.base_instance, planetRecordBuffer_);
+    glDrawElementsBaseVertex(GL_TRIANGLES, GLsizei(command.count), model::INDEX.type,
+                             (GLvoid*)(uintptr_t(command.first_index) * model::INDEX.size), command.base_vertex);
+}
+
+bool ApplicationSolar::screenSphere(glm::fmat4 const& view_matrix, culling::sphere_batch const& spheres, std::size_t index,
+                                    glm::fvec2& center, float& depth) const{
+
+    glm::fvec4 view_center = view_matrix * glm::fvec4{spheres.x[index], spheres.y[index], spheres.z[index], 1.0f};
+    depth = -view_center.z;
+    glm::fvec4 clip_center = m_view_projection * view_center;
+    // behind the camera there is no meaningful position on screen
+    if(clip_center.w <= 0.0f){
+        return false;
+    }
+    glm::fvec2 ndc = glm::fvec2{clip_center} / clip_center.w;
+    center = (ndc * 0.5f + 0.5f) * glm::fvec2{viewportSize_};
+    return true;
+}
+
+float ApplicationSolar::projectedArea(float pixel_radius) const{
+
+    // a disc, but never more than the whole window
+    float area = glm::pi<float>() * pixel_radius * pixel_radius;
+    return std::min(area, float(viewportSize_.x) * float(viewportSize_.y));
+}
+
+void ApplicationSolar::cullHierarchy(bvh::tree& hierarchy, culling::sphere_batch const& spheres,
+                                     culling::frustum const& view_frustum, std::vector<std::uint8_t>& visible) const{
+
+    // planets move along their orbits, so the hierarchy is only refitted after the first frame
+    if(hierarchy.size() != spheres.size()){
+        hierarchy.build(spheres);
+    }else{
+        hierarchy.refit(spheres);
+    }
+
+    hierarchy.frustum_query(view_frustum, spheres, cullIndices_);
+    visible.assign(spheres.size(), 0);
+    for(auto index: cullIndices_){
+        visible[index] = 1;
+    }
+}
+
+void ApplicationSolar::requestGpuPick(glm::fvec2 const& pixel){
+
+    // integer pixel, framebuffer rows start at the bottom
+    GLint x = GLint(pixel.x);
+    GLint y = GLint(viewportSize_.y) - 1 - GLint(pixel.y);
+    if(x < 0 || y < 0 || x >= GLint(viewportSize_.x) || y >= GLint(viewportSize_.y)){
+        return;
+    }
+
+    // framebuffer still holds the ids of the last frame
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer_.handle);
+    if(!idReadback_.request(GL_COLOR_ATTACHMENT1, x, y)){
+        std::cout << "GPU picking busy, click ignored" << std::endl;
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
+
+void ApplicationSolar::reportGpuPick() const{
+    TRACE_ZONE("reportGpuPick");
 
-            // bind the VAO to draw
-            glBindVertexArray(planet_object.vertex_AO);
-            // draw bound vertex array using bound shader
-            glDrawElements(planet_object.draw_mode, planet_object.num_elements, model::INDEX.type, NULL);
+    GLuint id = 0;
+    // the result arrives one or two frames after the request
+    while(idReadback_.poll(id)){
+        if(id > 0 && id <= bodies_.size()){
+            std::cout << "GPU picked " << bodies_[id - 1]->getName() << " (" << bodies_[id - 1]->getPath() << ")" << std::endl;
+        }else{
+            std::cout << "GPU picked nothing" << std::endl;
         }
-        //std::cout << *planet;
     }
 }
 
-// transform planets
-glm::fmat4 ApplicationSolar::transformPlanet(std::shared_ptr<Node> const& planet) const{
+ApplicationSolar::pick_result ApplicationSolar::pickBody(glm::fvec2 const& pixel) const{
 
-    //render the orbit for each planet
-    renderOrbit(planet);
-    
-    //compute tranformations for each planet
-    glm::fmat4 model_matrix = planet->getWorldTransform();
+    pick_result result{};
+    // spheres and hierarchy hold the planet positions of the last rendered frame
+    picking::ray ray = picking::screen_ray(pixel, viewportSize_, m_view_projection, glm::inverse(m_view_transform));
+    bvh::hit hit{};
+    if(!bodyHierarchy_.ray_query(ray.origin, ray.direction, bodySpheres_, hit)){
+        return result;
+    }
 
-    if(planet->getDepth() == 4){
-        //moons need extra rotation around their parent planet so we need to shift them to the parent first before
-        //adding it's own rotation
-        glm::fmat4 parent_matrix = planet->getOrigin()->getLocalTransform();
-        model_matrix = glm::rotate(parent_matrix, float(glfwGetTime())*(planet->getOrigin()->getSpeed()), glm::fvec3{0.0f, 1.0f, 0.0f});
-        model_matrix = glm::translate(model_matrix, -1.0 * planet->getOrigin()->getDistanceOrigin());
+    result.hit = true;
+    result.name = bodies_[hit.index]->getName();
+    result.path = bodies_[hit.index]->getPath();
+    result.distance = hit.distance;
+    return result;
+}
+
+void ApplicationSolar::reportCulling() const{
+
+    double current_time = frame_clock::now();
+    if(current_time - lastCullReport_ < 1.0){
+        return;
     }
+    lastCullReport_ = current_time;
 
-    //rotation around parent
-    model_matrix = glm::rotate(model_matrix* planet->getLocalTransform(),float(glfwGetTime())*(planet->getSpeed()),glm::fvec3{0.0f, 1.0f, 0.0f});
-    model_matrix = glm::translate(model_matrix, -1.0f * planet->getDistanceOrigin());
-    
-    //selfrotation
-    model_matrix = glm::rotate(model_matrix, float(glfwGetTime() * planet->getSelfRotation()),glm::fvec3{0.0f, 1.0f, 0.0f});
-    
-    //scale planet
-    float radius = planet->getRadius();
-    model_matrix = glm::scale(model_matrix, glm::fvec3{radius, radius, radius});
+    std::cout << "Culling: " << bodyCullStats_.visible << " planets visible, " << bodyCullStats_.culled << " culled, "
+              << orbitCullStats_.visible << " orbits visible, " << orbitCullStats_.culled << " culled" << std::endl;
 
-    return model_matrix;
+    if(occlusionMode_ != occlusion_mode::off){
+        // fragments are estimated from the projected planet discs
+        float saved = occlusionStats_.total_fragments > 0.0f ? occlusionStats_.saved_fragments / occlusionStats_.total_fragments : 0.0f;
+        std::cout << "Occlusion (" << (occlusionMode_ == occlusion_mode::queries ? "queries" : "hierarchical z") << "): "
+                  << occlusionStats_.occluded << " of " << occlusionStats_.tested << " tested planets hidden, "
+                  << 100.0f * saved << "% of planet fragments saved" << std::endl;
+    }
 
+    std::cout << "Asteroids: " << belt_.size() << ", update " << asteroidUpdateMs_ << " ms cpu, draw ";
+    if(asteroidTimer_){
+        std::cout << double(asteroidDrawNs_) / 1000000.0 << " ms gpu" << std::endl;
+    }else{
+        std::cout << "gpu time not available" << std::endl;
+    }
+
+    if(cloud_.size() > 0){
+        std::cout << "Gravity cloud: " << cloud_.size() << " particles, step ";
+        if(cloudTimer_){
+            std::cout << double(cloudStepNs_) / 1000000.0 << " ms gpu" << std::endl;
+        }else{
+            std::cout << "gpu time not available" << std::endl;
+        }
+    }
+
+    if(tableMode_){
+        float max_error = 0.0f;
+        for(std::size_t i = 0; i < orbitTable_.size(); ++i){
+            max_error = std::max(max_error, orbitTable_.max_error(i));
+        }
+        std::cout << "Orbit table: " << orbitTable_.size() << " bodies, " << orbitTable_.bytes() / 1024 << " kB, max error "
+                  << max_error << (orbitTable_.covers(frame_clock::now()) ? "" : ", outside the window") << std::endl;
+    }
+
+    if(physicsMode_){
+        nbody::diagnostics energy = gravity_.energy();
+        std::cout << "Gravity: " << gravity_.size() << " bodies after " << gravity_.time() << " s, energy "
+                  << energy.total << ", drift " << energy.drift << std::endl;
+    }
+
+    std::cout << "Impostors: " << impostorCount_ << " planets below " << impostorPixels_ << " pixels" << std::endl;
+
+    std::cout << "Draw order (" << (frontToBack_ ? "front to back, skybox last" : "skybox first, scene order") << "): ";
+    if(fragmentQueries_){
+        std::cout << fragmentInvocations_ << " fragment shader invocations" << std::endl;
+    }else{
+        std::cout << "fragment shader invocations not available" << std::endl;
+    }
+
+    if(passProfiler_.supported()){
+        std::vector<gpu_profiler::pass_statistics> passes = passProfiler_.statistics();
+        std::cout << "GPU passes (mean of " << passes.front().frames << " frames):";
+        for(auto const& pass: passes){
+            std::cout << " " << pass.name << " " << pass.mean << " ms";
+        }
+        std::cout << std::endl;
+    }
 }
 
-void ApplicationSolar::renderOrbit(std::shared_ptr<Node> const& planet) const{
+// transform planets
+glm::fmat4 ApplicationSolar::transformPlanet(std::size_t index) const{
+
+    //the simulation or the orbit table replace the rotation around the parent
+    bool tabulated = tableMode_ && orbitTable_.covers(frame_clock::now());
+    if(physicsMode_ || tabulated){
+        glm::fvec3 position = physicsMode_ ? glm::fvec3{gravity_.position(index)} : orbitTable_.position(index, frame_clock::now());
+        return ephemeris::place(bodyOrbits_.orbit(index), position, frame_clock::now());
+    }
 
+    //rotations around the parents and the own axis, the same orbit model the ephemeris queries evaluate
+    return bodyOrbits_.transform(index, frame_clock::now());
+}
+
+float ApplicationSolar::projectedRadius(glm::fmat4 const& model_matrix) const{
+
+    // planets are unit spheres scaled uniformly, so the scale is the length of any axis
+    float radius = glm::length(glm::fvec3{model_matrix[0]});
+    glm::fvec3 center = glm::fvec3{glm::inverse(m_view_transform) * model_matrix[3]};
+    float distance = glm::length(center);
+
+    // camera inside the planet, use the finest level
+    if(distance <= radius){
+        return float(viewportSize_.y);
+    }
+    // projection[1][1] is cot(fov_y / 2), maps view space to half the viewport height
+    return radius / distance * m_view_projection[1][1] * 0.5f * float(viewportSize_.y);
+}
+
+glm::fmat4 ApplicationSolar::transformOrbit(std::size_t index) const{
+
+    auto const& planet = bodies_[index];
     float distance = planet->getDistanceOrigin().x;
     glm::fmat4 orbit_matrix = glm::fmat4{};
     
-    if(planet->getDepth() == 4){
+    if(planet->getDepth() == 4 && physicsMode_){
+        // in the n-body mode the starting orbit follows the simulated planet
+        orbit_matrix = glm::translate(orbit_matrix, glm::fvec3{gravity_.position(parentIndex_[index])});
+        orbit_matrix = glm::scale(orbit_matrix * planet->getLocalTransform(), glm::fvec3{distance, distance, distance});
+    }else if(planet->getDepth() == 4 && tableMode_ && orbitTable_.covers(frame_clock::now())){
+        // the orbit table has the planet at its tabulated position
+        orbit_matrix = glm::translate(orbit_matrix, orbitTable_.position(parentIndex_[index], frame_clock::now()));
+        orbit_matrix = glm::scale(orbit_matrix * planet->getLocalTransform(), glm::fvec3{distance, distance, distance});
+    }else if(planet->getDepth() == 4){
         // all moons, orbiting around a planet that is movig itself
         // first shift the orbit to where the parent is
         glm::fmat4 parent_matrix = planet->getOrigin()->getLocalTransform();
         //then rotate and translate like in planetTransformations()
-        orbit_matrix = glm::rotate(parent_matrix, float(glfwGetTime()) * (planet->getOrigin()->getSpeed()), glm::fvec3{0.0f, 1.0f, 0.0f});
+        orbit_matrix = glm::rotate(parent_matrix, float(frame_clock::now()) * (planet->getOrigin()->getSpeed()), glm::fvec3{0.0f, 1.0f, 0.0f});
         orbit_matrix = glm::translate(orbit_matrix, -1.0f * planet->getOrigin()->getDistanceOrigin());
         //then scale the orbit so it has the right size (distance to origin has to go into every direction!)
         orbit_matrix = glm::scale(orbit_matrix * planet->getLocalTransform(), glm::fvec3{distance, distance, distance});
@@ -255,28 +943,31 @@ void ApplicationSolar::renderOrbit(std::shared_ptr<Node> const& planet) const{
         orbit_matrix = glm::scale(orbit_matrix * planet->getLocalTransform(), glm::fvec3{distance, distance, distance});
     }
 
+    return orbit_matrix;
+}
+
+void ApplicationSolar::renderOrbit(glm::fmat4 const& orbit_matrix) const{
+
     // bind shader to upload uniforms
     glUseProgram(m_shaders.at("orbit").handle);
     //give matrices to shaders
     glUniformMatrix4fv(m_shaders.at("orbit").u_locs.at("OrbitMatrix"), 
                        1, GL_FALSE, glm::value_ptr(orbit_matrix));
 
-    // bind the VAO to draw
-    glBindVertexArray(orbit_object.vertex_AO);
-    // draw bound vertex array using bound shader
-    glDrawArrays(orbit_object.draw_mode, 0, planet_object.num_elements);
+    // draw orbit from the bound pool using bound shader
+    geometryPool_.draw(orbit_mesh);
 }
 
 void ApplicationSolar::renderStars() const{
+    TRACE_ZONE("renderStars");
     // bind shader to upload uniforms
     glUseProgram(m_shaders.at("star").handle);
-    // bind the VAO to draw
-    glBindVertexArray(star_object.vertex_AO);
-    // draw bound vertex array using bound shader
-    glDrawArrays(star_object.draw_mode, 0, star_object.num_elements);
+    // draw stars from the bound pool using bound shader
+    geometryPool_.draw(star_mesh);
 }
 
 void ApplicationSolar::renderScreenQuad() const{
+    TRACE_ZONE("renderScreenQuad");
     // bind to default framebuffer at 0
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
@@ -286,8 +977,7 @@ void ApplicationSolar::renderScreenQuad() const{
     //upload texture from framebuffer object to shader 
     glUniform1i(m_shaders.at("screenquad").u_locs.at("FBTexture"), 2);
 
-    glBindVertexArray(screenquad_object.vertex_AO);
-    glDrawArrays(screenquad_object.draw_mode, 0, screenquad_object.num_elements);
+    geometryPool_.draw(screenquad_mesh);
 }
 
 
@@ -295,6 +985,7 @@ void ApplicationSolar::renderScreenQuad() const{
 
 //init framebuffer object to render the scene to
 void ApplicationSolar::initializeFramebuffer(unsigned int width, unsigned int height){
+    TRACE_ZONE("initializeFramebuffer");
     // default width: 960u, default height: 840u (see applicatio.cpp -> resolution)
 
     // -------- First init the Texture (Color Attachment) --------
@@ -311,6 +1002,19 @@ void ApplicationSolar::initializeFramebuffer(unsigned int width, unsigned int he
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
 
 
+    // -------- then the integer Texture for planet ids (second Color Attachment) --------
+    // replaced on resize, the old one is no longer needed
+    glDeleteTextures(1, &FBIdTexture_.handle);
+    glGenTextures(1, &FBIdTexture_.handle);
+    glBindTexture(GL_TEXTURE_2D, FBIdTexture_.handle);
+
+    //ids can't be interpolated
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, width, height, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+
+
     // -------- then init the Renderbuffer (Depth Attachment) --------
     glGenRenderbuffers(1, &FBRenderbuffer_.handle);
     glBindRenderbuffer(GL_RENDERBUFFER, FBRenderbuffer_.handle);
@@ -325,8 +1029,9 @@ void ApplicationSolar::initializeFramebuffer(unsigned int width, unsigned int he
     glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_.handle);
     //Define Attachments
     glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, FBTexture_.handle, 0);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, FBIdTexture_.handle, 0);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, FBRenderbuffer_.handle);
-    //Define which Buffers to write
+    //Define which Buffers to write, planet ids are only written while drawing planets
     GLenum draw_buffers[1] = {GL_COLOR_ATTACHMENT0};
     glDrawBuffers(1, draw_buffers);
     //check that the framebuffer can be written
@@ -337,6 +1042,7 @@ void ApplicationSolar::initializeFramebuffer(unsigned int width, unsigned int he
 
 // create planets
 void ApplicationSolar::initializePlanets(){
+    TRACE_ZONE("initializePlanets");
 
     //Load model
     model planet_model = model_loader::obj(m_resource_path + "models/sphere.obj", model::NORMAL);
@@ -361,6 +1067,16 @@ void ApplicationSolar::initializePlanets(){
 
     auto sun_p = std::make_shared<GeometryNode>(sun);
 
+    //generated scenes replace the planets of the solar system
+    if(scene_.planets > 0){
+        root.addChildren(sun_lp);
+        (*sun_lp).addChildren(std::make_shared<GeometryNode>(sun));
+        scene_generator::add_planets(root, root_p, sun_p, planet_model, m_resource_path + "textures/",
+                                     scene_.planets, scene_.moons_per_planet, scene_.seed);
+        initializeSceneGraph(root);
+        return;
+    }
+
     //---------------------------------- Initialize Planets ---------------------------------
     //Set size (in LocalTransform Matrix), speed and distance to origin
     
@@ -503,58 +1219,87 @@ void ApplicationSolar::initializePlanets(){
     root.addChildren(neptun_hp);
     (*neptun_hp).addChildren(std::make_shared<GeometryNode>(neptun));
 
-    //------------------------ Initialize SceneGraph -------------------------
-    
-    sceneGraph_.setName("solarsystem");
+    initializeSceneGraph(root);
+}
+
+void ApplicationSolar::initializeSceneGraph(Node const& root){
+    TRACE_ZONE("initializeSceneGraph");
+
+    sceneGraph_.setName(scene_.planets > 0 ? "generated" : "solarsystem");
     sceneGraph_.setRoot(root);
+
+    //flat list of all planets for drawing
+    collectBodies(sceneGraph_.getRoot().getChildrenList());
+    for(auto const& body: bodies_){
+        bodyOrbits_.add(ephemeris::orbit_of(*body));
+    }
+
+    //origins of the bodies are copies of the nodes in the scene graph, their paths are unique within it
+    std::map<std::string, std::size_t> body_paths{};
+    for(std::size_t i = 0; i < bodies_.size(); ++i){
+        body_paths.emplace(bodies_[i]->getPath(), i);
+    }
+    parentIndex_.assign(bodies_.size(), bodies_.size());
+    for(std::size_t i = 0; i < bodies_.size(); ++i){
+        auto const& origin = bodies_[i]->getOrigin();
+        if(!origin){
+            continue;
+        }
+        auto parent = body_paths.find(origin->getPath());
+        if(parent == body_paths.end()){
+            throw std::logic_error("application_solar: origin " + origin->getPath() + " of " + bodies_[i]->getPath() + " is not a body");
+        }
+        parentIndex_[i] = parent->second;
+    }
+    //the sun is the only body without an origin
+    sunIndex_ = std::size_t(std::find(parentIndex_.begin(), parentIndex_.end(), bodies_.size()) - parentIndex_.begin());
+}
+
+void ApplicationSolar::collectBodies(std::list<std::shared_ptr<Node>> const& childrenList){
+
+    // recursive traversal through SceneGraph
+    // visit each child in children_ and check whether they themselves have children which have to be visited
+    for(auto const& planet: childrenList){
+
+        auto childPlanets = planet->getChildrenList();
+
+        if(childPlanets.size() > 0){   
+            collectBodies(childPlanets); //recursive call
+        }
+
+        //ignoring the holding Nodes
+        if(planet->getDepth() == 2 || planet->getDepth() == 4){
+            bodies_.push_back(planet);
+        }
+    }
 }
 
 // load models
 void ApplicationSolar::initializeGeometry() {
-    model planet_model = model_loader::obj(m_resource_path + "models/sphere.obj", model::NORMAL | model::TEXCOORD);
-
-    // generate vertex array object
-    glGenVertexArrays(1, &planet_object.vertex_AO);
-    // bind the array for attaching buffers
-    glBindVertexArray(planet_object.vertex_AO);
-
-    // generate generic buffer
-    glGenBuffers(1, &planet_object.vertex_BO);
-    // bind this as an vertex array buffer containing all attributes
-    glBindBuffer(GL_ARRAY_BUFFER, planet_object.vertex_BO);
-    // configure currently bound array buffer
-    //Buffer mit Vertexdaten werden "Verknüpft" so dass der Renderer weiß, wo sie liegen
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * planet_model.data.size(), planet_model.data.data(), GL_STATIC_DRAW);
-
-    // activate first attribute on gpu
-    glEnableVertexAttribArray(0);
-    // first attribute is 3 floats with no offset & stride
-    glVertexAttribPointer(0, model::POSITION.components, model::POSITION.type, GL_FALSE, planet_model.vertex_bytes, planet_model.offsets[model::POSITION]);
-    // activate second attribute on gpu
-    glEnableVertexAttribArray(1);
-    // second attribute is 3 floats with no offset & stride
-    glVertexAttribPointer(1, model::NORMAL.components, model::NORMAL.type, GL_FALSE, planet_model.vertex_bytes, planet_model.offsets[model::NORMAL]);
-
-    // activate third attribute on gpu
-    glEnableVertexAttribArray(2);
-    // second attribute is 2 floats with no offset & stride
-    glVertexAttribPointer(2, model::TEXCOORD.components, model::TEXCOORD.type, GL_FALSE, planet_model.vertex_bytes, planet_model.offsets[model::TEXCOORD]);
-
-    // generate generic buffer
-    glGenBuffers(1, &planet_object.element_BO);
-    // bind this as an vertex array buffer containing all attributes
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, planet_object.element_BO);
-    // configure currently bound array buffer
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, model::INDEX.size * planet_model.indices.size(), planet_model.indices.data(), GL_STATIC_DRAW);
+    TRACE_ZONE("initializeGeometry");
+    // procedural spheres from 20 to 81920 triangles, packed into one model
+    model planet_model = icosphere::generate_levels(0, 6, sphereLevels_);
+
+    // add all levels at once and move their offsets to where they are stored in the pool
+    mesh_range planet_mesh = geometryPool_.add(planet_model, GL_TRIANGLES);
+    for(auto& lod: sphereLevels_){
+        lod.first_index += planet_mesh.first_index;
+        lod.base_vertex += planet_mesh.base_vertex;
+    }
 
-    // store type of primitive to draw
-    planet_object.draw_mode = GL_TRIANGLES;
-    // transfer number of indices to model object 
-    planet_object.num_elements = GLsizei(planet_model.indices.size());
+    // quad for impostors, corners are spread around the planet in the vertex shader
+    std::vector<GLfloat> quad_positions{-1.0f, -1.0f, 0.0f,  1.0f, -1.0f, 0.0f,  -1.0f, 1.0f, 0.0f,  1.0f, 1.0f, 0.0f};
+    std::vector<GLuint> quad_indices{0, 1, 3,  0, 3, 2};
+    impostor_mesh = geometryPool_.add(model{quad_positions, model::POSITION, quad_indices}, GL_TRIANGLES);
 
+    // a few seeded rocks of 20 triangles, millions of them are drawn
+    for(unsigned variant = 0; variant < rock_variants; ++variant){
+        rockMeshes_.push_back(geometryPool_.add(asteroid_belt::rock(variant + 1), GL_TRIANGLES));
+    }
 }
 
 void ApplicationSolar::initializeOrbits(){
+    TRACE_ZONE("initializeOrbits");
     
     // create circle of 360 points
     for(int i = 0; i < 360; ++i){
@@ -566,41 +1311,18 @@ void ApplicationSolar::initializeOrbits(){
         orbits_.push_back(z);
     }
 
-    // generate vertex array object
-    glGenVertexArrays(1, &orbit_object.vertex_AO);
-    // bind the array for attaching buffers
-    glBindVertexArray(orbit_object.vertex_AO);
-
-    // generate generic buffer
-    glGenBuffers(1, &orbit_object.vertex_BO);
-    // bind this as an vertex array buffer containing all attributes
-    //https://wiki.delphigl.com/index.php/glBindBuffer
-    glBindBuffer(GL_ARRAY_BUFFER, orbit_object.vertex_BO);
-    // configure currently bound array buffer
-    //https://wiki.delphigl.com/index.php/glBufferData
-    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(sizeof(float) * orbits_.size()), orbits_.data(), GL_STATIC_DRAW);
-
-    // https://wiki.delphigl.com/index.php/glVertexAttribPointer
-    // activate first attribute on gpu (Position, 3 floats)
-    glEnableVertexAttribArray(0);
-    // first attribute is 3 floats with offset to 0 (start of Position)
-    // each orbit consists of 3 floats, offset (pointer to first component) is 0
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 3, 0);
-    
-    // There is only one attribute to activate (position), we don't need a second one here
-
+    // each orbit point only has a position (3 floats)
     // store type of primitive to draw
     // https://en.wikibooks.org/wiki/OpenGL_Programming/GLStart/Tut3
-    orbit_object.draw_mode = GL_LINES;
-    // transfer number of indices to model object 
-    orbit_object.num_elements = GLsizei(orbits_.size() / 3); //divide by 3 because each orbit consists of 3 floats (shoul be 360!)
+    orbit_mesh = geometryPool_.add(model{orbits_, model::POSITION}, GL_LINES);
 }
 
 //create stars
 void ApplicationSolar::initializeStars() {
+    TRACE_ZONE("initializeStars");
 
-    // 3000 random stars
-    for(int i = 0; i < 2000; ++i){ //6 floats for each star (x,y,z (Position) and r,g,b (Color))
+    // random stars, 2000 for the solar system
+    for(std::size_t i = 0; i < scene_.stars; ++i){ //6 floats for each star (x,y,z (Position) and r,g,b (Color))
         // %100 so they stay between 0 and 99,
         // the more you subtract the more stars appear, sth. between 40 and 60 looks good
         GLfloat x = (rand() % 100) - 40; 
@@ -619,113 +1341,250 @@ void ApplicationSolar::initializeStars() {
         stars_.push_back(b);
     }
 
-    // generate vertex array object
-    glGenVertexArrays(1, &star_object.vertex_AO);
-    // bind the array for attaching buffers
-    glBindVertexArray(star_object.vertex_AO);
-
-    // generate generic buffer
-    glGenBuffers(1, &star_object.vertex_BO);
-    // bind this as an vertex array buffer containing all attributes
-    //https://wiki.delphigl.com/index.php/glBindBuffer
-    glBindBuffer(GL_ARRAY_BUFFER, star_object.vertex_BO);
-    // configure currently bound array buffer
-    //Buffer mit Vertexdaten werden "Verknüpft" so dass der Renderer weiß, wo sie liegen
-    //https://wiki.delphigl.com/index.php/glBufferData
-    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(sizeof(float) * stars_.size()), stars_.data(), GL_STATIC_DRAW);
-
-    // https://wiki.delphigl.com/index.php/glVertexAttribPointer
-    // activate first attribute on gpu (Position, 3 floats)
-    glEnableVertexAttribArray(0);
-    // first attribute is 3 floats with offset to 0 (start of Position)
-    // each star consists of 6 floats, offset (pointer to first component) is 0
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 6, 0);
-    // activate second attribute on gpu (Normale, 3 floats)
-    glEnableVertexAttribArray(1);
-    // second attribute is 3 floats with offset to float at Index 3 (start of Normale), type is void pointer
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 6, (void*) (sizeof(float) * 3));
-
+    // each star consists of 6 floats, position and color
+    // the color is stored in the normal slot of the pool, it is the second attribute like before
     // store type of primitive to draw
-    star_object.draw_mode = GL_POINTS;
-    // transfer number of indices to model object 
-    star_object.num_elements = GLsizei(stars_.size() / 6); //divide by 6 because each star consists of 6 floats
+    star_mesh = geometryPool_.add(model{stars_, model::POSITION | model::NORMAL}, GL_POINTS);
 }
 
 void ApplicationSolar::initializeSkybox() {
+    TRACE_ZONE("initializeSkybox");
 
     model skybox_model = model_loader::obj(m_resource_path + "models/skybox.obj", model::NORMAL);
 
-    // generate vertex array object
-    glGenVertexArrays(1, &skybox_object.vertex_AO);
-    // bind the array for attaching buffers
-    glBindVertexArray(skybox_object.vertex_AO);
-
-    // generate generic buffer
-    glGenBuffers(1, &skybox_object.vertex_BO);
-    // bind this as an vertex array buffer containing all attributes
-    glBindBuffer(GL_ARRAY_BUFFER, skybox_object.vertex_BO);
-    // configure currently bound array buffer
-    //Buffer mit Vertexdaten werden "Verknüpft" so dass der Renderer weiß, wo sie liegen
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * skybox_model.data.size(), skybox_model.data.data(), GL_STATIC_DRAW);
-
-    // activate first attribute on gpu
-    glEnableVertexAttribArray(0);
-    // first attribute is 3 floats with no offset & stride
-    glVertexAttribPointer(0, model::POSITION.components, model::POSITION.type, GL_FALSE, skybox_model.vertex_bytes, skybox_model.offsets[model::POSITION]);
-
-    // generate generic buffer
-    glGenBuffers(1, &skybox_object.element_BO);
-    // bind this as an vertex array buffer containing all attributes
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, skybox_object.element_BO);
-    // configure currently bound array buffer
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, model::INDEX.size * skybox_model.indices.size(), skybox_model.indices.data(), GL_STATIC_DRAW);
-
-    // store type of primitive to draw
-    skybox_object.draw_mode = GL_TRIANGLES;
-    // transfer number of indices to model object 
-    skybox_object.num_elements = GLsizei(skybox_model.indices.size());
+    // only the position is used by the skybox shader
+    skybox_mesh = geometryPool_.add(skybox_model, GL_TRIANGLES);
 
     SkyBox_.setGeometry(skybox_model);
 
 }
 
 void ApplicationSolar::initializeScreenQuad() {
+    TRACE_ZONE("initializeScreenQuad");
 
     model screenquad_model = model_loader::obj(m_resource_path + "models/quad.obj", model::TEXCOORD);
 
-    // generate vertex array object
-    glGenVertexArrays(1, &screenquad_object.vertex_AO);
-    // bind the array for attaching buffers
-    glBindVertexArray(screenquad_object.vertex_AO);
-
-    // generate generic buffer
-    glGenBuffers(1, &screenquad_object.vertex_BO);
-    // bind this as an vertex array buffer containing all attributes
-    glBindBuffer(GL_ARRAY_BUFFER, screenquad_object.vertex_BO);
-    // configure currently bound array buffer
-    //Buffer mit Vertexdaten werden "Verknüpft" so dass der Renderer weiß, wo sie liegen
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * screenquad_model.data.size(), screenquad_model.data.data(), GL_STATIC_DRAW);
-
-    // activate first attribute on gpu
-    glEnableVertexAttribArray(0);
-    // first attribute is 3 floats with no offset & stride
-    glVertexAttribPointer(0, model::POSITION.components, model::POSITION.type, GL_FALSE, screenquad_model.vertex_bytes, screenquad_model.offsets[model::POSITION]);
-
-    // activate second attribute on gpu
-    glEnableVertexAttribArray(1);
-    // first attribute is 3 floats with no offset & stride
-    glVertexAttribPointer(1, model::TEXCOORD.components, model::TEXCOORD.type, GL_FALSE, screenquad_model.vertex_bytes, screenquad_model.offsets[model::TEXCOORD]);
+    // position and texture coordinates, drawn as triangle strip
+    screenquad_mesh = geometryPool_.add(screenquad_model, GL_TRIANGLE_STRIP);
 
-    // store type of primitive to draw
-    screenquad_object.draw_mode = GL_TRIANGLE_STRIP;
-    // transfer number of indices to model object 
-    screenquad_object.num_elements = GLsizei(screenquad_model.indices.size());
+}
+
+void ApplicationSolar::initializePlanetDraws() {
+    TRACE_ZONE("initializePlanetDraws");
+
+    // planets are drawn with one call if glMultiDrawElementsIndirect is available
+    multiDrawIndirect_ = utils::supports(4, 3, GLextension::GL_ARB_multi_draw_indirect);
+    std::cout << "Planet drawing: " << (multiDrawIndirect_ ? "multi draw indirect" : "one draw per planet") << std::endl;
+
+    glGenBuffers(1, &planetCommandBuffer_);
+
+    // two query sets, one is issued while the results of the other are used
+    for(std::size_t set = 0; set < occlusionQueries_.size(); ++set){
+        occlusionQueries_[set].resize(bodies_.size());
+        glGenQueries(GLsizei(bodies_.size()), occlusionQueries_[set].data());
+        queryIssued_[set].assign(bodies_.size(), 0);
+    }
+    impostors_.assign(bodies_.size(), 0);
+    hizBuffer_.resize(std::size_t(float(viewportSize_.x) / hiz_texel_pixels), std::size_t(float(viewportSize_.y) / hiz_texel_pixels));
+
+    // shaded fragments show what the draw order saves, counted where pipeline statistics are available
+    if(utils::supports(4, 6, GLextension::GL_ARB_pipeline_statistics_query)){
+        fragmentQueries_.reset(new query_ring{GL_FRAGMENT_SHADER_INVOCATIONS_ARB});
+    }
+
+    // per planet records are instanced attributes of the pool vertex array
+    geometryPool_.bind();
+    glGenBuffers(1, &planetRecordBuffer_);
+    glBindBuffer(GL_ARRAY_BUFFER, planetRecordBuffer_);
+    // allocate room for every planet, so other shaders using the vertex array never read an empty buffer
+    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(sizeof(planet_draw_record) * bodies_.size()), NULL, GL_STREAM_DRAW);
+    enablePlanetRecords();
+
+    // the cloud draws far more instances than there are planets, so its records get their own vertex array
+    cloudVertexArray_ = geometryPool_.add_vertex_array();
+    enablePlanetRecords();
+    geometryPool_.bind();
+}
+
+void ApplicationSolar::enablePlanetRecords() const{
+
+    // model matrix takes 4 attribute locations (5 to 8), one per column
+    for(GLuint column = 0; column < 4; ++column){
+        glEnableVertexAttribArray(5 + column);
+        glVertexAttribPointer(5 + column, 4, GL_FLOAT, GL_FALSE, sizeof(planet_draw_record),
+                              (GLvoid*)(sizeof(glm::fvec4) * column));
+        // advance once per instance, the base instance of each command selects the planet
+        glVertexAttribDivisor(5 + column, 1);
+    }
+    // texture layers of the planet
+    glEnableVertexAttribArray(9);
+    glVertexAttribPointer(9, 4, GL_FLOAT, GL_FALSE, sizeof(planet_draw_record),
+                          (GLvoid*)offsetof(planet_draw_record, draw_info));
+    glVertexAttribDivisor(9, 1);
+}
+
+void ApplicationSolar::initializeAsteroids() {
+    TRACE_ZONE("initializeAsteroids");
+
+    // all rocks share one texture array, each asteroid picks a layer
+    glActiveTexture(GL_TEXTURE0);
+    rockTextureArray_ = utils::create_texture_array(asteroid_belt::rock_textures(1, rock_layers));
+
+    // positions and packed size, spin and layer are instanced attributes of a vertex array only the belt uses,
+    // the draws of other passes would read past the end of the buffer
+    asteroidVertexArray_ = geometryPool_.add_vertex_array();
+    glGenBuffers(1, &asteroidBuffer_);
+    glBindBuffer(GL_ARRAY_BUFFER, asteroidBuffer_);
+    glEnableVertexAttribArray(10);
+    glVertexAttribPointer(10, 3, GL_FLOAT, GL_FALSE, sizeof(asteroid_belt::instance), (GLvoid*)0);
+    glVertexAttribDivisor(10, 1);
+    glEnableVertexAttribArray(11);
+    glVertexAttribIPointer(11, 1, GL_UNSIGNED_INT, sizeof(asteroid_belt::instance),
+                           (GLvoid*)offsetof(asteroid_belt::instance, packed));
+    glVertexAttribDivisor(11, 1);
+    geometryPool_.bind();
+
+    // draw time of the belt is measured where timer queries are available
+    if(utils::supports(3, 3, GLextension::GL_ARB_timer_query)){
+        asteroidTimer_.reset(new query_ring{GL_TIME_ELAPSED});
+    }
+
+    generateBelt(scene_.asteroids);
+}
+
+void ApplicationSolar::generateBelt(std::size_t count) {
+
+    asteroid_belt::parameters params{};
+    params.count = count;
+    params.variants = rock_variants;
+    params.layers = rock_layers;
+    belt_.generate(params);
+    std::cout << "Asteroid belt: " << belt_.size() << " asteroids" << std::endl;
+}
+
+void ApplicationSolar::initializePhysics() {
+    TRACE_ZONE("initializePhysics");
+
+    //start from where the animation has the bodies now, in the order of bodies_
+    //softening below the smallest moon radius, so close passes stay finite
+    nbody::parameters params{};
+    params.softening = 0.05;
+    gravity_ = nbody::simulation{params};
+    std::vector<glm::dvec3> positions{};
+    std::vector<double> masses{};
+    for(std::size_t i = 0; i < bodies_.size(); ++i){
+        positions.push_back(glm::dvec3{glm::fvec3{transformPlanet(i)[3]}});
+        double radius = bodies_[i]->getRadius();
+        masses.push_back(bodies_[i]->getOrigin() ? body_gravity_density * radius * radius * radius : sun_gravity);
+    }
+
+    //circular orbits around the parent in the direction of the animation, moons add the velocity of their planet
+    std::vector<glm::dvec3> velocities(bodies_.size(), glm::dvec3{0.0});
+    std::function<glm::dvec3(std::size_t)> orbit_velocity = [&](std::size_t i){
+        std::size_t parent = parentIndex_[i];
+        if(parent == bodies_.size()){
+            return glm::dvec3{0.0};
+        }
+        glm::dvec3 offset = positions[i] - positions[parent];
+        double distance = glm::length(offset);
+        double speed = std::sqrt((masses[parent] + masses[i]) / distance);
+        return orbit_velocity(parent) + speed * glm::normalize(glm::cross(glm::dvec3{0.0, 1.0, 0.0}, offset));
+    };
+
+    //the center of mass stays in place
+    glm::dvec3 momentum{0.0};
+    double total_mass = 0.0;
+    for(std::size_t i = 0; i < bodies_.size(); ++i){
+        velocities[i] = orbit_velocity(i);
+        momentum += masses[i] * velocities[i];
+        total_mass += masses[i];
+    }
+    //moons orbit far outside the hill spheres of their planets, which the planets keep clear of each other,
+    //so they are bound to their planet instead of being stripped off by the sun
+    for(std::size_t i = 0; i < bodies_.size(); ++i){
+        std::size_t parent = parentIndex_[i];
+        if(parent == bodies_.size() || parent == sunIndex_){
+            gravity_.add(masses[i], positions[i], velocities[i] - momentum / total_mass);
+        }else{
+            gravity_.add(masses[i], positions[i], velocities[i] - momentum / total_mass, parent);
+        }
+    }
+    physicsClock_ = frame_clock::now();
+}
 
-    //glBindVertexArray(0);
+void ApplicationSolar::initializeOrbitTable() {
+    TRACE_ZONE("initializeOrbitTable");
+
+    //a table of other orbits or fit parameters, an older version or a broken file is replaced
+    chebyshev::parameters params{};
+    std::uint64_t hash = chebyshev::hash(bodyOrbits_, params);
+    try{
+        orbitTable_.load(orbit_table_file);
+        if(orbitTable_.source_hash() == hash){
+            std::cout << "Orbit table: loaded " << orbit_table_file << std::endl;
+            return;
+        }
+    }catch(std::logic_error const&){
+    }
 
+    //the fit is timed on the wall clock, the animation clock may be fixed
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    orbitTable_.fit(bodyOrbits_, params);
+    std::cout << "Orbit table: fitted " << orbitTable_.segment_count() << " segments per body in "
+              << utils::milliseconds(std::chrono::steady_clock::now() - start) << " ms" << std::endl;
+    try{
+        orbitTable_.save(orbit_table_file);
+    }catch(std::logic_error const& error){
+        std::cout << error.what() << std::endl;
+    }
+}
+
+void ApplicationSolar::generateCloud(std::size_t count) {
+
+    //a disc of dust inside the orbit of mercury around a central mass as heavy as the sun, which is not drawn
+    std::vector<gravity_compute::particle> particles{};
+    std::mt19937 random{7};
+    std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+    if(count > 0){
+        particles.push_back(gravity_compute::particle{glm::fvec4{0.0f, 0.0f, 0.0f, float(sun_gravity)}, glm::fvec4{0.0f}});
+    }
+    for(std::size_t i = 1; i < count; ++i){
+        float radius = 3.0f + 4.0f * unit(random);
+        float angle = glm::two_pi<float>() * unit(random);
+        float speed = std::sqrt(float(sun_gravity) / radius);
+        //the dust together weighs a hundredth of the sun, enough to clump
+        particles.push_back(gravity_compute::particle{
+            glm::fvec4{radius * std::cos(angle), 0.1f * (unit(random) - 0.5f), radius * std::sin(angle), 0.01f * float(sun_gravity) / float(count)},
+            glm::fvec4{-speed * std::sin(angle), 0.0f, speed * std::cos(angle), 0.03f}});
+    }
+
+    //textured like the moon
+    cloud_.upload(m_shaders.at("gravity"), particles, glm::fvec4{float(moonLayer_), 0.0f, 0.0f, 0.0f});
+    std::cout << "Gravity cloud: " << cloud_.size() << " particles" << std::endl;
+}
+
+void ApplicationSolar::updatePhysics() const {
+    TRACE_ZONE("updatePhysics");
+
+    if(!physicsMode_){
+        return;
+    }
+
+    //fixed steps keep the leapfrog integrator symplectic, time the simulation cannot keep up with is dropped
+    double now = frame_clock::now();
+    unsigned steps = 0;
+    while(physicsClock_ + physics_step <= now && steps < max_physics_steps){
+        gravity_.step(physics_step);
+        physicsClock_ += physics_step;
+        ++steps;
+    }
+    if(steps == max_physics_steps){
+        physicsClock_ = std::max(physicsClock_, now - physics_step);
+    }
 }
 
 void ApplicationSolar::initializeTextures(){
+    TRACE_ZONE("initializeTextures");
 
     // ----- init skybox texture -----
     auto textures = SkyBox_.getTextures();
@@ -763,29 +1622,39 @@ void ApplicationSolar::initializeTextures(){
 
 
     // ----- init planet textures -----
-    auto childrenList = sceneGraph_.getRoot().getChildrenList();
-    loadPlanetTextures(childrenList);
+    loadPlanetTextures();
 
 }
 
-void ApplicationSolar::loadPlanetTextures(std::list<std::shared_ptr<Node>> const& childrenList){
-    
-    for(auto const& planet: childrenList){
-
-        auto childPlanets = planet->getChildrenList();
-
-        if(childPlanets.size() > 0){   
-           loadPlanetTextures(childPlanets); //recursive call
+void ApplicationSolar::loadPlanetTextures(){
+
+    //size of all layers in the texture arrays, most planet maps already have 1024 x 512
+    std::size_t const layer_width = scene_.texture_width;
+    std::size_t const layer_height = std::max(scene_.texture_width / 2, std::size_t{1});
+
+    std::vector<pixel_data> color_layers{};
+    std::vector<pixel_data> normal_layers{};
+    //bodies with the same texture file share its layer
+    std::map<std::string, int> color_layer_of{};
+    std::map<std::string, int> normal_layer_of{};
+    //nodes of generated scenes only know the file, the others loaded it on construction
+    auto layer = [&](pixel_data const& texture, std::string const& path, std::map<std::string, int>& layer_of,
+                     std::vector<pixel_data>& layers){
+        auto known = layer_of.find(path);
+        if(known != layer_of.end()){
+            return known->second;
         }
+        layer_of.emplace(path, int(layers.size()));
+        layers.push_back(texture_loader::resize(texture.pixels.empty() ? texture_loader::file(path) : texture, layer_width, layer_height));
+        return int(layers.size()) - 1;
+    };
 
-        if(planet->getDepth() == 2 || planet->getDepth() == 4){
-            //this way the holding nodes are being ignored
-
-            if(planet->hasNormapMapping()){
-                //init normal Textures
-                loadNormalTextures(planet);
-            }
+    bool moon_found = false;
+    for(std::size_t i = 0; i < bodies_.size(); ++i){
+        auto const& planet = bodies_[i];
 
+        if(i == sunIndex_){
+            //the sun has its own shader and keeps a single texture
             auto texture = planet -> getTexture();
             auto text_object = planet -> getTextureObject();
 
@@ -801,52 +1670,75 @@ void ApplicationSolar::loadPlanetTextures(std::list<std::shared_ptr<Node>> const
             
             // store the loaded Texture in planet
             planet->setTextureObject(text_object);
+            continue;
+        }
+
+        // store layer of the texture in the planet
+        planet->setTextureLayer(layer(planet->getTexture(), planet->getTexpath(), color_layer_of, color_layers));
+        if(planet->getDepth() == 4 && !moon_found){
+            moonLayer_ = planet->getTextureLayer();
+            moon_found = true;
+        }
 
+        if(planet->hasNormapMapping()){
+            //init normal Textures
+            planet->setNormalTextureLayer(layer(planet->getNormalTexture(), planet->getNormalTexpath(), normal_layer_of, normal_layers));
         }
     }
-}
 
-void ApplicationSolar::loadNormalTextures(std::shared_ptr<Node> const& planet){
-    
-    auto texture = planet->getNormalTexture();
-    auto text_object = planet -> getNormalTextureObject();
+    //texture arrays need at least one layer, use a flat normal if no planet has a normal map
+    if(normal_layers.empty()){
+        std::vector<std::uint8_t> flat_normal{128, 128, 255, 255};
+        normal_layers.push_back(pixel_data{flat_normal, GL_RGBA, GL_UNSIGNED_BYTE, 1, 1});
+    }
 
+    glActiveTexture(GL_TEXTURE0);
+    planetTextureArray_ = utils::create_texture_array(color_layers);
     glActiveTexture(GL_TEXTURE1);
-    glGenTextures(1, &text_object.handle);
-    glBindTexture(GL_TEXTURE_2D, text_object.handle);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR); //scale down
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR); //scale up (render texture on area bigger than the texture)
-
-    glTexImage2D(GL_TEXTURE_2D, 0, texture.channels, texture.width, texture.height, 0, texture.channels, 
-                texture.channel_type, texture.ptr());
-    
-    // store the loaded Texture in planet
-    planet->setNormalTextureObject(text_object);
-
-    
+    normalTextureArray_ = utils::create_texture_array(normal_layers);
 }
 
 // load shader sources
 void ApplicationSolar::initializeShaderPrograms() {
+    TRACE_ZONE("initializeShaderPrograms");
     // store shader program objects in container m_shader
     m_shaders.emplace("planet", shader_program{{{GL_VERTEX_SHADER,m_resource_path + "shaders/planet.vert"},
                                             {GL_FRAGMENT_SHADER, m_resource_path + "shaders/planet.frag"}}});
     // request uniform locations for shader program
-    m_shaders.at("planet").u_locs["NormalMatrix"] = -1;
-    m_shaders.at("planet").u_locs["ModelMatrix"] = -1;
     m_shaders.at("planet").u_locs["ViewMatrix"] = -1;
     m_shaders.at("planet").u_locs["ProjectionMatrix"] = -1;
     //m_shaders.at("planet").u_locs["PlanetColor"] = -1;
     m_shaders.at("planet").u_locs["LightColor"] = -1;
     m_shaders.at("planet").u_locs["LightIntensity"] = -1;
-    m_shaders.at("planet").u_locs["PlanetTexture"] = -1;
-    m_shaders.at("planet").u_locs["NormalTexture"] = -1;
-    m_shaders.at("planet").u_locs["HasNormalMap"] = 0;
+    m_shaders.at("planet").u_locs["PlanetTextures"] = -1;
+    m_shaders.at("planet").u_locs["NormalTextures"] = -1;
     m_shaders.at("planet").u_locs["ShaderMode_normal"] = 0; //normal mapping
     m_shaders.at("planet").u_locs["ShaderMode_cell"] = 0; //cell-shading
 
 
+    // distant planets, same inputs as the planet shader
+    m_shaders.emplace("impostor", shader_program{{{GL_VERTEX_SHADER,m_resource_path + "shaders/impostor.vert"},
+                                            {GL_FRAGMENT_SHADER, m_resource_path + "shaders/impostor.frag"}}});
+    m_shaders.at("impostor").u_locs["ViewMatrix"] = -1;
+    m_shaders.at("impostor").u_locs["ProjectionMatrix"] = -1;
+    m_shaders.at("impostor").u_locs["LightColor"] = -1;
+    m_shaders.at("impostor").u_locs["LightIntensity"] = -1;
+    m_shaders.at("impostor").u_locs["PlanetTextures"] = -1;
+    m_shaders.at("impostor").u_locs["NormalTextures"] = -1;
+    m_shaders.at("impostor").u_locs["ShaderMode_normal"] = 0; //normal mapping
+    m_shaders.at("impostor").u_locs["ShaderMode_cell"] = 0; //cell-shading
+
+    // instanced rocks of the asteroid belt
+    m_shaders.emplace("asteroid", shader_program{{{GL_VERTEX_SHADER,m_resource_path + "shaders/asteroid.vert"},
+                                            {GL_FRAGMENT_SHADER, m_resource_path + "shaders/asteroid.frag"}}});
+    m_shaders.at("asteroid").u_locs["ViewMatrix"] = -1;
+    m_shaders.at("asteroid").u_locs["ProjectionMatrix"] = -1;
+    m_shaders.at("asteroid").u_locs["MaxSize"] = -1;
+    m_shaders.at("asteroid").u_locs["Time"] = -1;
+    m_shaders.at("asteroid").u_locs["LightColor"] = -1;
+    m_shaders.at("asteroid").u_locs["LightIntensity"] = -1;
+    m_shaders.at("asteroid").u_locs["RockTextures"] = -1;
+
     m_shaders.emplace("sun", shader_program{{{GL_VERTEX_SHADER,m_resource_path + "shaders/sun.vert"},
                                             {GL_FRAGMENT_SHADER, m_resource_path + "shaders/sun.frag"}}});
     // request uniform locations for shader program
@@ -855,6 +1747,7 @@ void ApplicationSolar::initializeShaderPrograms() {
     m_shaders.at("sun").u_locs["ViewMatrix"] = -1;
     m_shaders.at("sun").u_locs["ProjectionMatrix"] = -1;
     m_shaders.at("sun").u_locs["SunTexture"] = -1;
+    m_shaders.at("sun").u_locs["BodyId"] = -1;
     m_shaders.at("sun").u_locs["ShaderMode_cell"] = 0; //cell-shading
 
 
@@ -887,6 +1780,20 @@ void ApplicationSolar::initializeShaderPrograms() {
     m_shaders.at("screenquad").u_locs["ShaderMode_grey"] = 0; //greyscale
     m_shaders.at("screenquad").u_locs["ShaderMode_verticalMirror"] = 0; //vertical mirror
     m_shaders.at("screenquad").u_locs["ShaderMode_horizontalMirror"] = 0; //horizontal mirror
+
+    // all pairs gravity of the particle cloud, only where compute shaders are available
+    if(utils::supports(4, 3, GLextension::GL_ARB_compute_shader)){
+        m_shaders.emplace("gravity", shader_program{{{GL_COMPUTE_SHADER, m_resource_path + "shaders/gravity.comp"}}});
+        m_shaders.at("gravity").u_locs["Count"] = -1;
+        m_shaders.at("gravity").u_locs["TimeStep"] = -1;
+        m_shaders.at("gravity").u_locs["Gravity"] = -1;
+        m_shaders.at("gravity").u_locs["Softening"] = -1;
+        m_shaders.at("gravity").u_locs["Stage"] = -1;
+        // step time of the cloud where timer queries are available
+        if(utils::supports(3, 3, GLextension::GL_ARB_timer_query)){
+            cloudTimer_.reset(new query_ring{GL_TIME_ELAPSED});
+        }
+    }
    
 }
 
@@ -902,6 +1809,14 @@ void ApplicationSolar::uploadView() {
     glUniformMatrix4fv(m_shaders.at("planet").u_locs.at("ViewMatrix"),
                         1, GL_FALSE, glm::value_ptr(view_matrix));
     
+    glUseProgram(m_shaders.at("impostor").handle);
+    glUniformMatrix4fv(m_shaders.at("impostor").u_locs.at("ViewMatrix"),
+                        1, GL_FALSE, glm::value_ptr(view_matrix));
+
+    glUseProgram(m_shaders.at("asteroid").handle);
+    glUniformMatrix4fv(m_shaders.at("asteroid").u_locs.at("ViewMatrix"),
+                        1, GL_FALSE, glm::value_ptr(view_matrix));
+
     // upload matrix to gpu
     glUseProgram(m_shaders.at("sun").handle);
     glUniformMatrix4fv(m_shaders.at("sun").u_locs.at("ViewMatrix"),
@@ -928,6 +1843,14 @@ void ApplicationSolar::uploadProjection() {
     glUniformMatrix4fv(m_shaders.at("planet").u_locs.at("ProjectionMatrix"),
                         1, GL_FALSE, glm::value_ptr(m_view_projection));
     
+    glUseProgram(m_shaders.at("impostor").handle);
+    glUniformMatrix4fv(m_shaders.at("impostor").u_locs.at("ProjectionMatrix"),
+                        1, GL_FALSE, glm::value_ptr(m_view_projection));
+
+    glUseProgram(m_shaders.at("asteroid").handle);
+    glUniformMatrix4fv(m_shaders.at("asteroid").u_locs.at("ProjectionMatrix"),
+                        1, GL_FALSE, glm::value_ptr(m_view_projection));
+
     glUseProgram(m_shaders.at("sun").handle);
     glUniformMatrix4fv(m_shaders.at("sun").u_locs.at("ProjectionMatrix"),
                         1, GL_FALSE, glm::value_ptr(m_view_projection));
@@ -953,6 +1876,10 @@ void ApplicationSolar::uploadAppearance() {
     glUniform1i(m_shaders.at("planet").u_locs.at("ShaderMode_normal"), shaderMode_normal);
     glUniform1i(m_shaders.at("planet").u_locs.at("ShaderMode_cell"), shaderMode_cell);
 
+    glUseProgram(m_shaders.at("impostor").handle);
+    glUniform1i(m_shaders.at("impostor").u_locs.at("ShaderMode_normal"), shaderMode_normal);
+    glUniform1i(m_shaders.at("impostor").u_locs.at("ShaderMode_cell"), shaderMode_cell);
+
     glUseProgram(m_shaders.at("sun").handle);
     glUniform1i(m_shaders.at("sun").u_locs.at("ShaderMode_cell"), shaderMode_cell);
 
@@ -984,6 +1911,14 @@ void ApplicationSolar::keyCallback(int key, int action, int mods) {
     // 1 = default shader / reset shaders
     // 2 = cell-shading
     // 3 = normal mapping
+    // 4 = gpu picking
+    // 5 = occlusion culling mode
+    // 6 = draw order
+    // [ / ] = smaller / larger impostor threshold
+    // b = asteroid belt size
+    // g = n-body gravity or animated orbits
+    // c = gpu gravity cloud size
+    // t = orbit table or evaluated orbit chains
     // 7 = grey-scales
     // 8 = horizontal mirroring
     // 9 = vertical mirroring
@@ -1040,6 +1975,92 @@ void ApplicationSolar::keyCallback(int key, int action, int mods) {
         shaderMode_normal ? shaderMode_normal = false : shaderMode_normal = true;
         uploadAppearance();
     }
+    //GPU picking through the id buffer instead of ray casting
+    else if(key == GLFW_KEY_4 && action == GLFW_PRESS){
+        idBuffer_ = !idBuffer_;
+        std::cout << "Picking: " << (idBuffer_ ? "gpu id buffer" : "ray cast") << std::endl;
+    }
+    //occlusion culling: queries, cpu hierarchical z, off
+    else if(key == GLFW_KEY_5 && action == GLFW_PRESS){
+        if(occlusionMode_ == occlusion_mode::queries){
+            occlusionMode_ = occlusion_mode::hierarchical_z;
+        }else if(occlusionMode_ == occlusion_mode::hierarchical_z){
+            occlusionMode_ = occlusion_mode::off;
+        }else{
+            occlusionMode_ = occlusion_mode::queries;
+        }
+        //queries of the old mode must not decide over draws
+        for(auto& issued: queryIssued_){
+            std::fill(issued.begin(), issued.end(), 0);
+        }
+    }
+    //planets front to back with the skybox last or the old order, to compare shaded fragments
+    else if(key == GLFW_KEY_6 && action == GLFW_PRESS){
+        frontToBack_ = !frontToBack_;
+    }
+    //planets below the threshold are drawn as impostors, 0 turns them off
+    else if(key == GLFW_KEY_LEFT_BRACKET && (action == GLFW_PRESS || action == GLFW_REPEAT )){
+        impostorPixels_ = std::max(0.0f, impostorPixels_ - 2.0f);
+        std::cout << "Impostors below " << impostorPixels_ << " pixels" << std::endl;
+    }
+    else if(key == GLFW_KEY_RIGHT_BRACKET && (action == GLFW_PRESS || action == GLFW_REPEAT )){
+        impostorPixels_ += 2.0f;
+        std::cout << "Impostors below " << impostorPixels_ << " pixels" << std::endl;
+    }
+    //next asteroid count, regenerated from the same seed
+    else if(key == GLFW_KEY_B && action == GLFW_PRESS){
+        beltSize_ = (beltSize_ + 1) % (sizeof(belt_sizes) / sizeof(belt_sizes[0]));
+        generateBelt(belt_sizes[beltSize_]);
+    }
+    //bodies under mutual gravity, starting from the animated positions
+    else if(key == GLFW_KEY_G && action == GLFW_PRESS){
+        //seeded while transformPlanet still animates
+        if(!physicsMode_){
+            initializePhysics();
+        }
+        physicsMode_ = !physicsMode_;
+        std::cout << "Motion: " << (physicsMode_ ? "n-body gravity" : "animated orbits") << std::endl;
+    }
+    //positions from the precomputed polynomials, the table is built on first use
+    else if(key == GLFW_KEY_T && action == GLFW_PRESS){
+        if(orbitTable_.size() == 0){
+            initializeOrbitTable();
+        }
+        tableMode_ = !tableMode_;
+        std::cout << "Orbits: " << (tableMode_ ? "chebyshev table" : "evaluated chains") << std::endl;
+    }
+    //next particle count of the cloud, only with compute shaders
+    else if(key == GLFW_KEY_C && action == GLFW_PRESS){
+        if(m_shaders.count("gravity") == 0){
+            std::cout << "Gravity cloud: compute shaders not supported" << std::endl;
+        }else{
+            cloudSize_ = (cloudSize_ + 1) % (sizeof(cloud_sizes) / sizeof(cloud_sizes[0]));
+            generateCloud(cloud_sizes[cloudSize_]);
+        }
+    }
+    //bars of the gpu pass times in the upper left corner
+    else if(key == GLFW_KEY_P && action == GLFW_PRESS){
+        showPassProfile_ = !showPassProfile_;
+        if(showPassProfile_){
+            std::cout << "Pass profile: bars of the mean gpu time with a tick at the 95th percentile, full width is "
+                      << "1/60 s, from the top: ";
+            for(auto const& pass: passProfiler_.statistics()){
+                std::cout << pass.name << " ";
+            }
+            std::cout << std::endl;
+        }
+    }
+    //culling, occlusion, asteroid and other scene statistics once per second
+    else if(key == GLFW_KEY_L && action == GLFW_PRESS){
+        reportScene_ = !reportScene_;
+        std::cout << "Scene report: " << (reportScene_ ? "on" : "off") << std::endl;
+    }
+    //statistics of the gpu pass times into the working directory
+    else if(key == GLFW_KEY_F && action == GLFW_PRESS){
+        passProfiler_.write_csv("gpu_passes.csv");
+        passProfiler_.write_json("gpu_passes.json");
+        std::cout << "Pass profile: written to gpu_passes.csv and gpu_passes.json" << std::endl;
+    }
     //Grey-Scales
     else if(key == GLFW_KEY_7 && (action == GLFW_PRESS || action == GLFW_REPEAT )){
         shaderMode_grey ? shaderMode_grey = false : shaderMode_grey = true;
@@ -1096,9 +2117,29 @@ void ApplicationSolar::mouseCallback(double pos_x, double pos_y) {
 
 }
 
+//handle mouse buttons
+void ApplicationSolar::mouseButtonCallback(int button, int action, int mods, double pos_x, double pos_y) {
+
+    //pick the planet under the cursor
+    if(button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS && idBuffer_){
+        //read the id buffer, the result is reported when it arrives
+        requestGpuPick(glm::fvec2{float(pos_x), float(pos_y)});
+    }
+    else if(button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS){
+        pick_result picked = pickBody(glm::fvec2{float(pos_x), float(pos_y)});
+        if(picked.hit){
+            std::cout << "Picked " << picked.name << " (" << picked.path << ") at distance " << picked.distance << std::endl;
+        }else{
+            std::cout << "Picked nothing" << std::endl;
+        }
+    }
+}
+
 //handle resizing
 void ApplicationSolar::resizeCallback(unsigned width, unsigned height) {
   // recalculate projection matrix for new aspect ration
+  viewportSize_ = glm::uvec2{width, height};
+  hizBuffer_.resize(std::size_t(float(width) / hiz_texel_pixels), std::size_t(float(height) / hiz_texel_pixels));
   m_view_projection = utils::calculate_projection_matrix(float(width) / float(height));
   
   //resize everything with window
@@ -1111,7 +2152,9 @@ void ApplicationSolar::resizeCallback(unsigned width, unsigned height) {
 }
 
 
-// exe entry point
+// exe entry point, the benchmark build brings its own
+#ifndef SOLAR_BENCH
 int main(int argc, char* argv[]) {
   Application::run<ApplicationSolar>(argc, argv, 3, 2);
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,91 @@
+#ifndef BENCH_UTILS_HPP
+#define BENCH_UTILS_HPP
+
+#include "utils.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// helpers shared by the benchmark executables
+namespace bench {
+
+// summary of repeated measurements in milliseconds
+struct statistics {
+  double mean = 0.0;
+  double median = 0.0;
+  double min = 0.0;
+  double max = 0.0;
+  double p95 = 0.0;
+  double p99 = 0.0;
+  double stddev = 0.0;
+};
+
+inline statistics summarize(std::vector<double> samples) {
+  statistics result{};
+  if (samples.empty()) {
+    return result;
+  }
+  std::sort(samples.begin(), samples.end());
+  double sum = 0.0;
+  for (double sample : samples) {
+    sum += sample;
+  }
+  result.mean = sum / double(samples.size());
+  double variance = 0.0;
+  for (double sample : samples) {
+    variance += (sample - result.mean) * (sample - result.mean);
+  }
+  result.stddev = std::sqrt(variance / double(samples.size()));
+  result.min = samples.front();
+  result.max = samples.back();
+  result.median = utils::percentile(samples, 0.5);
+  result.p95 = utils::percentile(samples, 0.95);
+  result.p99 = utils::percentile(samples, 0.99);
+  return result;
+}
+
+// keep the compiler from removing computations whose result is unused
+template<typename T>
+inline void do_not_optimize(T const& value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile char sink;
+  sink = *reinterpret_cast<char const volatile*>(&value);
+#endif
+}
+
+// run func warmup times untimed, then return the duration of each of the repetitions in milliseconds
+template<typename F>
+std::vector<double> measure(F&& func, unsigned warmup, unsigned repetitions) {
+  for (unsigned i = 0; i < warmup; ++i) {
+    func();
+  }
+  std::vector<double> samples{};
+  samples.reserve(repetitions);
+  for (unsigned i = 0; i < repetitions; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    auto end = std::chrono::steady_clock::now();
+    samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+  }
+  return samples;
+}
+
+inline void print_header() {
+  std::printf("%-32s %10s %10s %10s %10s %10s %10s\n", "benchmark", "count", "mean ms", "median ms", "p95 ms", "min ms",
+              "stddev");
+}
+
+inline void print_row(std::string const& name, std::size_t count, statistics const& stats) {
+  std::printf("%-32s %10zu %10.4f %10.4f %10.4f %10.4f %10.4f\n", name.c_str(), count, stats.mean, stats.median,
+              stats.p95, stats.min, stats.stddev);
+}
+
+}
+
+#endif
@@ -0,0 +1,143 @@
+#include "bench_utils.hpp"
+#include "bvh.hpp"
+#include "culling.hpp"
+#include "picking.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/geometric.hpp>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+// bodies on circular orbits around the origin, like planets and asteroids of the solar system
+struct orbiting_bodies {
+  std::vector<float> orbit_radius;
+  std::vector<float> angle;
+  std::vector<float> speed;
+  std::vector<float> height;
+  culling::sphere_batch spheres;
+
+  orbiting_bodies(std::size_t count, unsigned seed) {
+    std::mt19937 random{seed};
+    std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+    for (std::size_t i = 0; i < count; ++i) {
+      orbit_radius.push_back(5.0f + 995.0f * unit(random) * unit(random));
+      angle.push_back(glm::two_pi<float>() * unit(random));
+      // inner orbits are faster
+      speed.push_back(2.0f / std::sqrt(orbit_radius.back()));
+      height.push_back((unit(random) - 0.5f) * 0.05f * orbit_radius.back());
+      spheres.push_back(glm::fvec3{0.0f}, 0.1f + 1.9f * unit(random) * unit(random));
+    }
+    advance(0.0f);
+  }
+
+  void advance(float time) {
+    for (std::size_t i = 0; i < angle.size(); ++i) {
+      float phase = angle[i] + speed[i] * time;
+      spheres.x[i] = orbit_radius[i] * std::cos(phase);
+      spheres.y[i] = height[i];
+      spheres.z[i] = orbit_radius[i] * std::sin(phase);
+    }
+  }
+};
+
+int main(int argc, char* argv[]) {
+  // optional largest body count, so quick runs can skip the million bodies
+  std::size_t max_count = argc > 1 ? std::size_t(std::strtoull(argv[1], nullptr, 10)) : 1000000;
+  std::size_t const queries = 1000;
+
+  glm::fmat4 projection = glm::perspective(glm::radians(60.0f), 960.0f / 840.0f, 0.1f, 2000.0f);
+  glm::fmat4 view = glm::lookAt(glm::fvec3{0.0f, 200.0f, 900.0f}, glm::fvec3{0.0f}, glm::fvec3{0.0f, 1.0f, 0.0f});
+  culling::frustum planes = culling::extract_frustum(projection * view);
+
+  bench::print_header();
+  for (std::size_t count = 10000; count <= max_count; count *= 10) {
+    unsigned repetitions = count >= 1000000 ? 10 : 50;
+    orbiting_bodies bodies{count, 42};
+    bvh::tree hierarchy{};
+    float time = 0.0f;
+
+    auto build = bench::measure([&]() { hierarchy.build(bodies.spheres); }, 1, repetitions);
+    bench::print_row("build", count, bench::summarize(build));
+
+    // one simulated frame between refits, positions are updated outside of the measurement
+    std::vector<double> refit{};
+    for (unsigned i = 0; i < repetitions; ++i) {
+      time += 1.0f / 60.0f;
+      bodies.advance(time);
+      auto sample = bench::measure([&]() { hierarchy.refit(bodies.spheres); }, 0, 1);
+      refit.push_back(sample.front());
+    }
+    bench::print_row("refit", count, bench::summarize(refit));
+
+    std::vector<std::uint32_t> visible{};
+    auto frustum = bench::measure([&]() {
+      hierarchy.frustum_query(planes, bodies.spheres, visible);
+      bench::do_not_optimize(visible.size());
+    }, 1, repetitions);
+    bench::print_row("frustum bvh", count, bench::summarize(frustum));
+
+    std::vector<std::uint8_t> flags{};
+    std::size_t linear_visible = 0;
+    auto linear = bench::measure([&]() {
+      linear_visible = culling::cull_spheres(planes, bodies.spheres, flags);
+      bench::do_not_optimize(linear_visible);
+    }, 1, repetitions);
+    bench::print_row("frustum linear", count, bench::summarize(linear));
+    if (linear_visible != visible.size()) {
+      std::cerr << "frustum mismatch: bvh " << visible.size() << ", linear " << linear_visible << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    // rays from the camera through random points of the scene
+    std::mt19937 random{7};
+    std::uniform_real_distribution<float> scene{-1000.0f, 1000.0f};
+    glm::fvec3 camera{0.0f, 200.0f, 900.0f};
+    std::vector<glm::fvec3> directions{};
+    std::vector<glm::fvec3> points{};
+    for (std::size_t i = 0; i < queries; ++i) {
+      glm::fvec3 target{scene(random), scene(random) * 0.02f, scene(random)};
+      directions.push_back(glm::normalize(target - camera));
+      points.push_back(target);
+    }
+
+    bvh::hit result{};
+    auto rays = bench::measure([&]() {
+      for (auto const& direction : directions) {
+        hierarchy.ray_query(camera, direction, bodies.spheres, result);
+        bench::do_not_optimize(result.distance);
+      }
+    }, 1, repetitions);
+    bench::print_row("ray x1000", count, bench::summarize(rays));
+
+    auto nearest = bench::measure([&]() {
+      for (auto const& point : points) {
+        hierarchy.nearest_query(point, bodies.spheres, result);
+        bench::do_not_optimize(result.distance);
+      }
+    }, 1, repetitions);
+    bench::print_row("nearest x1000", count, bench::summarize(nearest));
+
+    // single mouse pick as done by the application, cursor ray plus closest hit
+    std::uniform_real_distribution<float> cursor{0.0f, 1.0f};
+    std::vector<glm::fvec2> pixels{};
+    for (std::size_t i = 0; i < queries; ++i) {
+      pixels.push_back(glm::fvec2{cursor(random) * 960.0f, cursor(random) * 840.0f});
+    }
+    std::vector<double> picks{};
+    for (auto const& pixel : pixels) {
+      auto sample = bench::measure([&]() {
+        picking::ray ray = picking::screen_ray(pixel, glm::uvec2{960, 840}, projection, view);
+        hierarchy.ray_query(ray.origin, ray.direction, bodies.spheres, result);
+        bench::do_not_optimize(result.distance);
+      }, 0, 1);
+      picks.push_back(sample.front());
+    }
+    bench::print_row("pick", count, bench::summarize(picks));
+  }
+
+  return EXIT_SUCCESS;
+}
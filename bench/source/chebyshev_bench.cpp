@@ -0,0 +1,153 @@
+#include "bench_utils.hpp"
+#include "chebyshev.hpp"
+#include "ephemeris.hpp"
+#include "parallel.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/geometric.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+// chains of moons around moons, body d rotates around body d - 1 and has d + 1 levels
+static ephemeris::body_set moon_chain(unsigned depth) {
+  ephemeris::body_set set{};
+  ephemeris::body_orbit body{};
+  body.path = "root";
+  body.self_rotation = 0.5f;
+  body.radius = 0.5f;
+  float distance = 20.0f;
+  float speed = 0.1f;
+  for (unsigned d = 0; d <= depth; ++d) {
+    body.path += "/body" + std::to_string(d);
+    // tilted frames, so the chain does not collapse into one plane
+    glm::fmat4 tilt = glm::rotate(glm::fmat4{}, 0.2f * float(d), glm::fvec3{1.0f, 0.0f, 0.0f});
+    body.levels.push_back(ephemeris::orbit_level{tilt, speed, glm::fvec3{-distance, 0.0f, 0.0f}});
+    set.add(body);
+    distance *= 0.2f;
+    speed *= 1.6f;
+  }
+  return set;
+}
+
+static void print_throughput(std::string const& name, std::size_t count, bench::statistics const& stats) {
+  std::printf("%-32s %10zu %10.2f million lookups per second\n", name.c_str(), count, double(count) / stats.median / 1000.0);
+}
+
+int main(int argc, char* argv[]) {
+  // optional number of lookups, so quick runs can use fewer
+  std::size_t lookups = argc > 1 ? std::size_t(std::strtoull(argv[1], nullptr, 10)) : 1000000;
+  unsigned const depth = 4;
+  ephemeris::body_set chain = moon_chain(depth);
+
+  // random times in the window, independent of the samples the fit measured its bound at
+  std::mt19937 random{5};
+  std::uniform_real_distribution<double> window{0.0, 3600.0};
+  std::vector<double> times(lookups);
+  for (auto& time : times) {
+    time = window(random);
+  }
+
+  // ---- error of the tables against the analytic orbits ----
+  std::printf("%-20s %8s %10s %12s %14s %14s\n", "segment / degree", "fit ms", "memory kB", "body", "fitted bound", "random times");
+  std::size_t const check_count = std::min(lookups, std::size_t{100000});
+  bool bounded = true;
+  for (double segment_length : {2.0, 4.0, 8.0}) {
+    for (unsigned degree : {6u, 10u, 14u}) {
+      chebyshev::parameters params{};
+      params.segment_length = segment_length;
+      params.degree = degree;
+      chebyshev::table table{};
+      auto fit = bench::measure([&]() { table.fit(chain, params); }, 0, 1);
+
+      for (std::size_t b = 0; b < chain.size(); ++b) {
+        float error = 0.0f;
+        for (std::size_t i = 0; i < check_count; ++i) {
+          error = std::max(error, glm::distance(table.position(b, times[i]), chain.position(b, times[i])));
+        }
+        std::printf("%8.1f / %-9u %8.1f %10zu %12zu %14.3e %14.3e\n", segment_length, degree, fit.front(), table.bytes() / 1024, b,
+                    table.max_error(b), error);
+        bounded = bounded && error <= table.max_error(b);
+      }
+    }
+  }
+  std::printf("\n");
+  if (!bounded) {
+    std::cerr << "error at random times exceeds the fitted bound" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // ---- the table file gives back the same positions ----
+  chebyshev::table table{};
+  table.fit(chain, chebyshev::parameters{});
+  table.save("chebyshev_bench.table");
+  chebyshev::table loaded{};
+  loaded.load("chebyshev_bench.table");
+  std::remove("chebyshev_bench.table");
+  for (std::size_t b = 0; b < chain.size(); ++b) {
+    if (loaded.path(b) != table.path(b) || loaded.position(b, times[0]) != table.position(b, times[0])) {
+      std::cerr << "table file does not round trip" << std::endl;
+      return EXIT_FAILURE;
+    }
+    // default parameters must keep every body of the chain well below the rendered size of a moon
+    if (table.max_error(b) > 1e-3f) {
+      std::cerr << "default table too far from the analytic orbit of " << table.path(b) << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // ---- a table of other orbits or parameters has another hash, so a stale file is refitted ----
+  ephemeris::body_set changed = moon_chain(depth);
+  ephemeris::body_orbit moved = changed.orbit(depth);
+  moved.levels.back().speed *= 1.01f;
+  changed.clear();
+  for (std::size_t b = 0; b < chain.size(); ++b) {
+    changed.add(b == depth ? moved : chain.orbit(b));
+  }
+  chebyshev::parameters longer{};
+  longer.end *= 2.0;
+  if (loaded.source_hash() != chebyshev::hash(chain, chebyshev::parameters{})
+      || chebyshev::hash(changed, chebyshev::parameters{}) == loaded.source_hash()
+      || chebyshev::hash(chain, longer) == loaded.source_hash()) {
+    std::cerr << "table hash does not follow the orbits and parameters" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // ---- lookups per body depth, the table costs the same at every depth ----
+  bench::print_header();
+  std::vector<float> x(lookups);
+  std::vector<float> y(lookups);
+  std::vector<float> z(lookups);
+  for (std::size_t b = 0; b < chain.size(); ++b) {
+    std::string level = "depth " + std::to_string(b + 1);
+    auto analytic = bench::measure([&]() {
+      glm::fvec3 sum{0.0f};
+      for (double time : times) {
+        sum += chain.position(b, time);
+      }
+      bench::do_not_optimize(sum);
+    }, 1, 5);
+    auto batch = bench::measure([&]() {
+      chain.positions(b, times.data(), times.size(), x.data(), y.data(), z.data());
+      bench::do_not_optimize(x.back());
+    }, 1, 5);
+    auto lookup = bench::measure([&]() {
+      table.positions(b, times.data(), times.size(), x.data(), y.data(), z.data());
+      bench::do_not_optimize(x.back());
+    }, 1, 5);
+
+    bench::statistics analytic_stats = bench::summarize(analytic);
+    bench::statistics batch_stats = bench::summarize(batch);
+    bench::statistics lookup_stats = bench::summarize(lookup);
+    bench::print_row(level + " glm matrices", lookups, analytic_stats);
+    bench::print_row(level + " sse batch", lookups, batch_stats);
+    bench::print_row(level + " chebyshev table", lookups, lookup_stats);
+    print_throughput("  glm matrices", lookups, analytic_stats);
+    print_throughput("  sse batch", lookups, batch_stats);
+    print_throughput("  chebyshev table", lookups, lookup_stats);
+  }
+
+  return EXIT_SUCCESS;
+}
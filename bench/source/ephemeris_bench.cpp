@@ -0,0 +1,145 @@
+#include "bench_utils.hpp"
+#include "ephemeris.hpp"
+#include "parallel.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/geometric.hpp>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+// a sun with planets and moons built like the scene graph of the application, moons rotate around their planet
+static ephemeris::body_set solar_system(unsigned seed) {
+  std::mt19937 random{seed};
+  std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+  ephemeris::body_set set{};
+
+  ephemeris::body_orbit sun{};
+  sun.path = "root/sun_l/sun";
+  sun.levels.push_back(ephemeris::orbit_level{glm::fmat4{}, 0.0f, glm::fvec3{0.0f}});
+  sun.self_rotation = 0.5f;
+  sun.radius = 2.0f;
+  set.add(sun);
+
+  for (unsigned p = 0; p < 8; ++p) {
+    std::string name = "planet" + std::to_string(p);
+    ephemeris::orbit_level orbit{glm::fmat4{}, 0.05f + 0.2f * unit(random), glm::fvec3{-8.0f - 4.0f * float(p), 0.0f, 0.0f}};
+    ephemeris::body_orbit planet{};
+    planet.path = "root/" + name + "_h/" + name;
+    planet.levels.push_back(orbit);
+    planet.self_rotation = 0.4f + 0.4f * unit(random);
+    planet.radius = 0.4f + 0.6f * unit(random);
+    set.add(planet);
+
+    for (unsigned m = 0; m < p % 3; ++m) {
+      std::string moon_name = name + "_moon" + std::to_string(m);
+      ephemeris::body_orbit moon{};
+      moon.path = "root/" + name + "_h/" + moon_name + "_h/" + moon_name;
+      moon.levels.push_back(orbit);
+      // tilted local frames, so the batch evaluation has to apply the full matrix
+      glm::fmat4 tilt = glm::rotate(glm::fmat4{}, 0.3f * unit(random), glm::fvec3{1.0f, 0.0f, 0.0f});
+      moon.levels.push_back(ephemeris::orbit_level{tilt, 0.3f + 0.4f * unit(random), glm::fvec3{-1.5f - float(m), 0.0f, 0.0f}});
+      moon.self_rotation = 0.7f;
+      moon.radius = 0.2f;
+      set.add(moon);
+    }
+  }
+  return set;
+}
+
+static std::vector<std::string> all_paths(ephemeris::body_set const& set) {
+  std::vector<std::string> paths{};
+  for (std::size_t i = 0; i < set.size(); ++i) {
+    paths.push_back(set.orbit(i).path);
+  }
+  return paths;
+}
+
+static void print_throughput(std::string const& name, std::size_t count, bench::statistics const& stats) {
+  std::printf("%-32s %10zu %10.2f million samples per second\n", name.c_str(), count, double(count) / stats.median / 1000.0);
+}
+
+int main(int argc, char* argv[]) {
+  // optional largest number of times, so quick runs can skip the million timestamps
+  std::size_t max_times = argc > 1 ? std::size_t(std::strtoull(argv[1], nullptr, 10)) : 1000000;
+  std::printf("%u threads\n\n", parallel::thread_count());
+
+  ephemeris::body_set set = solar_system(3);
+  std::vector<std::string> paths = all_paths(set);
+
+  // ---- batch evaluation against the matrices the renderer computes ----
+  std::printf("%-32s %10s %16s %16s\n", "accuracy", "samples", "position error", "matrix error");
+  for (double span : {100.0, 10000.0, 1000000.0}) {
+    std::vector<double> times(std::min(max_times, std::size_t{10000}));
+    for (std::size_t t = 0; t < times.size(); ++t) {
+      times[t] = span * double(t) / double(times.size());
+    }
+    ephemeris::columns result = set.query(paths, times, true);
+
+    double position_error = 0.0;
+    double matrix_error = 0.0;
+    for (std::size_t b = 0; b < result.bodies; ++b) {
+      for (std::size_t t = 0; t < result.times; ++t) {
+        std::size_t sample = b * result.times + t;
+        glm::fmat4 reference = set.transform(b, times[t]);
+        glm::fvec3 position{result.x[sample], result.y[sample], result.z[sample]};
+        position_error = std::max(position_error, double(glm::distance(position, glm::fvec3{reference[3]})));
+        for (int c = 0; c < 16; ++c) {
+          matrix_error = std::max(matrix_error, double(std::abs(result.matrix[c][sample] - reference[c / 4][c % 4])));
+        }
+      }
+    }
+    std::printf("%-32s %10zu %16.3e %16.3e\n", ("times up to " + std::to_string(long(span))).c_str(),
+                result.bodies * result.times, position_error, matrix_error);
+    // the outermost planets are 40 units away, the sse sine keeps them well within a thousandth
+    if (position_error > 1e-3 || matrix_error > 1e-3) {
+      std::cerr << "batch ephemeris too far from the reference matrices" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  std::printf("\n");
+
+  // ---- all bodies at many times ----
+  bench::print_header();
+  for (std::size_t count = 1000; count <= max_times; count *= 10) {
+    unsigned repetitions = count >= 1000000 ? 3 : count >= 100000 ? 10 : 50;
+    std::vector<double> times(count);
+    for (std::size_t t = 0; t < count; ++t) {
+      times[t] = 0.01 * double(t);
+    }
+    std::size_t samples = paths.size() * count;
+    ephemeris::columns result{};
+
+    auto reference = bench::measure([&]() {
+      glm::fvec3 sum{0.0f};
+      for (std::size_t b = 0; b < set.size(); ++b) {
+        for (double time : times) {
+          sum += set.position(b, time);
+        }
+      }
+      bench::do_not_optimize(sum);
+    }, 1, repetitions);
+    auto positions = bench::measure([&]() {
+      set.query(paths, times, false, result);
+      bench::do_not_optimize(result.x.back());
+    }, 1, repetitions);
+    auto matrices = bench::measure([&]() {
+      set.query(paths, times, true, result);
+      bench::do_not_optimize(result.matrix[15].back());
+    }, 1, repetitions);
+
+    bench::statistics reference_stats = bench::summarize(reference);
+    bench::statistics position_stats = bench::summarize(positions);
+    bench::statistics matrix_stats = bench::summarize(matrices);
+    bench::print_row("glm matrices, one thread", samples, reference_stats);
+    bench::print_row("batch positions", samples, position_stats);
+    bench::print_row("batch positions and matrices", samples, matrix_stats);
+    print_throughput("  glm matrices", samples, reference_stats);
+    print_throughput("  batch positions", samples, position_stats);
+    print_throughput("  batch matrices", samples, matrix_stats);
+  }
+
+  return EXIT_SUCCESS;
+}
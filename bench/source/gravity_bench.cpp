@@ -0,0 +1,141 @@
+#include "bench_utils.hpp"
+#include "gravity_compute.hpp"
+#include "nbody.hpp"
+#include "parallel.hpp"
+#include "shader_loader.hpp"
+#include "utils.hpp"
+
+#include <glbinding/gl/gl.h>
+#include <glbinding/Binding.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+// dont load gl bindings from glfw
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+#include <glm/gtc/constants.hpp>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+// a heavy center with a disc of dust, like the gravity cloud of the solar system
+static std::vector<gravity_compute::particle> dust_disc(std::size_t count, unsigned seed) {
+  std::mt19937 random{seed};
+  std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+  std::vector<gravity_compute::particle> particles{};
+  particles.push_back(gravity_compute::particle{glm::fvec4{0.0f, 0.0f, 0.0f, 25.0f}, glm::fvec4{0.0f}});
+  for (std::size_t i = 1; i < count; ++i) {
+    float radius = 3.0f + 4.0f * unit(random);
+    float angle = glm::two_pi<float>() * unit(random);
+    float speed = std::sqrt(25.0f / radius);
+    particles.push_back(gravity_compute::particle{
+        glm::fvec4{radius * std::cos(angle), 0.1f * (unit(random) - 0.5f), radius * std::sin(angle), 0.25f / float(count)},
+        glm::fvec4{-speed * std::sin(angle), 0.0f, speed * std::cos(angle), 0.03f}});
+  }
+  return particles;
+}
+
+static void add_particles(nbody::simulation& simulation, std::vector<gravity_compute::particle> const& particles) {
+  simulation.clear();
+  for (auto const& particle : particles) {
+    simulation.add(particle.position_mass.w, glm::dvec3{glm::fvec3{particle.position_mass}},
+                   glm::dvec3{glm::fvec3{particle.velocity_radius}});
+  }
+}
+
+int main(int argc, char* argv[]) {
+  // first argument is the resource path like for the applications, the second the largest particle count
+  std::string resource_path = utils::read_resource_path(argc, argv);
+  std::size_t max_count = argc > 2 ? std::size_t(std::strtoull(argv[2], nullptr, 10)) : 65536;
+
+  // compute shaders need a context, an invisible window provides it
+  if (!glfwInit()) {
+    return EXIT_FAILURE;
+  }
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_VISIBLE, 0);
+  GLFWwindow* window = glfwCreateWindow(64, 64, "gravity_bench", NULL, NULL);
+  if (!window) {
+    std::cerr << "no OpenGL 4.3 context" << std::endl;
+    glfwTerminate();
+    return EXIT_FAILURE;
+  }
+  glfwMakeContextCurrent(window);
+  glbinding::Binding::initialize();
+  if (!utils::supports(4, 3, GLextension::GL_ARB_compute_shader)) {
+    std::cerr << "compute shaders not supported" << std::endl;
+    glfwTerminate();
+    return EXIT_FAILURE;
+  }
+  std::printf("%s, %u cpu threads\n\n", reinterpret_cast<char const*>(glGetString(GL_RENDERER)), parallel::thread_count());
+
+  shader_program program{{{GL_COMPUTE_SHADER, resource_path + "shaders/gravity.comp"}}};
+  program.handle = shader_loader::program(program.shader_paths);
+  for (char const* name : {"Count", "TimeStep", "Gravity", "Softening", "Stage"}) {
+    program.u_locs[name] = utils::glGetUniformLocation(program.handle, name);
+  }
+
+  float const dt = 1.0f / 60.0f;
+  std::size_t pairs_crossover = 0;
+  std::size_t tree_crossover = 0;
+  bench::print_header();
+  for (std::size_t count = 256; count <= max_count; count *= 2) {
+    unsigned repetitions = count >= 16384 ? 3 : 10;
+    std::vector<gravity_compute::particle> particles = dust_disc(count, 9);
+
+    // gpu steps are waited for, so the time covers the whole step like on the cpu
+    gravity_compute gpu{1.0f, 0.05f};
+    gpu.upload(program, particles, glm::fvec4{0.0f});
+    bench::statistics gpu_stats = bench::summarize(bench::measure([&]() {
+      gpu.step(program, dt);
+      glFinish();
+    }, 2, repetitions));
+    bench::print_row("gpu all pairs", count, gpu_stats);
+
+    nbody::parameters pairs_params{};
+    pairs_params.opening_angle = 0.0;
+    pairs_params.softening = 0.05;
+    nbody::simulation pairs{pairs_params};
+    add_particles(pairs, particles);
+    bench::statistics pairs_stats = bench::summarize(bench::measure([&]() {
+      pairs.step(dt);
+      bench::do_not_optimize(pairs.position(count / 2));
+    }, 1, repetitions));
+    bench::print_row("cpu all pairs", count, pairs_stats);
+
+    nbody::parameters tree_params{};
+    tree_params.softening = 0.05;
+    nbody::simulation tree{tree_params};
+    add_particles(tree, particles);
+    bench::statistics tree_stats = bench::summarize(bench::measure([&]() {
+      tree.step(dt);
+      bench::do_not_optimize(tree.position(count / 2));
+    }, 1, repetitions));
+    bench::print_row("cpu barnes hut", count, tree_stats);
+
+    // smallest count from which on the gpu stays faster
+    pairs_crossover = gpu_stats.median < pairs_stats.median ? (pairs_crossover ? pairs_crossover : count) : 0;
+    tree_crossover = gpu_stats.median < tree_stats.median ? (tree_crossover ? tree_crossover : count) : 0;
+  }
+
+  std::printf("\n");
+  auto print_crossover = [&](char const* name, std::size_t crossover) {
+    if (crossover > 0) {
+      std::printf("gpu faster than the %s cpu integrator from %zu particles on\n", name, crossover);
+    } else {
+      std::printf("gpu not faster than the %s cpu integrator up to %zu particles\n", name, max_count);
+    }
+  };
+  print_crossover("all pairs", pairs_crossover);
+  print_crossover("barnes hut", tree_crossover);
+
+  glDeleteProgram(program.handle);
+  glfwDestroyWindow(window);
+  glfwTerminate();
+  return EXIT_SUCCESS;
+}
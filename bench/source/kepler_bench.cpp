@@ -0,0 +1,118 @@
+#include "bench_utils.hpp"
+#include "kepler.hpp"
+
+#include <glm/gtc/constants.hpp>
+#include <glm/geometric.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+// random inclined orbits with eccentricities up to max_eccentricity
+static std::vector<kepler::elements> random_orbits(std::size_t count, float max_eccentricity, unsigned seed) {
+  std::mt19937 random{seed};
+  std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+  std::vector<kepler::elements> orbits{};
+  orbits.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    kepler::elements orbit{};
+    orbit.semi_major_axis = 5.0f + 45.0f * unit(random);
+    orbit.eccentricity = max_eccentricity * unit(random);
+    orbit.inclination = glm::pi<float>() * unit(random);
+    orbit.ascending_node = glm::two_pi<float>() * unit(random);
+    orbit.periapsis = glm::two_pi<float>() * unit(random);
+    orbit.mean_anomaly = glm::two_pi<float>() * unit(random);
+    orbit.mean_motion = 0.2f * std::pow(5.0f / orbit.semi_major_axis, 1.5f);
+    orbits.push_back(orbit);
+  }
+  return orbits;
+}
+
+static void print_throughput(std::string const& name, std::size_t count, bench::statistics const& stats) {
+  std::printf("%-32s %10zu %10.2f million bodies per second\n", name.c_str(), count, double(count) / stats.median / 1000.0);
+}
+
+int main(int argc, char* argv[]) {
+  // optional largest body count, so quick runs can skip the million bodies
+  std::size_t max_count = argc > 1 ? std::size_t(std::strtoull(argv[1], nullptr, 10)) : 1000000;
+
+  // ---- accuracy of the vectorized float propagation against the double reference ----
+  std::size_t const accuracy_count = std::min(max_count, std::size_t{100000});
+  double const times[] = {0.0, 10.0, 1000.0, 100000.0};
+  std::printf("%-32s %10s %16s\n", "accuracy", "count", "max error / a");
+  for (float eccentricity : {0.0f, 0.1f, 0.5f, 0.9f, 0.97f}) {
+    std::vector<kepler::elements> orbits = random_orbits(accuracy_count, eccentricity, 3);
+    kepler::orbit_set set{};
+    for (auto const& orbit : orbits) {
+      set.push_back(orbit);
+    }
+
+    double max_error = 0.0;
+    std::vector<glm::fvec3> positions(orbits.size());
+    for (double time : times) {
+      set.propagate(time, 0, set.size(), &positions[0].x, 3);
+      for (std::size_t i = 0; i < orbits.size(); ++i) {
+        glm::dvec3 position{};
+        glm::dvec3 velocity{};
+        kepler::state(orbits[i], time, position, velocity);
+        double error = glm::length(glm::dvec3{positions[i]} - position) / double(orbits[i].semi_major_axis);
+        max_error = std::max(max_error, error);
+      }
+    }
+    std::printf("%-32s %10zu %16.3e\n", ("e up to " + std::to_string(eccentricity).substr(0, 4)).c_str(),
+                accuracy_count, max_error);
+    // a few float ulps of the orbit size
+    if (max_error > 1e-5) {
+      std::cerr << "kepler accuracy too low for eccentricity " << eccentricity << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  std::printf("\n");
+
+  // ---- throughput of the vectorized propagation and of the double reference ----
+  bench::print_header();
+  for (std::size_t count = 10000; count <= max_count; count *= 10) {
+    unsigned repetitions = count >= 1000000 ? 10 : 50;
+    std::vector<kepler::elements> orbits = random_orbits(count, 0.3f, 5);
+    kepler::orbit_set set{};
+    set.reserve(count);
+    for (auto const& orbit : orbits) {
+      set.push_back(orbit);
+    }
+    std::vector<glm::fvec3> positions(count);
+    double time = 0.0;
+
+    auto simd = bench::measure([&]() {
+      time += 1.0 / 60.0;
+      set.propagate(time, 0, count, &positions[0].x, 3);
+      bench::do_not_optimize(positions[count / 2]);
+    }, 1, repetitions);
+    bench::statistics simd_stats = bench::summarize(simd);
+    bench::print_row("propagate one core", count, simd_stats);
+    print_throughput("  per core", count, simd_stats);
+
+    auto parallel = bench::measure([&]() {
+      time += 1.0 / 60.0;
+      set.propagate(time, positions);
+      bench::do_not_optimize(positions[count / 2]);
+    }, 1, repetitions);
+    bench::print_row("propagate all cores", count, bench::summarize(parallel));
+
+    // the reference solves to full double precision, it shows what the vectorization gains
+    std::size_t reference_count = std::min(count, std::size_t{100000});
+    auto reference = bench::measure([&]() {
+      time += 1.0 / 60.0;
+      glm::dvec3 position{};
+      glm::dvec3 velocity{};
+      for (std::size_t i = 0; i < reference_count; ++i) {
+        kepler::state(orbits[i], time, position, velocity);
+        bench::do_not_optimize(position);
+      }
+    }, 1, repetitions);
+    bench::statistics reference_stats = bench::summarize(reference);
+    bench::print_row("scalar reference", reference_count, reference_stats);
+    print_throughput("  per core", reference_count, reference_stats);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,224 @@
+#include "bench_utils.hpp"
+#include "chebyshev.hpp"
+#include "ephemeris.hpp"
+#include "GeometryNode.hpp"
+#include "headless.hpp"
+#include "icosphere.hpp"
+#include "model_loader.hpp"
+#include "scene_generator.hpp"
+#include "shader_loader.hpp"
+#include "texture_loader.hpp"
+#include "utils.hpp"
+
+#include <glbinding/gl/gl.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// the loaders read whole files, fewer repetitions than the math below
+static unsigned const file_warmup = 2;
+static unsigned const math_warmup = 20;
+// time the bodies are transformed at, inside the window of the orbit table
+static double const frame_time = 100.0;
+
+// shader programs of the application, each from a vertex and a fragment shader
+static std::vector<std::string> const program_names{"planet", "impostor", "asteroid", "sun", "orbits", "stars",
+                                                    "skybox", "screenquad"};
+
+// value of an option at position i, which moves past it
+static std::size_t read_count(int& i, int argc, char* argv[]) {
+  if (i + 1 >= argc) {
+    throw std::logic_error(std::string{"loader_bench: "} + argv[i] + " needs a value");
+  }
+  return std::size_t(std::strtoull(argv[++i], nullptr, 10));
+}
+
+// the sun of the generated scenes of the application, with the same planets and moons from the scene generator,
+// textures are not loaded
+static std::shared_ptr<Node> generated_scene(std::size_t planets, unsigned moons_per_planet, unsigned seed) {
+  auto root = std::make_shared<Node>(nullptr, "root", "root", 0, nullptr);
+  auto sun_holder = std::make_shared<Node>(root, "sun_l", "root/sun_l", 1, nullptr);
+  auto sun = std::make_shared<GeometryNode>(sun_holder, "sun", "root/sun_l/sun", 2, nullptr);
+  sun->setRadius(2.0f);
+  sun->setSelfRotation(0.5f);
+  root->addChildren(sun_holder);
+  sun_holder->addChildren(sun);
+  scene_generator::add_planets(*root, root, sun, model{}, "", planets, moons_per_planet, seed);
+  return root;
+}
+
+// planets and moons without their holders, in the order the renderer draws them
+static void collect_bodies(Node const& node, std::vector<std::shared_ptr<Node>>& bodies) {
+  for (auto const& child : node.getChildrenList()) {
+    collect_bodies(*child, bodies);
+    if (child->getDepth() == 2 || child->getDepth() == 4) {
+      bodies.push_back(child);
+    }
+  }
+}
+
+static void bench_models(std::string const& resource_path, unsigned repetitions) {
+  std::string const sphere_path = resource_path + "models/sphere.obj";
+  std::string const skybox_path = resource_path + "models/skybox.obj";
+  model sphere = model_loader::obj(sphere_path, model::NORMAL | model::TEXCOORD);
+  std::size_t sphere_vertices = sphere.vertex_num;
+
+  bench::print_row("obj sphere position", sphere_vertices, bench::summarize(bench::measure([&] {
+    bench::do_not_optimize(model_loader::obj(sphere_path, model::POSITION).data.data());
+  }, file_warmup, repetitions)));
+  bench::print_row("obj sphere normal texcoord", sphere_vertices, bench::summarize(bench::measure([&] {
+    bench::do_not_optimize(model_loader::obj(sphere_path, model::NORMAL | model::TEXCOORD).data.data());
+  }, file_warmup, repetitions)));
+  bench::print_row("obj sphere tangent space", sphere_vertices, bench::summarize(bench::measure([&] {
+    model tangent_space = model_loader::obj(sphere_path,
+                                            model::NORMAL | model::TEXCOORD | model::TANGENT | model::BITANGENT);
+    bench::do_not_optimize(tangent_space.data.data());
+  }, file_warmup, repetitions)));
+  bench::print_row("obj skybox", 0, bench::summarize(bench::measure([&] {
+    bench::do_not_optimize(model_loader::obj(skybox_path, model::NORMAL).data.data());
+  }, file_warmup, repetitions)));
+
+  // interleaving the loaded buffers into a model, as done again for every pool and planet model
+  bench::print_row("model from sphere data", sphere_vertices, bench::summarize(bench::measure([&] {
+    model copy{sphere.data, model::NORMAL | model::TEXCOORD, sphere.indices};
+    bench::do_not_optimize(copy.data.data());
+  }, math_warmup, repetitions)));
+  std::size_t icosphere_vertices = icosphere::generate(5).vertex_num;
+  bench::print_row("icosphere 5 subdivisions", icosphere_vertices, bench::summarize(bench::measure([&] {
+    bench::do_not_optimize(icosphere::generate(5).data.data());
+  }, file_warmup, repetitions)));
+  std::vector<icosphere::level> levels{};
+  bench::print_row("icosphere levels 0 to 6", 7, bench::summarize(bench::measure([&] {
+    bench::do_not_optimize(icosphere::generate_levels(0, 6, levels).data.data());
+  }, file_warmup, repetitions)));
+}
+
+static void bench_textures(std::string const& resource_path, unsigned repetitions) {
+  std::vector<std::string> const files{"earthmap.png", "sunmap.png", "earthnormal.png", "skybox_up.png",
+                                       "saturnringcolor.jpg"};
+  for (auto const& file : files) {
+    std::string path = resource_path + "textures/" + file;
+    pixel_data image = texture_loader::file(path);
+    bench::print_row("decode " + file, image.width * image.height, bench::summarize(bench::measure([&] {
+      bench::do_not_optimize(texture_loader::file(path).pixels.data());
+    }, file_warmup, repetitions)));
+  }
+
+  // texture array layers of the generated scenes are resized to a common size
+  pixel_data earth = texture_loader::file(resource_path + "textures/earthmap.png");
+  for (std::size_t width : {1024u, 512u, 256u}) {
+    std::vector<double> samples = bench::measure([&] {
+      bench::do_not_optimize(texture_loader::resize(earth, width, width / 2).pixels.data());
+    }, math_warmup, repetitions);
+    bench::print_row("resize earthmap " + std::to_string(width), width * width / 2, bench::summarize(samples));
+  }
+}
+
+static void bench_transforms(std::size_t planets, unsigned moons_per_planet, unsigned repetitions) {
+  std::shared_ptr<Node> root = generated_scene(planets, moons_per_planet, 1);
+  std::vector<std::shared_ptr<Node>> bodies{};
+  collect_bodies(*root, bodies);
+  std::size_t count = bodies.size();
+
+  ephemeris::body_set orbits{};
+  bench::print_row("orbits from scene graph", count, bench::summarize(bench::measure([&] {
+    orbits.clear();
+    for (auto const& body : bodies) {
+      orbits.add(ephemeris::orbit_of(*body));
+    }
+  }, math_warmup, repetitions)));
+
+  // what transformPlanet does for every body in a frame
+  std::vector<glm::fmat4> matrices(count);
+  bench::print_row("orbit chain transforms", count, bench::summarize(bench::measure([&] {
+    for (std::size_t i = 0; i < count; ++i) {
+      matrices[i] = orbits.transform(i, frame_time);
+    }
+    bench::do_not_optimize(matrices.data());
+  }, math_warmup, repetitions)));
+
+  chebyshev::parameters window{};
+  window.start = frame_time - 10.0;
+  window.end = frame_time + 10.0;
+  chebyshev::table table{};
+  table.fit(orbits, window);
+  bench::print_row("orbit table transforms", count, bench::summarize(bench::measure([&] {
+    for (std::size_t i = 0; i < count; ++i) {
+      matrices[i] = ephemeris::place(orbits.orbit(i), table.position(i, frame_time), frame_time);
+    }
+    bench::do_not_optimize(matrices.data());
+  }, math_warmup, repetitions)));
+}
+
+static void bench_shaders(std::string const& resource_path, unsigned repetitions) {
+  // reading the sources needs no context
+  bench::print_row("read shader sources", 2 * program_names.size(), bench::summarize(bench::measure([&] {
+    for (auto const& name : program_names) {
+      bench::do_not_optimize(utils::read_file(resource_path + "shaders/" + name + ".vert").size());
+      bench::do_not_optimize(utils::read_file(resource_path + "shaders/" + name + ".frag").size());
+    }
+  }, math_warmup, repetitions)));
+
+  // compiling and linking needs a context, the offscreen one of the headless mode
+  if (!headless::available()) {
+    std::printf("%-32s skipped, built without an offscreen context\n", "compile and link programs");
+    return;
+  }
+  try {
+    headless::initialize(glm::uvec2{64u, 64u}, 3, 2);
+  } catch (std::exception const& error) {
+    std::printf("%-32s skipped, %s\n", "compile and link programs", error.what());
+    return;
+  }
+  // drivers may cache programs they compiled before, the first repetition is the cold one
+  for (auto const& name : program_names) {
+    std::map<GLenum, std::string> stages{{GL_VERTEX_SHADER, resource_path + "shaders/" + name + ".vert"},
+                                         {GL_FRAGMENT_SHADER, resource_path + "shaders/" + name + ".frag"}};
+    bench::print_row("program " + name, 2, bench::summarize(bench::measure([&] {
+      GLuint program = shader_loader::program(stages);
+      glDeleteProgram(program);
+    }, 0, repetitions)));
+  }
+  headless::close_and_quit(EXIT_SUCCESS);
+}
+
+int main(int argc, char* argv[]) {
+  unsigned repetitions = 20;
+  std::size_t planets = 512;
+  unsigned moons_per_planet = 4;
+
+  int kept = 1;
+  for (int i = 1; i < argc; ++i) {
+    std::string argument{argv[i]};
+    if (argument == "--repetitions") {
+      repetitions = unsigned(read_count(i, argc, argv));
+    } else if (argument == "--planets") {
+      planets = read_count(i, argc, argv);
+    } else if (argument == "--moons") {
+      moons_per_planet = unsigned(read_count(i, argc, argv));
+    } else {
+      argv[kept++] = argv[i];
+    }
+  }
+  argc = kept;
+  if (repetitions == 0) {
+    throw std::logic_error("loader_bench: at least one repetition must be measured");
+  }
+  std::string resource_path = utils::read_resource_path(argc, argv);
+
+  bench::print_header();
+  bench_models(resource_path, repetitions);
+  bench_textures(resource_path, repetitions);
+  bench_transforms(planets, moons_per_planet, repetitions);
+  // last, it ends the process when it created a context
+  bench_shaders(resource_path, repetitions);
+  return EXIT_SUCCESS;
+}
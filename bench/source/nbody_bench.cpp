@@ -0,0 +1,174 @@
+#include "bench_utils.hpp"
+#include "nbody.hpp"
+#include "parallel.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// a star with a thin disc of light particles on circular orbits, like the sun with planets and asteroids
+static void disc(nbody::simulation& simulation, std::size_t count, unsigned seed) {
+  std::mt19937 random{seed};
+  std::uniform_real_distribution<double> unit{0.0, 1.0};
+  simulation.clear();
+  simulation.reserve(count);
+  double const star_mass = 1.0;
+  simulation.add(star_mass, glm::dvec3{0.0}, glm::dvec3{0.0});
+  // the disc together weighs a thousandth of the star
+  double particle_mass = 1e-3 / double(count);
+  for (std::size_t i = 1; i < count; ++i) {
+    double radius = 1.0 + 4.0 * unit(random);
+    double angle = glm::two_pi<double>() * unit(random);
+    double height = 0.02 * (unit(random) - 0.5);
+    double speed = std::sqrt(star_mass / radius);
+    simulation.add(particle_mass, glm::dvec3{radius * std::cos(angle), height, radius * std::sin(angle)},
+                   glm::dvec3{-speed * std::sin(angle), 0.0, speed * std::cos(angle)});
+  }
+}
+
+// a star with planets whose moons orbit three times farther out than the hill sphere, like the moons of the scene,
+// the moons are free particles or bound to their planet, returns the start distances of the moons
+static std::vector<double> planets_with_moons(nbody::simulation& simulation, std::size_t planets, bool bound) {
+  simulation.clear();
+  std::vector<double> distances{};
+  double const star_mass = 1.0;
+  double const planet_mass = 1e-4;
+  simulation.add(star_mass, glm::dvec3{0.0}, glm::dvec3{0.0});
+  for (std::size_t p = 0; p < planets; ++p) {
+    double radius = 1.0 + 0.3 * double(p);
+    double angle = 2.4 * double(p);
+    glm::dvec3 direction{std::cos(angle), 0.0, std::sin(angle)};
+    glm::dvec3 tangent{-direction.z, 0.0, direction.x};
+    glm::dvec3 position = radius * direction;
+    glm::dvec3 velocity = std::sqrt(star_mass / radius) * tangent;
+    std::size_t planet = simulation.add(planet_mass, position, velocity);
+
+    double hill_radius = radius * std::cbrt(planet_mass / (3.0 * star_mass));
+    double distance = 3.0 * hill_radius;
+    distances.push_back(distance);
+    glm::dvec3 moon_position = position + distance * direction;
+    glm::dvec3 moon_velocity = velocity + std::sqrt(planet_mass / distance) * tangent;
+    if (bound) {
+      simulation.add(1e-3 * planet_mass, moon_position, moon_velocity, planet);
+    }
+    else {
+      simulation.add(1e-3 * planet_mass, moon_position, moon_velocity);
+    }
+  }
+  return distances;
+}
+
+// moons with positive energy relative to their planet or twice their start distance from it
+static std::size_t escaped_moons(nbody::simulation const& simulation, std::vector<double> const& start_distances) {
+  std::size_t escaped = 0;
+  for (std::size_t m = 0; m < start_distances.size(); ++m) {
+    // planets and moons alternate after the star
+    std::size_t planet = 1 + 2 * m;
+    std::size_t moon = planet + 1;
+    double distance = glm::distance(simulation.position(moon), simulation.position(planet));
+    glm::dvec3 velocity = simulation.velocity(moon) - simulation.velocity(planet);
+    double energy = 0.5 * glm::dot(velocity, velocity) - simulation.params().gravity * simulation.mass(planet) / distance;
+    if (energy >= 0.0 || distance > 2.0 * start_distances[m]) {
+      ++escaped;
+    }
+  }
+  return escaped;
+}
+
+static void print_throughput(std::string const& name, std::size_t count, bench::statistics const& stats) {
+  std::printf("%-32s %10zu %10.3f million particles per second\n", name.c_str(), count, double(count) / stats.median / 1000.0);
+}
+
+int main(int argc, char* argv[]) {
+  // optional largest particle count, so quick runs can skip the million particles
+  std::size_t max_count = argc > 1 ? std::size_t(std::strtoull(argv[1], nullptr, 10)) : 1000000;
+  std::printf("%u threads\n\n", parallel::thread_count());
+
+  // ---- potential energy of the octree against the sum over all pairs ----
+  std::size_t const accuracy_count = std::min(max_count, std::size_t{10000});
+  nbody::parameters exact_params{};
+  exact_params.opening_angle = 0.0;
+  nbody::simulation exact{exact_params};
+  disc(exact, accuracy_count, 3);
+  double exact_potential = exact.energy().potential;
+  std::printf("%-32s %10s %16s\n", "accuracy", "count", "potential error");
+  for (double angle : {0.3, 0.5, 0.7, 1.0}) {
+    nbody::parameters params{};
+    params.opening_angle = angle;
+    nbody::simulation tree{params};
+    disc(tree, accuracy_count, 3);
+    double error = std::abs(tree.energy().potential / exact_potential - 1.0);
+    std::printf("%-32s %10zu %16.3e\n", ("opening angle " + std::to_string(angle).substr(0, 3)).c_str(),
+                accuracy_count, error);
+    // the default angle must stay well below a percent
+    if (angle <= 0.5 && error > 1e-2) {
+      std::cerr << "octree potential too far from the exact sum for opening angle " << angle << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  std::printf("\n");
+
+  // ---- drift of the total energy over many leapfrog steps ----
+  std::printf("%-32s %10s %10s %16s\n", "energy drift", "count", "steps", "relative drift");
+  for (double angle : {0.0, 0.5}) {
+    std::size_t const drift_count = std::min(max_count, std::size_t{1000});
+    unsigned const steps = 2000;
+    nbody::parameters params{};
+    params.opening_angle = angle;
+    nbody::simulation simulation{params};
+    disc(simulation, drift_count, 7);
+    simulation.energy();
+    // the innermost orbit takes about 630 steps
+    for (unsigned step = 0; step < steps; ++step) {
+      simulation.step(0.01);
+    }
+    std::printf("%-32s %10zu %10u %16.3e\n", (angle == 0.0 ? "all pairs" : "opening angle 0.5"), drift_count,
+                steps, simulation.energy().drift);
+  }
+  std::printf("\n");
+
+  // ---- moons outside the hill sphere stay with their planets only when bound to them ----
+  std::printf("%-32s %10s %10s %16s %10s\n", "moons", "planets", "steps", "relative drift", "escaped");
+  for (bool bound : {false, true}) {
+    std::size_t const planets = 8;
+    unsigned const steps = 5000;
+    nbody::parameters params{};
+    params.softening = 1e-4;
+    nbody::simulation simulation{params};
+    std::vector<double> distances = planets_with_moons(simulation, planets, bound);
+    simulation.energy();
+    // the innermost planet turns about eight times and its moon about three times
+    for (unsigned step = 0; step < steps; ++step) {
+      simulation.step(0.01);
+    }
+    std::size_t escaped = escaped_moons(simulation, distances);
+    std::printf("%-32s %10zu %10u %16.3e %10zu\n", (bound ? "bound to planet" : "free particles"), planets, steps,
+                simulation.energy().drift, escaped);
+    if (bound && escaped > 0) {
+      std::cerr << "moons bound to their planets escaped" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  std::printf("\n");
+
+  // ---- time of a step with the default opening angle ----
+  bench::print_header();
+  for (std::size_t count = 1000; count <= max_count; count *= 10) {
+    unsigned repetitions = count >= 1000000 ? 2 : count >= 100000 ? 5 : 20;
+    nbody::simulation simulation{};
+    disc(simulation, count, 5);
+    auto step = bench::measure([&]() {
+      simulation.step(0.01);
+      bench::do_not_optimize(simulation.position(count / 2));
+    }, 1, repetitions);
+    bench::statistics stats = bench::summarize(step);
+    bench::print_row("leapfrog step", count, stats);
+    print_throughput("  all cores", count, stats);
+  }
+
+  return EXIT_SUCCESS;
+}
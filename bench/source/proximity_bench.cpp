@@ -0,0 +1,164 @@
+#include "bench_utils.hpp"
+#include "kepler.hpp"
+#include "parallel.hpp"
+#include "proximity.hpp"
+
+#include <glm/gtc/constants.hpp>
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+// simulated seconds per update, moves the inner bodies by about a tenth of their radius
+static double const frame_time = 0.05;
+
+// bodies on crossing inclined orbits in a thick belt, radii shrink with the count so the contacts per body stay similar
+static kepler::orbit_set belt(std::size_t count, unsigned seed, std::vector<float>& radii) {
+  std::mt19937 random{seed};
+  std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+  kepler::orbit_set orbits{};
+  orbits.reserve(count);
+  radii.resize(count);
+  float const mean_radius = 0.2f * std::sqrt(10000.0f / float(count));
+  for (std::size_t i = 0; i < count; ++i) {
+    kepler::elements orbit{};
+    orbit.semi_major_axis = 10.0f + 40.0f * unit(random);
+    orbit.eccentricity = 0.2f * unit(random);
+    orbit.inclination = 0.2f * (2.0f * unit(random) - 1.0f);
+    orbit.ascending_node = glm::two_pi<float>() * unit(random);
+    orbit.periapsis = glm::two_pi<float>() * unit(random);
+    orbit.mean_anomaly = glm::two_pi<float>() * unit(random);
+    orbit.mean_motion = 0.2f * std::pow(10.0f / orbit.semi_major_axis, 1.5f);
+    orbits.push_back(orbit);
+    radii[i] = mean_radius * (0.5f + unit(random));
+  }
+  return orbits;
+}
+
+static void spheres_at(kepler::orbit_set const& orbits, std::vector<float> const& radii, double time,
+                       std::vector<glm::fvec3>& positions, culling::sphere_batch& spheres) {
+  orbits.propagate(time, positions);
+  spheres.clear();
+  for (std::size_t i = 0; i < positions.size(); ++i) {
+    spheres.push_back(positions[i], radii[i]);
+  }
+}
+
+// all pairs with the same narrow phase, the reference for the sweep
+static std::vector<proximity::contact> brute_force(culling::sphere_batch const& previous, culling::sphere_batch const& current,
+                                                   float margin) {
+  std::vector<proximity::contact> contacts{};
+  for (std::uint32_t a = 0; a < current.size(); ++a) {
+    for (std::uint32_t b = a + 1; b < current.size(); ++b) {
+      glm::fvec3 start{previous.x[b] - previous.x[a], previous.y[b] - previous.y[a], previous.z[b] - previous.z[a]};
+      glm::fvec3 end{current.x[b] - current.x[a], current.y[b] - current.y[a], current.z[b] - current.z[a]};
+      glm::fvec3 motion = end - start;
+      float motion_squared = glm::dot(motion, motion);
+      float time = motion_squared > 0.0f ? glm::clamp(-glm::dot(start, motion) / motion_squared, 0.0f, 1.0f) : 1.0f;
+      float distance = glm::length(start + time * motion) - current.radius[a] - current.radius[b];
+      if (distance <= margin) {
+        contacts.push_back(proximity::contact{a, b, distance, time});
+      }
+    }
+  }
+  return contacts;
+}
+
+int main(int argc, char* argv[]) {
+  // optional largest body count, so quick runs can skip the million bodies
+  std::size_t max_count = argc > 1 ? std::size_t(std::strtoull(argv[1], nullptr, 10)) : 1000000;
+  std::printf("%u threads\n\n", parallel::thread_count());
+
+  // ---- the sweep finds exactly the pairs of the all pairs test ----
+  {
+    std::size_t const count = std::min(max_count, std::size_t{3000});
+    std::vector<float> radii{};
+    kepler::orbit_set orbits = belt(count, 3, radii);
+    std::vector<glm::fvec3> positions{};
+    culling::sphere_batch previous{};
+    culling::sphere_batch current{};
+    proximity::parameters params{};
+    params.margin = 0.05f;
+    proximity::detector detector{params};
+
+    std::size_t contacts = 0;
+    std::size_t events = 0;
+    for (unsigned frame = 0; frame < 20; ++frame) {
+      spheres_at(orbits, radii, frame * frame_time * 20.0, positions, current);
+      detector.update(current);
+      std::vector<proximity::contact> reference = brute_force(frame == 0 ? current : previous, current, params.margin);
+      bool same = reference.size() == detector.contacts().size();
+      for (std::size_t i = 0; same && i < reference.size(); ++i) {
+        same = reference[i].first == detector.contacts()[i].first && reference[i].second == detector.contacts()[i].second;
+      }
+      if (!same) {
+        std::cerr << "sweep and prune found " << detector.contacts().size() << " pairs in frame " << frame
+                  << ", all pairs found " << reference.size() << std::endl;
+        return EXIT_FAILURE;
+      }
+      contacts += reference.size();
+      events += detector.events().size();
+      previous = current;
+    }
+    std::printf("%zu bodies, 20 large steps: %zu contacts and %zu events, same pairs as the all pairs test\n\n", count,
+                contacts, events);
+  }
+
+  // ---- first update, incremental updates and sorting from scratch every frame ----
+  bench::print_header();
+  for (std::size_t count = 10000; count <= max_count; count *= 10) {
+    unsigned const frames = count >= 1000000 ? 5 : 20;
+    std::vector<float> radii{};
+    kepler::orbit_set orbits = belt(count, 5, radii);
+    std::vector<glm::fvec3> positions{};
+    culling::sphere_batch spheres{};
+
+    proximity::detector incremental{};
+    proximity::parameters always_sort{};
+    always_sort.max_moves_per_sphere = 0;
+    proximity::detector scratch{always_sort};
+
+    spheres_at(orbits, radii, 0.0, positions, spheres);
+    auto first = bench::measure([&]() { incremental.update(spheres); }, 0, 1);
+    scratch.update(spheres);
+
+    std::vector<double> incremental_ms{};
+    std::vector<double> scratch_ms{};
+    std::size_t moves = 0;
+    std::size_t broad_pairs = 0;
+    std::size_t contacts = 0;
+    std::size_t events = 0;
+    for (unsigned frame = 1; frame <= frames; ++frame) {
+      spheres_at(orbits, radii, frame * frame_time, positions, spheres);
+      incremental_ms.push_back(bench::measure([&]() { incremental.update(spheres); }, 0, 1).front());
+      scratch_ms.push_back(bench::measure([&]() { scratch.update(spheres); }, 0, 1).front());
+      moves += incremental.stats().moves;
+      broad_pairs += incremental.stats().broad_pairs;
+      contacts += incremental.stats().contacts;
+      events += incremental.events().size();
+    }
+
+    bench::print_row("first update, full sort", count, bench::summarize(first));
+    bench::print_row("incremental update", count, bench::summarize(incremental_ms));
+    bench::print_row("full sort every update", count, bench::summarize(scratch_ms));
+    std::printf("%-32s %10zu %10zu moves %10zu pairs %10zu contacts %10zu events\n", "  per update", count,
+                moves / frames, broad_pairs / frames, contacts / frames, events / frames);
+  }
+
+  // ---- the all pairs test for comparison ----
+  for (std::size_t count = 1000; count <= std::min(max_count, std::size_t{10000}); count *= 10) {
+    std::vector<float> radii{};
+    kepler::orbit_set orbits = belt(count, 5, radii);
+    std::vector<glm::fvec3> positions{};
+    culling::sphere_batch spheres{};
+    spheres_at(orbits, radii, 0.0, positions, spheres);
+    auto all_pairs = bench::measure([&]() { bench::do_not_optimize(brute_force(spheres, spheres, 0.0f).size()); }, 0, 3);
+    bench::print_row("all pairs, one thread", count, bench::summarize(all_pairs));
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,214 @@
+#include "application_solar.hpp"
+#include "bench_utils.hpp"
+#include "frame_clock.hpp"
+#include "headless.hpp"
+#include "utils.hpp"
+
+#include <glbinding/gl/gl.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// simulated seconds per frame, every run shows the same frames however long they take
+static double const time_step = 1.0 / 60.0;
+// time of the first frame, late enough that generated planets left the line they start on
+static double const start_time = 100.0;
+
+struct scene_run {
+  std::string name;
+  scene_parameters scene;
+  bench::statistics frame;
+  bench::statistics cpu;
+  bench::statistics gpu;
+  bool gpu_timed = false;
+};
+
+// from the solar system to scenes with thousands of bodies
+static std::vector<scene_run> default_suite() {
+  std::vector<scene_run> suite(4);
+  suite[0].name = "solar system";
+  suite[1].name = "small";
+  suite[1].scene.planets = 32;
+  suite[1].scene.moons_per_planet = 2;
+  suite[1].scene.stars = 10000;
+  suite[1].scene.texture_width = 512;
+  suite[2].name = "medium";
+  suite[2].scene.planets = 128;
+  suite[2].scene.moons_per_planet = 3;
+  suite[2].scene.stars = 50000;
+  suite[2].scene.texture_width = 512;
+  suite[2].scene.asteroids = 100000;
+  suite[3].name = "large";
+  suite[3].scene.planets = 512;
+  suite[3].scene.moons_per_planet = 4;
+  suite[3].scene.stars = 200000;
+  suite[3].scene.texture_width = 256;
+  suite[3].scene.asteroids = 1000000;
+  return suite;
+}
+
+// sun, planets and moons, the solar system has 12
+static std::size_t body_count(scene_parameters const& scene) {
+  return scene.planets > 0 ? 1 + scene.planets * (1 + scene.moons_per_planet) : 12;
+}
+
+// value of an option at position i, which moves past it
+static std::size_t read_count(int& i, int argc, char* argv[]) {
+  if (i + 1 >= argc) {
+    throw std::logic_error(std::string{"solar_bench: "} + argv[i] + " needs a value");
+  }
+  return std::size_t(std::strtoull(argv[++i], nullptr, 10));
+}
+
+static std::string json_string(std::string const& text) {
+  std::string quoted{"\""};
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+    }
+    quoted += c;
+  }
+  return quoted + "\"";
+}
+
+static void write_statistics(std::ofstream& file, char const* name, bench::statistics const& stats) {
+  file << "      " << json_string(name) << ": {\"mean\": " << stats.mean << ", \"median\": " << stats.median
+       << ", \"p95\": " << stats.p95 << ", \"p99\": " << stats.p99 << ", \"min\": " << stats.min
+       << ", \"max\": " << stats.max << ", \"stddev\": " << stats.stddev << "}";
+}
+
+static void write_json(std::string const& path, std::vector<scene_run> const& runs, glm::uvec2 const& resolution,
+                       unsigned warmup, unsigned frames) {
+  std::ofstream file(path);
+  if (!file) {
+    throw std::logic_error("solar_bench: cannot write " + path);
+  }
+  file << "{\n";
+  file << "  \"renderer\": " << json_string(reinterpret_cast<char const*>(glGetString(GL_RENDERER))) << ",\n";
+  file << "  \"version\": " << json_string(reinterpret_cast<char const*>(glGetString(GL_VERSION))) << ",\n";
+  file << "  \"resolution\": [" << resolution.x << ", " << resolution.y << "],\n";
+  file << "  \"warmup_frames\": " << warmup << ",\n";
+  file << "  \"frames\": " << frames << ",\n";
+  file << "  \"time_step\": " << time_step << ",\n";
+  file << "  \"scenes\": [\n";
+  for (std::size_t i = 0; i < runs.size(); ++i) {
+    scene_parameters const& scene = runs[i].scene;
+    file << "    {\n";
+    file << "      \"name\": " << json_string(runs[i].name) << ",\n";
+    file << "      \"bodies\": " << body_count(scene) << ", \"planets\": " << scene.planets << ", \"moons_per_planet\": "
+         << scene.moons_per_planet << ", \"stars\": " << scene.stars << ", \"texture_width\": " << scene.texture_width
+         << ", \"asteroids\": " << scene.asteroids << ", \"seed\": " << scene.seed << ",\n";
+    // all in milliseconds, frames are waited for, so the frame time covers cpu and gpu
+    write_statistics(file, "frame_ms", runs[i].frame);
+    file << ",\n";
+    write_statistics(file, "cpu_ms", runs[i].cpu);
+    file << ",\n";
+    if (runs[i].gpu_timed) {
+      write_statistics(file, "gpu_ms", runs[i].gpu);
+    } else {
+      file << "      \"gpu_ms\": null";
+    }
+    file << "\n    }" << (i + 1 < runs.size() ? "," : "") << "\n";
+  }
+  file << "  ]\n}\n";
+}
+
+int main(int argc, char* argv[]) {
+  // resolution as for the headless application, the other options and the resource path follow
+  headless::options settings = headless::read_options(argc, argv);
+  unsigned warmup = 30;
+  unsigned frames = 300;
+  std::string output{"solar_bench.json"};
+  // any scene option replaces the suite with one scene
+  scene_run custom{};
+  custom.name = "custom";
+  bool custom_scene = false;
+
+  int kept = 1;
+  for (int i = 1; i < argc; ++i) {
+    std::string argument{argv[i]};
+    if (argument == "--frames") {
+      frames = unsigned(read_count(i, argc, argv));
+    } else if (argument == "--warmup") {
+      warmup = unsigned(read_count(i, argc, argv));
+    } else if (argument == "--output" && i + 1 < argc) {
+      output = argv[++i];
+    } else if (argument == "--planets") {
+      custom.scene.planets = read_count(i, argc, argv);
+      custom_scene = true;
+    } else if (argument == "--moons") {
+      custom.scene.moons_per_planet = unsigned(read_count(i, argc, argv));
+      custom_scene = true;
+    } else if (argument == "--stars") {
+      custom.scene.stars = read_count(i, argc, argv);
+      custom_scene = true;
+    } else if (argument == "--texture") {
+      custom.scene.texture_width = read_count(i, argc, argv);
+      custom_scene = true;
+    } else if (argument == "--asteroids") {
+      custom.scene.asteroids = read_count(i, argc, argv);
+      custom_scene = true;
+    } else if (argument == "--seed") {
+      custom.scene.seed = unsigned(read_count(i, argc, argv));
+      custom_scene = true;
+    } else {
+      argv[kept++] = argv[i];
+    }
+  }
+  argc = kept;
+  if (frames == 0) {
+    throw std::logic_error("solar_bench: at least one frame must be measured");
+  }
+  std::string resource_path = utils::read_resource_path(argc, argv);
+  std::vector<scene_run> runs = custom_scene ? std::vector<scene_run>{custom} : default_suite();
+
+  headless::initialize(settings.resolution, 3, 2);
+  for (auto& run : runs) {
+    // each scene starts at the same simulated time and advances by the same step
+    frame_clock::use_fixed_step(start_time, time_step);
+    std::unique_ptr<ApplicationSolar> application{new ApplicationSolar{resource_path, run.scene}};
+    headless::prepare(*application, settings.resolution);
+    for (unsigned frame = 0; frame < warmup; ++frame) {
+      headless::render_frame(*application);
+    }
+
+    std::vector<double> frame_ms{};
+    std::vector<double> cpu_ms{};
+    std::vector<double> gpu_ms{};
+    for (unsigned frame = 0; frame < frames; ++frame) {
+      headless::frame_sample sample = headless::render_frame(*application);
+      frame_ms.push_back(sample.frame_ms);
+      cpu_ms.push_back(sample.cpu_ms);
+      if (sample.gpu_ms >= 0.0) {
+        gpu_ms.push_back(sample.gpu_ms);
+      }
+    }
+    run.frame = bench::summarize(frame_ms);
+    run.cpu = bench::summarize(cpu_ms);
+    run.gpu = bench::summarize(gpu_ms);
+    run.gpu_timed = !gpu_ms.empty();
+  }
+
+  // the application reports on the way, the table comes after all of it
+  std::printf("\n");
+  bench::print_header();
+  for (auto const& run : runs) {
+    bench::print_row(run.name + " frame", body_count(run.scene), run.frame);
+    bench::print_row(run.name + " cpu", body_count(run.scene), run.cpu);
+    if (run.gpu_timed) {
+      bench::print_row(run.name + " gpu", body_count(run.scene), run.gpu);
+    }
+  }
+  write_json(output, runs, settings.resolution, warmup, frames);
+  std::printf("\nwrote %s\n", output.c_str());
+
+  headless::close_and_quit(EXIT_SUCCESS);
+}
@@ -0,0 +1,87 @@
+#include "bench_utils.hpp"
+#include "parallel.hpp"
+#include "trace.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// events per repetition, the recording restarts with every repetition so the buffers keep their size
+static std::size_t const events = 100000;
+static unsigned const warmup = 3;
+static unsigned const repetitions = 20;
+
+static void print_cost(std::string const& name, bench::statistics const& stats) {
+  bench::print_row(name, events, stats);
+  std::printf("%-32s %10s %10.2f ns per event\n", "", "", stats.median * 1000000.0 / double(events));
+}
+
+int main(int argc, char* argv[]) {
+  std::string output = argc > 1 ? argv[1] : "trace_bench.json";
+  trace::thread_name("main");
+  bench::print_header();
+
+  // what every zone costs in builds without tracing
+  print_cost("empty loop", bench::summarize(bench::measure([] {
+    for (std::size_t i = 0; i < events; ++i) {
+      bench::do_not_optimize(i);
+    }
+  }, warmup, repetitions)));
+
+  print_cost("zone not recording", bench::summarize(bench::measure([] {
+    for (std::size_t i = 0; i < events; ++i) {
+      trace::zone zone{"idle zone"};
+      bench::do_not_optimize(i);
+    }
+  }, warmup, repetitions)));
+
+  print_cost("zone recording", bench::summarize(bench::measure([&output] {
+    trace::start(output);
+    for (std::size_t i = 0; i < events; ++i) {
+      trace::zone zone{"zone"};
+      bench::do_not_optimize(i);
+    }
+  }, warmup, repetitions)));
+
+  print_cost("nested zones recording", bench::summarize(bench::measure([&output] {
+    trace::start(output);
+    for (std::size_t i = 0; i < events / 2; ++i) {
+      trace::zone outer{"outer"};
+      trace::zone inner{"inner"};
+      bench::do_not_optimize(i);
+    }
+  }, warmup, repetitions)));
+
+  // the detail is copied, as for file names of shaders and textures
+  std::string const detail{"resources/textures/earthmap.png"};
+  print_cost("zone with detail recording", bench::summarize(bench::measure([&output, &detail] {
+    trace::start(output);
+    for (std::size_t i = 0; i < events; ++i) {
+      trace::zone zone{"zone with detail", detail};
+      bench::do_not_optimize(i);
+    }
+  }, warmup, repetitions)));
+
+  print_cost("counter recording", bench::summarize(bench::measure([&output] {
+    trace::start(output);
+    for (std::size_t i = 0; i < events; ++i) {
+      trace::counter("counter", double(i));
+    }
+  }, warmup, repetitions)));
+
+  // every worker records into its own buffer, the zones of all threads together
+  print_cost("zones on all threads", bench::summarize(bench::measure([&output] {
+    trace::start(output);
+    parallel::for_range(events, 1000, [](unsigned, std::size_t begin, std::size_t end) {
+      for (std::size_t i = begin; i < end; ++i) {
+        trace::zone zone{"worker zone"};
+        bench::do_not_optimize(i);
+      }
+    });
+  }, warmup, repetitions)));
+
+  // the events of the last repetition
+  trace::stop();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,127 @@
+#include "bench_utils.hpp"
+#include "gl_validation.hpp"
+#include "headless.hpp"
+
+#include <glbinding/gl/gl.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <string>
+
+// frames per repetition, so the sampled level checks one of them with its default interval
+static unsigned const frames = 60;
+static unsigned const warmup = 2;
+static unsigned const repetitions = 15;
+// uniform uploads before each draw, cheap calls in the driver so the cost of the checks shows
+static std::size_t const uploads_per_draw = 50;
+static std::size_t const calls_per_draw = uploads_per_draw + 1;
+
+static char const* const vertex_source =
+  "#version 150\n"
+  "in vec2 in_Position;\n"
+  "void main() { gl_Position = vec4(in_Position, 0.0, 1.0); }\n";
+static char const* const fragment_source =
+  "#version 150\n"
+  "uniform vec4 Color;\n"
+  "out vec4 out_Color;\n"
+  "void main() { out_Color = Color; }\n";
+
+static GLuint compile(GLenum stage, char const* source) {
+  GLuint shader = glCreateShader(stage);
+  glShaderSource(shader, 1, &source, nullptr);
+  glCompileShader(shader);
+  return shader;
+}
+
+// a small triangle drawn a few times after many uniform uploads, the calls dominate and not the pixels
+static void bench_level(gl_validation::options const& settings, std::string const& label, std::size_t draws,
+                        GLint color_location) {
+  gl_validation::enable(settings);
+  bench::statistics stats = bench::summarize(bench::measure([draws, color_location] {
+    for (unsigned frame = 0; frame < frames; ++frame) {
+      gl_validation::frame();
+      glClear(GL_COLOR_BUFFER_BIT);
+      for (std::size_t i = 0; i < draws; ++i) {
+        for (std::size_t upload = 0; upload < uploads_per_draw; ++upload) {
+          glUniform4f(color_location, float(upload % 7) / 7.0f, float(i % 5) / 5.0f, 0.5f, 1.0f);
+        }
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+      }
+    }
+    // the queued frames would otherwise be paid by the next repetition
+    glFinish();
+  }, warmup, repetitions));
+  bench::print_row(label, frames * draws * calls_per_draw, stats);
+  std::printf("%-32s %10s %10.3f ms per frame, %.1f ns per call\n", "", "", stats.median / double(frames),
+              stats.median * 1000000.0 / double(frames * draws * calls_per_draw));
+}
+
+int main(int argc, char* argv[]) {
+  std::size_t draws = argc > 1 ? std::size_t(std::strtoul(argv[1], nullptr, 10)) : 40;
+  if (draws == 0) {
+    std::fprintf(stderr, "validation_bench: at least one draw per frame is needed\n");
+    return EXIT_FAILURE;
+  }
+
+  // the levels need a context, the offscreen one of the headless mode
+  if (!headless::available()) {
+    std::printf("validation_bench: skipped, built without an offscreen context\n");
+    return EXIT_SUCCESS;
+  }
+  try {
+    headless::initialize(glm::uvec2{64u, 64u}, 4, 3);
+  } catch (std::exception const& error) {
+    std::printf("validation_bench: skipped, %s\n", error.what());
+    return EXIT_SUCCESS;
+  }
+
+  GLuint program = glCreateProgram();
+  GLuint vertex_shader = compile(GL_VERTEX_SHADER, vertex_source);
+  GLuint fragment_shader = compile(GL_FRAGMENT_SHADER, fragment_source);
+  glAttachShader(program, vertex_shader);
+  glAttachShader(program, fragment_shader);
+  glBindAttribLocation(program, 0, "in_Position");
+  glLinkProgram(program);
+  glUseProgram(program);
+  GLint color_location = glGetUniformLocation(program, "Color");
+
+  float const triangle[] = {-0.1f, -0.1f, 0.1f, -0.1f, 0.0f, 0.1f};
+  GLuint vertex_array = 0, vertex_buffer = 0;
+  glGenVertexArrays(1, &vertex_array);
+  glBindVertexArray(vertex_array);
+  glGenBuffers(1, &vertex_buffer);
+  glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(triangle), triangle, GL_STATIC_DRAW);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+  bench::print_header();
+  gl_validation::options settings{};
+  settings.mode = gl_validation::level::off;
+  bench_level(settings, "off", draws, color_location);
+
+  settings.mode = gl_validation::level::sampled;
+  for (unsigned interval : {60u, 10u}) {
+    settings.interval = interval;
+    bench_level(settings, "sampled every " + std::to_string(interval) + " frames", draws, color_location);
+  }
+
+  // the headless context has no debug flag, drivers may deliver the messages anyway
+  settings.mode = gl_validation::level::callback;
+  bench_level(settings, "callback", draws, color_location);
+
+  settings.mode = gl_validation::level::full;
+  bench_level(settings, "full", draws, color_location);
+
+  settings.mode = gl_validation::level::off;
+  gl_validation::enable(settings);
+  glDeleteBuffers(1, &vertex_buffer);
+  glDeleteVertexArrays(1, &vertex_array);
+  glDeleteShader(vertex_shader);
+  glDeleteShader(fragment_shader);
+  glDeleteProgram(program);
+  headless::close_and_quit(EXIT_SUCCESS);
+}
@@ -8,6 +8,10 @@ class GeometryNode : public Node{
     public:
         GeometryNode();
 
+        //planets whose textures are loaded later from their paths, e.g. when many of them share a file
+        GeometryNode(std::shared_ptr<Node> const& parent, std::string const& name, 
+                     std::string const& path, int depth, std::shared_ptr<Node> const& origin);
+
         //constructor for planets without normal map
         GeometryNode(std::shared_ptr<Node> const& parent, std::string const& name, 
                             std::string const& path, int depth, std::shared_ptr<Node> const& origin, std::string const& texPath);
@@ -56,6 +60,13 @@ class GeometryNode : public Node{
         bool hasNormapMapping() const override;
         void setHasNormalMapping(bool normalMapping) override;
 
+        //Texture Arrays
+        int getTextureLayer() const override;
+        void setTextureLayer(int layer) override;
+
+        int getNormalTextureLayer() const override;
+        void setNormalTextureLayer(int layer) override;
+
         // int getPlanetID() const override;
         // void setPlanetID(int id) override;
 
@@ -75,6 +86,10 @@ class GeometryNode : public Node{
         std::map<std::string, pixel_data> textures_;
         bool hasNormalMap_;
 
+        //layers in the planet texture arrays
+        int textureLayer_;
+        int normalTextureLayer_;
+
         //int planetID_;
 };
 
@@ -79,6 +79,13 @@ class Node{
         virtual bool hasNormapMapping() const;
         virtual void setHasNormalMapping(bool normalMapping);
 
+        //Texture Arrays (layer of the planet, -1 if it has none)
+        virtual int getTextureLayer() const;
+        virtual void setTextureLayer(int layer);
+
+        virtual int getNormalTextureLayer() const;
+        virtual void setNormalTextureLayer(int layer);
+
         // virtual int getPlanetID() const;
         // virtual void setPlanetID(int id);
 
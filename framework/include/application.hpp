@@ -25,6 +25,8 @@ class Application {
   void key_callback(GLFWwindow* window, int key, int action, int mods);
   //handle mouse movement input
   void mouse_callback(GLFWwindow* window, double pos_x, double pos_y);
+  // handle mouse button input
+  void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
   // recompile shaders form source files
   void reloadShaders(bool throwing);
 
@@ -35,6 +37,8 @@ class Application {
   inline virtual void keyCallback(int key, int action, int mods) {};
   //handle delta mouse movement input
   inline virtual void mouseCallback(double pos_x, double pos_y) {};
+  // react to mouse buttons, position is the cursor in framebuffer pixels from the top left
+  inline virtual void mouseButtonCallback(int button, int action, int mods, double pos_x, double pos_y) {};
   // update framebuffer textures
   inline virtual void resizeCallback(unsigned width, unsigned height) {};
   // draw all objects
@@ -54,13 +58,48 @@ class Application {
 };
 
 
+#include "frame_pacer.hpp"
+#include "frame_stats.hpp"
+#include "gl_validation.hpp"
+#include "headless.hpp"
+#include "trace.hpp"
 #include "utils.hpp"
 #include "window_handler.hpp"
 
 template<typename T>
 void Application::run(int argc, char* argv[], unsigned ver_major, unsigned ver_minor) {  
 
-    GLFWwindow* window = window_handler::initialize(initial_resolution, ver_major, ver_minor);
+    // record cpu zones of startup and frames until the application is closed
+    std::string trace_file = trace::read_options(argc, argv);
+    if (!trace_file.empty()) {
+      trace::thread_name("main");
+      trace::start(trace_file);
+    }
+
+    // percentiles of the frame times, optionally exported to a file
+    frame_stats::parameters stats_options = frame_stats::read_options(argc, argv);
+
+    // frame rate limit and vsync of the window
+    frame_pacer::parameters pacing = frame_pacer::read_options(argc, argv);
+
+    // checks of the gl calls, nothing in release builds and glGetError after every call otherwise
+    gl_validation::options validation = gl_validation::read_options(argc, argv);
+
+    // render a fixed number of frames offscreen and print their times instead of opening a window
+    headless::options headless_options = headless::read_options(argc, argv);
+    if (headless_options.enabled) {
+      headless::initialize(headless_options.resolution, ver_major, ver_minor);
+      gl_validation::enable(validation);
+      T* application = new T{utils::read_resource_path(argc, argv)};
+      int status = headless::render_frames(*application, headless_options);
+      delete application;
+      trace::stop();
+      headless::close_and_quit(status);
+    }
+
+    GLFWwindow* window = window_handler::initialize(initial_resolution, ver_major, ver_minor, validation);
+    frame_pacer pacer{pacing};
+    pacer.set_swap_interval();
     
     std::string resource_path = utils::read_resource_path(argc, argv);
     T* application = new T{resource_path};
@@ -74,21 +113,44 @@ void Application::run(int argc, char* argv[], unsigned ver_major, unsigned ver_m
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LESS);
     
+    frame_stats stats{stats_options};
+
     // rendering loop
     while (!glfwWindowShouldClose(window)) {
+      // wait until the frame is due, before the input is read
+      {
+        TRACE_ZONE("pace frame");
+        pacer.wait();
+      }
+      TRACE_FRAME();
+      gl_validation::frame();
       // query input
-      glfwPollEvents();
+      {
+        TRACE_ZONE("poll events");
+        glfwPollEvents();
+      }
+      stats.begin_frame();
       // clear buffer
       glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
       // draw geometry
-      application->render();
+      {
+        TRACE_ZONE("render");
+        application->render();
+      }
+      stats.end_frame();
       // swap draw buffer to front
-      glfwSwapBuffers(window);
-      // display fps
-      window_handler::show_fps(window);
+      {
+        TRACE_ZONE("swap buffers");
+        glfwSwapBuffers(window);
+      }
+      // report frame times on the console and in the title
+      if (stats.presented()) {
+        window_handler::show_frame_stats(window, stats.summarize());
+      }
     }
 
     delete application;
+    trace::stop();
     window_handler::close_and_quit(window, EXIT_SUCCESS);
 }
 
@@ -0,0 +1,72 @@
+#ifndef ASTEROID_BELT_HPP
+#define ASTEROID_BELT_HPP
+
+#include "kepler.hpp"
+#include "model.hpp"
+#include "pixel_data.hpp"
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace asteroid_belt {
+
+// shape of a belt, every asteroid is derived from the seed
+struct parameters {
+  std::uint32_t seed = 1;
+  std::size_t count = 10000;
+  // orbit radii are spread evenly over the area of the ring
+  float inner_radius = 21.5f;
+  float outer_radius = 23.5f;
+  // largest tilt of an orbit against the xz plane in radians and largest eccentricity
+  float max_inclination = 0.06f;
+  float max_eccentricity = 0.08f;
+  // angular speed at the inner radius, outer orbits are slower by kepler's third law
+  float inner_speed = 0.2f;
+  // radius of the rocks, small ones are more frequent
+  float min_size = 0.015f;
+  float max_size = 0.08f;
+  // rock meshes and texture layers asteroids are spread over
+  unsigned variants = 3;
+  unsigned layers = 4;
+};
+
+// asteroid as read by the vertex shader, 16 bytes
+struct instance {
+  glm::fvec3 position;
+  // bits 0-15 radius relative to max_size, 16-23 spin, 24-31 texture layer
+  std::uint32_t packed;
+};
+
+// kepler orbits of all asteroids, grouped by rock variant
+class belt {
+ public:
+  belt();
+
+  // replace all asteroids, the same parameters always give the same belt
+  void generate(parameters const& params);
+  // positions at the time in seconds, computed in parallel
+  void propagate(double time, std::vector<instance>& instances) const;
+
+  std::size_t size() const;
+  parameters const& params() const;
+  // asteroids [first, first + count) use the rock mesh of this variant
+  std::size_t variant_first(unsigned variant) const;
+  std::size_t variant_count(unsigned variant) const;
+
+ private:
+  parameters params_;
+  kepler::orbit_set orbits_;
+  std::vector<std::uint32_t> packed_;
+};
+
+// low poly rock, an icosphere with seeded displacement, same layout as icosphere::generate
+model rock(std::uint32_t seed, unsigned subdivisions = 0);
+
+// grey brown noise textures of equal size for a texture array
+std::vector<pixel_data> rock_textures(std::uint32_t seed, unsigned layers, std::size_t size = 64);
+
+}
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef BVH_HPP
+#define BVH_HPP
+
+#include "culling.hpp"
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace bvh {
+
+// axis aligned box around the spheres of a subtree, nodes are stored depth first,
+// so the first child of an inner node directly follows it
+struct node {
+  glm::fvec3 min;
+  // leaf: first entry in the primitive list, inner node: index of the second child
+  std::uint32_t offset;
+  glm::fvec3 max;
+  // number of primitives, 0 for inner nodes
+  std::uint32_t count;
+};
+
+// sphere found by a ray or nearest query
+struct hit {
+  // index of the sphere in the batch the tree was built from
+  std::size_t index = 0;
+  // ray parameter of the entry point or distance to the sphere surface
+  float distance = std::numeric_limits<float>::infinity();
+};
+
+// hierarchy over moving spheres, built once and refitted while the spheres move
+class tree {
+ public:
+  tree();
+
+  // build the hierarchy from scratch, splits at the median of the widest axis
+  void build(culling::sphere_batch const& spheres, std::uint32_t leaf_size = 4);
+  // update the boxes to new sphere positions while keeping the topology,
+  // spheres must be in the same order as when building
+  void refit(culling::sphere_batch const& spheres);
+
+  // collect indices of all spheres which may intersect the frustum
+  void frustum_query(culling::frustum const& planes, culling::sphere_batch const& spheres,
+                     std::vector<std::uint32_t>& visible) const;
+  // closest sphere hit by the ray, direction must be normalized
+  bool ray_query(glm::fvec3 const& origin, glm::fvec3 const& direction, culling::sphere_batch const& spheres,
+                 hit& result, float max_distance = std::numeric_limits<float>::infinity()) const;
+  // sphere whose surface is closest to the point, 0 distance if the point lies inside
+  bool nearest_query(glm::fvec3 const& point, culling::sphere_batch const& spheres, hit& result) const;
+
+  std::size_t size() const;
+  std::vector<node> const& nodes() const;
+
+ private:
+  std::uint32_t build_recursive(culling::sphere_batch const& spheres, std::uint32_t begin, std::uint32_t end,
+                                std::uint32_t leaf_size);
+
+  std::vector<node> nodes_;
+  // sphere indices, leaves refer to ranges of this list
+  std::vector<std::uint32_t> primitives_;
+};
+
+}
+
+#endif
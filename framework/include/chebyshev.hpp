@@ -0,0 +1,79 @@
+#ifndef CHEBYSHEV_HPP
+#define CHEBYSHEV_HPP
+
+#include "ephemeris.hpp"
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace chebyshev {
+
+struct parameters {
+  // time window the table covers in seconds
+  double start = 0.0;
+  double end = 3600.0;
+  // length of one polynomial segment, the fastest moon turns by about two radians in it
+  double segment_length = 4.0;
+  // degree of the polynomial of each coordinate
+  unsigned degree = 10;
+};
+
+// hash of the orbits of the bodies and the fit parameters, a table fitted from different ones has another hash
+std::uint64_t hash(ephemeris::body_set const& bodies, parameters const& params);
+
+// body positions over a time window as piecewise chebyshev polynomials,
+// a lookup is a segment index and one polynomial per coordinate, independent of the depth of the orbit chain
+class table {
+ public:
+  table();
+
+  void clear();
+  // fit all bodies of the set over the window, in parallel over bodies and segments,
+  // the error against the analytic orbits is bounded from the coefficients of a finer fit and samples between the nodes
+  void fit(ephemeris::body_set const& bodies, parameters const& params);
+
+  // binary file with the hash, the window, the body paths, their error bounds and float coefficients, throws on failure
+  void save(std::string const& file_path) const;
+  void load(std::string const& file_path);
+
+  std::size_t size() const;
+  // index of the body with the scene path, throws for unknown paths
+  std::size_t find(std::string const& path) const;
+  std::string const& path(std::size_t body) const;
+  // hash of the bodies and parameters the table was fitted from
+  std::uint64_t source_hash() const;
+  // bound on the distance to the analytic position over the window: twice the coefficients the polynomials drop,
+  // taken from a fit of twice the degree, plus the residual sampled between the nodes with a safety factor
+  float max_error(std::size_t body) const;
+  bool covers(double time) const;
+  double start() const;
+  double end() const;
+  std::size_t segment_count() const;
+  std::size_t bytes() const;
+
+  // position at the time, times outside the window are clamped to it
+  glm::fvec3 position(std::size_t body, double time) const;
+  // positions at count times on the calling thread
+  void positions(std::size_t body, double const* times, std::size_t count, float* x, float* y, float* z) const;
+
+ private:
+  // coefficients of a segment, x, y, z and a zero of each degree after another
+  float const* segment(std::size_t body, double time, float& u) const;
+
+  double start_;
+  double segment_length_;
+  std::size_t segment_count_;
+  unsigned degree_;
+  std::uint64_t source_hash_;
+  std::vector<std::string> paths_;
+  std::vector<float> max_errors_;
+  // body major, then segment, then degree, then coordinate padded to four floats
+  std::vector<float> coefficients_;
+};
+
+}
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef CULLING_HPP
+#define CULLING_HPP
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace culling {
+
+// planes of a view frustum, xyz is the normal pointing inside and w the distance,
+// a point p is inside a plane if dot(xyz, p) + w >= 0
+struct frustum {
+  std::array<glm::fvec4, 6> planes;
+};
+
+// bounding spheres in structure of arrays layout, so four spheres can be tested at once
+struct sphere_batch {
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<float> z;
+  std::vector<float> radius;
+
+  void clear();
+  void push_back(glm::fvec3 const& center, float sphere_radius);
+  std::size_t size() const;
+};
+
+// number of tested and rejected objects of the last frame
+struct cull_stats {
+  std::size_t visible = 0;
+  std::size_t culled = 0;
+};
+
+// extract normalized planes from a combined projection * view matrix,
+// the planes are in the space the matrix transforms from
+frustum extract_frustum(glm::fmat4 const& view_projection);
+
+// test single sphere, conservative near the frustum corners
+bool sphere_visible(frustum const& planes, glm::fvec3 const& center, float radius);
+
+// test all spheres of the batch, visible[i] is 1 if sphere i may be visible
+// returns the number of visible spheres
+std::size_t cull_spheres(frustum const& planes, sphere_batch const& spheres, std::vector<std::uint8_t>& visible);
+
+// test up to four spheres of the batch at once, e.g. those of a hierarchy leaf,
+// bit i of the result is set if the sphere at indices[i] may be visible
+unsigned cull_four(frustum const& planes, sphere_batch const& spheres, std::uint32_t const* indices, std::size_t count);
+
+}
+
+#endif
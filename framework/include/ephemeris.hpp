@@ -0,0 +1,83 @@
+#ifndef EPHEMERIS_HPP
+#define EPHEMERIS_HPP
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <array>
+#include <string>
+#include <vector>
+
+class Node;
+
+namespace ephemeris {
+
+// one rotation around a parent, a body at the time is frame * rotate_y(time * speed) * translate(offset)
+struct orbit_level {
+  glm::fmat4 frame;
+  float speed;
+  glm::fvec3 offset;
+};
+
+// animated orbit of a scene body, the model matrix is the product of the levels,
+// followed by the rotation around the own axis and the scale by the radius
+struct body_orbit {
+  std::string path;
+  std::vector<orbit_level> levels;
+  float self_rotation = 0.0f;
+  float radius = 1.0f;
+};
+
+// orbit of a planet or moon of the scene graph, the same matrices the renderer animates
+body_orbit orbit_of(Node const& body);
+// model matrix of the body at a position from elsewhere, like a simulation or an orbit table,
+// with the same rotation around the own axis and scale as its orbit
+glm::fmat4 place(body_orbit const& orbit, glm::fvec3 const& position, double time);
+
+// results of a query as one column per component, sample (body, time) is at index body * times + time
+struct columns {
+  std::size_t bodies = 0;
+  std::size_t times = 0;
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<float> z;
+  // column major model matrices, only filled when requested
+  std::array<std::vector<float>, 16> matrix;
+};
+
+// bodies whose orbits are evaluated without a window or gl context
+class body_set {
+ public:
+  body_set();
+
+  void clear();
+  // returns the index of the body
+  std::size_t add(body_orbit const& orbit);
+  // planets and moons below the node, in the order the renderer collects them
+  void add_scene(Node const& root);
+  std::size_t size() const;
+
+  // index of the body with the scene path, throws for unknown paths
+  std::size_t find(std::string const& path) const;
+  body_orbit const& orbit(std::size_t index) const;
+
+  // model matrix and position of one body in double precision time, reference for the batch evaluation
+  glm::fmat4 transform(std::size_t index, double time) const;
+  glm::fvec3 position(std::size_t index, double time) const;
+
+  // positions of one body at count times on the calling thread, four times at once with sse
+  void positions(std::size_t index, double const* times, std::size_t count, float* x, float* y, float* z) const;
+  // model matrices of one body at count times, matrix[c] receives column major component c
+  void transforms(std::size_t index, double const* times, std::size_t count, float* const* matrix) const;
+
+  // positions and optionally matrices of all bodies at all times, computed in parallel
+  columns query(std::vector<std::string> const& paths, std::vector<double> const& times, bool matrices = false) const;
+  void query(std::vector<std::string> const& paths, std::vector<double> const& times, bool matrices,
+             columns& result) const;
+
+ private:
+  std::vector<body_orbit> orbits_;
+};
+
+}
+
+#endif
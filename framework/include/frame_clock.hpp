@@ -0,0 +1,16 @@
+#ifndef FRAME_CLOCK_HPP
+#define FRAME_CLOCK_HPP
+
+// time source of the animations, glfw needs an initialized library which headless runs do not have
+namespace frame_clock {
+  // seconds since the start, from glfw unless another source was chosen
+  double now();
+  // count from the first call with a steady clock instead of glfw
+  void use_steady_clock();
+  // start at the given time and advance by a fixed step per frame, so runs show the same frames on every machine
+  void use_fixed_step(double start, double step);
+  // end of a frame, moves the fixed step clock forward and does nothing for the others
+  void tick();
+}
+
+#endif
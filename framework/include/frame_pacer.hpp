@@ -0,0 +1,59 @@
+#ifndef FRAME_PACER_HPP
+#define FRAME_PACER_HPP
+
+#include <chrono>
+#include <vector>
+
+// limits the frame rate to a target by sleeping most of the wait and spinning the rest, and chooses
+// the swap interval, so frames nobody sees are not rendered
+class frame_pacer {
+ public:
+  enum class vsync {
+    off,
+    on,
+    // synchronized while the frames are in time, a late frame is shown at once instead of a refresh later
+    adaptive
+  };
+
+  struct parameters {
+    // frames per second the wait aims for, 0 renders as fast as the swap interval allows
+    double target_fps = 0.0;
+    vsync swap = vsync::adaptive;
+    // seconds between reports of the pacing error on the console
+    double report_interval = 5.0;
+  };
+
+  // take "--fps N" and "--vsync off|on|adaptive" out of the arguments, the others keep their order
+  static parameters read_options(int& argc, char* argv[]);
+
+  frame_pacer();
+  explicit frame_pacer(parameters const& params);
+
+  // set the swap interval of the current glfw context, adaptive falls back to on without the extension
+  void set_swap_interval();
+  // at the start of a frame, waits until the frame is due and reports the pacing error when the interval passed
+  void wait();
+
+ private:
+  using clock_type = std::chrono::steady_clock;
+
+  // sleep while the remaining time is longer than the sleeps were seen to take, then spin
+  void wait_until(clock_type::time_point deadline);
+  void report();
+
+  parameters params_;
+  clock_type::duration period_;
+  clock_type::time_point deadline_;
+  clock_type::time_point last_report_;
+  bool started_;
+  // lateness of the frames since the last report, in milliseconds
+  std::vector<double> errors_;
+  std::size_t missed_;
+  // duration of a 1 ms sleep from the mean and variance of the observed ones, in milliseconds
+  double sleep_estimate_;
+  double sleep_mean_;
+  double sleep_variance_;
+  std::size_t sleeps_;
+};
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef FRAME_STATS_HPP
+#define FRAME_STATS_HPP
+
+#include <glbinding/gl/types.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+// times of the recent frames in a ring buffer, the cpu time of the render call, the gpu time from timestamps
+// read back frames later and the interval between presents, reported as percentiles, histogram and hitch count
+class frame_stats {
+ public:
+  struct parameters {
+    // number of recent frames the summary covers
+    std::size_t capacity = 1024;
+    // seconds between reports on the console, and exports if a file is given
+    double report_interval = 5.0;
+    // a present interval longer than this factor times the median is a hitch
+    double hitch_factor = 2.0;
+    // histogram of the present intervals, the last bucket counts all longer ones
+    double bucket_ms = 2.0;
+    std::size_t buckets = 25;
+    // json file rewritten with every report, nothing is exported without one
+    std::string export_path;
+  };
+
+  // one kind of frame time over the frames of the ring buffer, in milliseconds
+  struct percentiles {
+    std::size_t frames = 0;
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+  };
+
+  struct summary {
+    percentiles cpu;
+    percentiles gpu;
+    percentiles present;
+    // hitches among the frames of the ring buffer and since the start
+    std::size_t hitches = 0;
+    std::size_t total_hitches = 0;
+    std::size_t total_frames = 0;
+    // frames per bucket of present interval
+    std::vector<std::size_t> histogram;
+  };
+
+  // take "--frame-stats FILE" out of the arguments for the export, the others keep their order
+  static parameters read_options(int& argc, char* argv[]);
+
+  frame_stats();
+  explicit frame_stats(parameters const& params);
+  // free query objects
+  ~frame_stats();
+
+  // owns gpu objects, so only one instance may refer to them
+  frame_stats(frame_stats const&) = delete;
+  frame_stats& operator=(frame_stats const&) = delete;
+
+  // around the render call, the first call checks for timer queries, the gpu time is missing without them
+  void begin_frame();
+  void end_frame();
+  // after the frame was presented, reports and exports when the interval passed and then returns true
+  bool presented();
+
+  summary summarize() const;
+  // summary and histogram as json, throws if the file cannot be written
+  void write_json(std::string const& file_path) const;
+
+ private:
+  // negative times were not measured
+  struct frame_record {
+    double cpu_ms = -1.0;
+    double gpu_ms = -1.0;
+    double present_ms = -1.0;
+  };
+  // timestamps before and after the render call of a frame
+  struct timer {
+    GLuint queries[2] = {0, 0};
+    std::size_t frame = 0;
+    bool in_flight = false;
+  };
+
+  // write the gpu times of the frames whose timestamps arrived
+  void collect();
+  void report(summary const& current) const;
+
+  parameters params_;
+  std::vector<frame_record> records_;
+  std::vector<timer> timers_;
+  // frames begun so far, the current one is frames_ - 1
+  std::size_t frames_;
+  bool checked_;
+  bool supported_;
+  bool timing_;
+  std::chrono::steady_clock::time_point frame_start_;
+  std::chrono::steady_clock::time_point last_present_;
+  std::chrono::steady_clock::time_point last_report_;
+  // median present interval of the last report, hitches are counted against it
+  double median_present_;
+  std::size_t total_hitches_;
+};
+
+#endif
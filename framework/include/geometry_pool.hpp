@@ -0,0 +1,81 @@
+#ifndef GEOMETRY_POOL_HPP
+#define GEOMETRY_POOL_HPP
+
+#include "model.hpp"
+
+#include <glbinding/gl/types.h>
+#include <glbinding/gl/enum.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <vector>
+
+// location of one mesh inside the shared buffers of a geometry_pool
+struct mesh_range {
+  // primitive type to draw
+  GLenum draw_mode = GL_NONE;
+  // first vertex of the mesh, mesh indices are relative to it
+  GLint base_vertex = 0;
+  // number of vertices
+  GLsizei num_vertices = 0;
+  // first index of the mesh in the index buffer
+  GLuint first_index = 0;
+  // indices number, 0 if the mesh is drawn without indices
+  GLsizei num_elements = 0;
+};
+
+// layout of one command in a GL_DRAW_INDIRECT_BUFFER for glMultiDrawElementsIndirect
+struct draw_elements_command {
+  GLuint count;
+  GLuint instance_count;
+  GLuint first_index;
+  GLint base_vertex;
+  GLuint base_instance;
+};
+
+// all meshes share one vertex buffer, one index buffer and one vertex array object,
+// so switching between meshes only changes draw parameters
+class geometry_pool {
+ public:
+  geometry_pool();
+  // free buffers and vertex array
+  ~geometry_pool();
+
+  // owns gpu objects, so only one instance may refer to them
+  geometry_pool(geometry_pool const&) = delete;
+  geometry_pool& operator=(geometry_pool const&) = delete;
+
+  // append mesh to the pool, attributes missing in the model are filled with zeros
+  // models without indices are drawn with glDrawArrays
+  mesh_range add(model const& mesh, GLenum draw_mode);
+  // upload all added meshes and create the vertex array,
+  // attribute locations match the order of model::VERTEX_ATTRIBS
+  void upload();
+
+  // another vertex array reading the shared vertex and index buffers, for passes with their own instanced
+  // attributes, so these never apply to draws of other passes, freed with the pool
+  GLuint add_vertex_array();
+
+  // bind the shared vertex array
+  void bind() const;
+  // draw a single mesh, pool must be bound
+  void draw(mesh_range const& mesh) const;
+  // command for drawing an indexed mesh in a multi draw call
+  static draw_elements_command command(mesh_range const& mesh, GLuint base_instance);
+
+  GLuint vertex_array() const;
+
+  // floats per vertex in the shared layout
+  static GLsizei const vertex_components;
+
+ private:
+  std::vector<GLfloat> vertex_data_;
+  std::vector<GLuint> index_data_;
+
+  GLuint vertex_AO_;
+  GLuint vertex_BO_;
+  GLuint element_BO_;
+  std::vector<GLuint> pass_AOs_;
+};
+
+#endif
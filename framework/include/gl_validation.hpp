@@ -0,0 +1,40 @@
+#ifndef GL_VALIDATION_HPP
+#define GL_VALIDATION_HPP
+
+// checks of the gl calls at a selectable cost, from none to glGetError after every call
+namespace gl_validation {
+  enum class level {
+    // no checks, and no debug context
+    off,
+    // glGetError after every call of every n-th frame, errors of the frames between are reported without the call
+    sampled,
+    // messages of the driver from the debug output, delivered asynchronously without glGetError
+    callback,
+    // glGetError after every call and synchronous debug output, the failing call throws
+    full
+  };
+
+  struct options {
+    // release builds check nothing unless asked to
+#ifdef NDEBUG
+    level mode = level::off;
+#else
+    level mode = level::full;
+#endif
+    // frames from one sampled frame to the next
+    unsigned interval = 60;
+  };
+
+  // take "--gl-validation off|sampled [frames]|callback|full" out of the arguments, the others keep their order
+  options read_options(int& argc, char* argv[]);
+  char const* name(level mode);
+  // whether the context should be created with the debug flag for the level
+  bool needs_debug_context(level mode);
+
+  // install the checks of the level in the current context, replacing those of a previous call
+  void enable(options const& settings);
+  // at the start of every frame, switches the checks of the sampled level on and off
+  void frame();
+}
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef GPU_PROFILER_HPP
+#define GPU_PROFILER_HPP
+
+#include <glbinding/gl/types.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <string>
+#include <vector>
+
+// gpu time of the named passes of each frame, from timestamps written before and after a pass,
+// a frame is read back once all of its timestamps arrived, so profiling never waits for the gpu
+class gpu_profiler {
+ public:
+  // rolling statistics of a pass over the frames in the history, in milliseconds
+  struct pass_statistics {
+    std::string name;
+    std::size_t frames = 0;
+    double last = 0.0;
+    double mean = 0.0;
+    double median = 0.0;
+    double p95 = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+  };
+
+  // latency is the number of frames in flight, history the number of frames the statistics cover
+  gpu_profiler(std::size_t latency = 3, std::size_t history = 240);
+  // free query objects
+  ~gpu_profiler();
+
+  // owns gpu objects, so only one instance may refer to them
+  gpu_profiler(gpu_profiler const&) = delete;
+  gpu_profiler& operator=(gpu_profiler const&) = delete;
+
+  // read back finished frames and start timing a new one, which is skipped while all frames are in flight,
+  // the first call checks for timer queries, without them the profiler measures nothing
+  void begin_frame();
+  void end_frame();
+  // timestamps around a pass of the current frame, passes may nest and a pass may run more than once a frame
+  void begin(std::string const& pass);
+  void end(std::string const& pass);
+
+  bool supported() const;
+  // frames not measured because the gpu was more than latency frames behind
+  std::size_t skipped_frames() const;
+  // the frame first, then the passes in the order they were first timed
+  std::vector<pass_statistics> statistics() const;
+
+  // one bar per pass in the upper left corner of the bound framebuffer, full width is the budget of a frame,
+  // the bar shows the mean and its tick the 95th percentile
+  void draw_overlay(glm::uvec2 const& viewport, double budget_ms = 1000.0 / 60.0) const;
+  // statistics as one row per pass, throws if the file cannot be written
+  void write_csv(std::string const& file_path) const;
+  // statistics and the samples of the history per pass, throws if the file cannot be written
+  void write_json(std::string const& file_path) const;
+
+ private:
+  // pair of timestamps around one run of a pass
+  struct span {
+    std::size_t pass;
+    std::size_t begin;
+    std::size_t end;
+  };
+  // queries of a frame, reused when the frame was read back
+  struct frame {
+    std::vector<GLuint> queries;
+    std::size_t used = 0;
+    std::vector<span> spans;
+    bool in_flight = false;
+  };
+  // durations of a pass in the frames of the history, used as ring once full
+  struct pass {
+    std::string name;
+    std::vector<double> samples;
+    std::size_t next = 0;
+  };
+
+  std::size_t pass_index(std::string const& name);
+  std::size_t write_timestamp(frame& current);
+  // read back the frames whose timestamps all arrived, oldest first
+  void collect();
+  // samples of a pass from oldest to newest
+  std::vector<double> history(pass const& timed) const;
+
+  std::vector<frame> frames_;
+  std::vector<pass> passes_;
+  std::size_t history_;
+  // frame being recorded and oldest frame in flight
+  std::size_t current_;
+  std::size_t oldest_;
+  bool recording_;
+  bool checked_;
+  bool supported_;
+  std::size_t skipped_;
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef GRAVITY_COMPUTE_HPP
+#define GRAVITY_COMPUTE_HPP
+
+#include "structs.hpp"
+
+#include <glbinding/gl/types.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <array>
+#include <vector>
+
+// all pairs gravity integrated with leapfrog steps by the gravity compute shader, needs gl 4.3
+// positions and velocities never leave the gpu, every step writes the model matrices into a record buffer
+// that is drawn from directly with instanced attributes
+class gravity_compute {
+ public:
+  // one particle as uploaded and downloaded
+  struct particle {
+    // xyz position, w mass
+    glm::fvec4 position_mass;
+    // xyz velocity, w radius the particle is drawn with
+    glm::fvec4 velocity_radius;
+  };
+  // written for every particle, same layout as the planet draw records
+  struct record {
+    glm::fmat4 model_matrix;
+    glm::fvec4 draw_info;
+  };
+  // invocations per workgroup, as declared in the shader
+  static std::size_t const group_size = 128;
+
+  // softening must be above 0, the shader relies on it for the pair of a particle with itself
+  gravity_compute(float gravity = 1.0f, float softening = 0.01f);
+  // free buffers
+  ~gravity_compute();
+
+  // owns gpu objects, so only one instance may refer to them
+  gravity_compute(gravity_compute const&) = delete;
+  gravity_compute& operator=(gravity_compute const&) = delete;
+
+  // replace all particles and compute their first accelerations, draw_info is the same in every record
+  void upload(shader_program const& program, std::vector<particle> const& particles, glm::fvec4 const& draw_info);
+  // advance all particles by dt with a kick drift kick step, the records are ready for drawing afterwards
+  void step(shader_program const& program, float dt);
+  // read the particles back, waits for the gpu
+  std::vector<particle> download() const;
+
+  std::size_t size() const;
+  // one record per particle
+  GLuint record_buffer() const;
+
+ private:
+  // run one stage of the shader over all particles
+  void dispatch(shader_program const& program, float dt, GLuint stage) const;
+
+  float gravity_;
+  float softening_;
+  std::size_t count_;
+  // positions, velocities, accelerations and records, bound to the storage buffer bindings of the same index
+  std::array<GLuint, 4> buffers_;
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef HEADLESS_HPP
+#define HEADLESS_HPP
+
+#include <glm/gtc/type_precision.hpp>
+
+// forward declarations
+class Application;
+
+// rendering without window into an offscreen surface, for machines without display
+namespace headless {
+  struct options {
+    bool enabled = false;
+    unsigned frames = 300;
+    glm::uvec2 resolution{960u, 840u};
+  };
+
+  // take "--headless [frames]" and "--resolution WIDTHxHEIGHT" out of the arguments, the others keep their order
+  options read_options(int& argc, char* argv[]);
+  // whether this build has a backend for offscreen contexts
+  bool available();
+  // create an offscreen context with a default framebuffer of the resolution and load the gl bindings
+  void initialize(glm::uvec2 const& resolution, unsigned ver_major, unsigned ver_minor);
+
+  // times of one frame in milliseconds
+  struct frame_sample {
+    // from the start of the frame until the gpu finished it
+    double frame_ms = 0.0;
+    // spent in the render call of the application
+    double cpu_ms = 0.0;
+    // measured with a timer query, negative without timer queries
+    double gpu_ms = -1.0;
+  };
+
+  // load the shaders and size the application to the resolution, like the window does before the first frame
+  void prepare(Application& application, glm::uvec2 const& resolution);
+  // draw one frame and wait until the gpu finished it
+  frame_sample render_frame(Application& application);
+  // draw the frames as fast as possible and print the frame times, returns the exit status
+  int render_frames(Application& application, options const& settings);
+  // free the context and exit
+  void close_and_quit(int status);
+}
+
+#endif
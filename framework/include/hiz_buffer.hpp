@@ -0,0 +1,36 @@
+#ifndef HIZ_BUFFER_HPP
+#define HIZ_BUFFER_HPP
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <vector>
+
+// low resolution depth pyramid on the cpu for occlusion tests against a few large occluders,
+// each level stores the farthest depth of the texels it covers, depth grows away from the camera
+class hiz_buffer {
+ public:
+  hiz_buffer();
+
+  // set resolution of the finest level, clears the buffer
+  void resize(std::size_t width, std::size_t height);
+  // reset all texels to infinite depth
+  void clear();
+  // write an occluder covering all texels completely inside the disc, at a constant depth
+  void add_disc(glm::fvec2 const& center, float radius, float depth);
+  // compute coarser levels after all occluders are added
+  void build();
+  // whether everything inside the rectangle at the given nearest depth is hidden,
+  // coordinates are texels of the finest level
+  bool occluded(glm::fvec2 const& min, glm::fvec2 const& max, float depth) const;
+
+  std::size_t width() const;
+  std::size_t height() const;
+
+ private:
+  float texel(std::size_t level, std::size_t x, std::size_t y) const;
+
+  std::vector<std::vector<float>> levels_;
+  std::vector<glm::uvec2> sizes_;
+};
+
+#endif
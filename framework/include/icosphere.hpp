@@ -0,0 +1,34 @@
+#ifndef ICOSPHERE_HPP
+#define ICOSPHERE_HPP
+
+#include "model.hpp"
+
+#include <vector>
+
+namespace icosphere {
+
+// location of one detail level inside a packed model
+struct level {
+  // number of subdivisions of the base icosahedron
+  unsigned subdivisions;
+  // first index of the level in the index buffer
+  GLuint first_index;
+  // number of indices of the level
+  GLsizei num_indices;
+  // indices are relative to this vertex
+  GLint base_vertex;
+};
+
+// unit sphere with positions, normals, texcoords, tangents and bitangents
+model generate(unsigned subdivisions);
+
+// pack spheres with subdivisions from min to max into one model, levels are ordered coarse to fine
+model generate_levels(unsigned min_subdivisions, unsigned max_subdivisions, std::vector<level>& levels);
+
+// choose the coarsest level which spends at most pixels_per_triangle on the visible triangles
+// of a sphere covering a disc with the given radius in pixels
+std::size_t select_level(std::vector<level> const& levels, float pixel_radius, float pixels_per_triangle = 8.0f);
+
+}
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef KEPLER_HPP
+#define KEPLER_HPP
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <vector>
+
+namespace kepler {
+
+// classical orbital elements, angles in radians
+// the reference plane is the xz plane of the scene, y is up and orbits with all angles 0 move like the planets
+struct elements {
+  float semi_major_axis = 1.0f;
+  // 0 is a circle, must stay below 1
+  float eccentricity = 0.0f;
+  float inclination = 0.0f;
+  // longitude of the ascending node and argument of the periapsis
+  float ascending_node = 0.0f;
+  float periapsis = 0.0f;
+  // mean anomaly at time 0 and its change per second
+  float mean_anomaly = 0.0f;
+  float mean_motion = 0.0f;
+};
+
+// solve kepler's equation M = E - e sin(E) for the eccentric anomaly E in double precision
+double eccentric_anomaly(double mean_anomaly, double eccentricity);
+// position and velocity at the time in double precision, reference for the vectorized propagation
+void state(elements const& orbit, double time, glm::dvec3& position, glm::dvec3& velocity);
+
+// many orbits prepared for propagation, stored as structure of arrays so four are solved at once with sse
+class orbit_set {
+ public:
+  orbit_set();
+
+  void clear();
+  void reserve(std::size_t count);
+  void push_back(elements const& orbit);
+  std::size_t size() const;
+
+  // positions of orbits [begin, end) at the time, computed on the calling thread
+  // x, y and z of orbit i are written to out[i * stride], out[i * stride + 1] and out[i * stride + 2]
+  void propagate(double time, std::size_t begin, std::size_t end, float* out, std::size_t stride) const;
+  // positions of all orbits, computed in parallel
+  void propagate(double time, std::vector<glm::fvec3>& positions) const;
+
+ private:
+  // semi major axis times the direction to the periapsis
+  std::vector<float> periapsis_x_;
+  std::vector<float> periapsis_y_;
+  std::vector<float> periapsis_z_;
+  // semi minor axis times the direction of motion at the periapsis
+  std::vector<float> motion_x_;
+  std::vector<float> motion_y_;
+  std::vector<float> motion_z_;
+  std::vector<float> eccentricity_;
+  std::vector<float> mean_anomaly_;
+  std::vector<float> mean_motion_;
+};
+
+}
+
+#endif
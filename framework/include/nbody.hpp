@@ -0,0 +1,108 @@
+#ifndef NBODY_HPP
+#define NBODY_HPP
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace nbody {
+
+struct parameters {
+  // gravitational constant in scene units
+  double gravity = 1.0;
+  // plummer softening length, keeps the force of close encounters finite
+  double softening = 0.01;
+  // cells whose size divided by their distance is below the angle act as one mass, 0 sums all pairs
+  double opening_angle = 0.5;
+  // most particles in an octree leaf
+  std::size_t leaf_size = 8;
+};
+
+// energies at the current positions and velocities
+struct diagnostics {
+  double kinetic = 0.0;
+  double potential = 0.0;
+  double total = 0.0;
+  // change of the total energy relative to the first evaluation after particles were added
+  double drift = 0.0;
+};
+
+// particles under mutual gravity, forces from a barnes hut octree rebuilt every step
+class simulation {
+ public:
+  simulation();
+  explicit simulation(parameters const& params);
+
+  void clear();
+  void reserve(std::size_t count);
+  // returns the index of the particle, indices stay valid until clear
+  std::size_t add(double mass, glm::dvec3 const& position, glm::dvec3 const& velocity);
+  // particle bound to an earlier particle without a primary, like a moon to its planet: it moves with the acceleration
+  // of the primary plus the pull of the primary alone, so the tides of other particles cannot strip it off,
+  // and it does not act on other particles, throws for invalid primaries
+  std::size_t add(double mass, glm::dvec3 const& position, glm::dvec3 const& velocity, std::size_t primary);
+  std::size_t size() const;
+
+  // advance by dt with a kick drift kick leapfrog step, forces are computed in parallel
+  void step(double dt);
+  // rebuild the octree and compute accelerations and potentials at the current positions
+  void evaluate();
+  diagnostics energy();
+
+  double time() const;
+  parameters const& params() const;
+  glm::dvec3 const& position(std::size_t index) const;
+  glm::dvec3 const& velocity(std::size_t index) const;
+  double mass(std::size_t index) const;
+  // index of the primary the particle is bound to, or the particle count for free particles
+  std::size_t primary(std::size_t index) const;
+
+ private:
+  // cells are stored depth first, so the children of a cell follow it and next skips the subtree
+  struct cell {
+    glm::dvec3 center_of_mass;
+    double mass;
+    // distance to the mass center beyond which the cell acts as one mass
+    double open_distance;
+    // leaves own the sorted particles [first, first + count), inner cells have count 0
+    std::uint32_t first;
+    std::uint32_t count;
+    std::uint32_t next;
+  };
+
+  void build_tree();
+  // cell over sorted particles [begin, end) that lie in the cube at corner with edge length size
+  std::uint32_t build_cell(std::size_t begin, std::size_t end, unsigned level, glm::dvec3 const& corner, double size);
+  // acceleration and potential at a sorted particle
+  void gravity_at(std::size_t sorted, glm::dvec3& acceleration, double& potential) const;
+  // acceleration and potential at a particle bound to a primary, the primary must be evaluated
+  void satellite_gravity(std::size_t index, glm::dvec3& acceleration, double& potential) const;
+
+  parameters params_;
+  double time_;
+  // accelerations and potentials belong to the current positions
+  bool evaluated_;
+  bool has_initial_energy_;
+  double initial_energy_;
+
+  std::vector<glm::dvec3> positions_;
+  std::vector<glm::dvec3> velocities_;
+  std::vector<glm::dvec3> accelerations_;
+  std::vector<double> masses_;
+  std::vector<double> potentials_;
+  // primary of each particle, free ones have none, and the bound particles in the order they were added
+  std::vector<std::uint32_t> primaries_;
+  std::vector<std::uint32_t> satellites_;
+
+  // free particles in morton order of the last build
+  std::vector<std::uint64_t> keys_;
+  std::vector<std::uint32_t> order_;
+  std::vector<glm::dvec3> sorted_positions_;
+  std::vector<double> sorted_masses_;
+  std::vector<cell> cells_;
+};
+
+}
+
+#endif
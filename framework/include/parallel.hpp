@@ -0,0 +1,18 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <cstddef>
+#include <functional>
+
+namespace parallel {
+  // number of worker threads used for parallel loops, at least 1
+  unsigned thread_count();
+  // number of chunks a range of the given size is split into
+  unsigned chunk_count(std::size_t count, std::size_t grain);
+  // split [0, count) into chunks of at least grain elements and process them on worker threads,
+  // func receives the chunk index (smaller than chunk_count) and the half-open element range
+  void for_range(std::size_t count, std::size_t grain,
+                 std::function<void(unsigned chunk, std::size_t begin, std::size_t end)> const& func);
+}
+
+#endif
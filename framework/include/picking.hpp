@@ -0,0 +1,20 @@
+#ifndef PICKING_HPP
+#define PICKING_HPP
+
+#include <glm/gtc/type_precision.hpp>
+
+namespace picking {
+
+struct ray {
+  glm::fvec3 origin;
+  // normalized
+  glm::fvec3 direction;
+};
+
+// world space ray from the camera through a pixel, the pixel origin is the top left corner like in window coordinates
+// view is the world to camera matrix, the inverse of the camera transform
+ray screen_ray(glm::fvec2 const& pixel, glm::uvec2 const& viewport, glm::fmat4 const& projection, glm::fmat4 const& view);
+
+}
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef PIXEL_READBACK_HPP
+#define PIXEL_READBACK_HPP
+
+#include <glbinding/gl/types.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <array>
+
+// reads single pixels of an unsigned integer color attachment through pixel buffers,
+// results are fetched frames later once a fence signals, so the gpu pipeline never stalls
+class pixel_readback {
+ public:
+  pixel_readback();
+  // free buffers and fences
+  ~pixel_readback();
+
+  // owns gpu objects, so only one instance may refer to them
+  pixel_readback(pixel_readback const&) = delete;
+  pixel_readback& operator=(pixel_readback const&) = delete;
+
+  // copy pixel (x, y) of the attachment of the bound read framebuffer into a free buffer,
+  // y counts from the bottom, returns false if all buffers are still in flight
+  bool request(GLenum attachment, GLint x, GLint y);
+  // fetch the oldest finished request without waiting, returns false while it is in flight
+  bool poll(GLuint& value);
+  // whether a request is in flight
+  bool pending() const;
+
+ private:
+  struct slot {
+    GLuint buffer;
+    GLsync fence;
+  };
+
+  // requests in flight, handled in order
+  std::array<slot, 2> slots_;
+  std::size_t first_;
+  std::size_t count_;
+};
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef PROXIMITY_HPP
+#define PROXIMITY_HPP
+
+#include "culling.hpp"
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace proximity {
+
+struct parameters {
+  // spheres closer than this between their surfaces are in proximity, 0 reports only overlaps
+  float margin = 0.0f;
+  // insertion moves per sphere before the incremental sort gives up and sorts from scratch
+  std::size_t max_moves_per_sphere = 8;
+};
+
+// two spheres within the margin at some time of the last step, first < second
+struct contact {
+  std::uint32_t first;
+  std::uint32_t second;
+  // surface distance at the closest approach, negative while the spheres overlap
+  float distance;
+  // time of the closest approach as fraction of the step, 0 at the previous and 1 at the current update
+  float time;
+};
+
+enum class event_kind : std::uint8_t {
+  // the pair came within the margin during the last step
+  enter,
+  // the pair is no longer within the margin, the contact holds the values of the previous step
+  leave
+};
+
+struct event {
+  contact pair;
+  event_kind kind;
+};
+
+// work of the last update
+struct update_stats {
+  // pairs whose swept boxes overlap and went to the narrow phase
+  std::size_t broad_pairs = 0;
+  std::size_t contacts = 0;
+  // element moves of the insertion sort and whether it was replaced by a full sort
+  std::size_t moves = 0;
+  bool full_sort = false;
+};
+
+// proximity of moving spheres, sweep and prune over boxes around the path of each sphere since the last update,
+// the boxes are split into bands along a second axis and each band is swept against itself and the next one,
+// the sort order of the previous update is kept, so coherent motion only needs a few insertion moves and merges
+class detector {
+ public:
+  detector();
+  explicit detector(parameters const& params);
+
+  // forget the spheres, the next update starts from scratch
+  void clear();
+  // spheres at the end of the step, in the same order every update, a different count starts over
+  void update(culling::sphere_batch const& spheres);
+
+  // pairs within the margin during the last step, sorted by first and second
+  std::vector<contact> const& contacts() const;
+  // pairs that entered or left the margin in the last update
+  std::vector<event> const& events() const;
+  update_stats const& stats() const;
+  parameters const& params() const;
+
+ private:
+  // box around a sphere at its previous and current position, stored by band and in sweep order
+  struct swept_box {
+    glm::fvec3 min;
+    std::uint32_t index;
+    glm::fvec3 max;
+    std::uint32_t band;
+  };
+
+  // returns the largest half extent of a box along the band axis
+  float refresh_boxes(culling::sphere_batch const& spheres);
+  std::uint32_t band_of(swept_box const& box) const;
+  // choose the axes and bands from the current boxes and sort them from scratch
+  void rebuild();
+  // move boxes that changed their band and restore the sweep order within each band
+  void resort();
+  // pairs of a band with itself and with the next band
+  void sweep(culling::sphere_batch const& spheres, std::size_t band, std::vector<contact>& found, std::size_t& pairs) const;
+  // exact closest approach of two spheres moving linearly over the step, false if they stay apart
+  bool narrow_phase(culling::sphere_batch const& spheres, std::uint32_t a, std::uint32_t b, contact& result) const;
+
+  parameters params_;
+  // axis of the sweep and of the bands, the ones along which the spheres spread most when sorting from scratch
+  unsigned axis_;
+  unsigned band_axis_;
+  // bands are at least twice as high as the largest box half extent, so boxes only meet the neighbouring bands
+  float band_origin_;
+  float band_height_;
+  std::size_t band_count_;
+  // first box of each band and one past the last
+  std::vector<std::size_t> band_start_;
+  std::vector<glm::fvec3> previous_;
+  std::vector<swept_box> boxes_;
+  std::vector<swept_box> sorted_boxes_;
+  std::vector<contact> contacts_;
+  std::vector<contact> last_contacts_;
+  std::vector<event> events_;
+  // pairs found by each chunk of the parallel sweep
+  std::vector<std::vector<contact>> chunk_contacts_;
+  update_stats stats_;
+};
+
+}
+
+#endif
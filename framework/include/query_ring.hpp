@@ -0,0 +1,38 @@
+#ifndef QUERY_RING_HPP
+#define QUERY_RING_HPP
+
+#include <glbinding/gl/types.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <vector>
+
+// query objects of one target used round robin, results are read frames later
+// once available, so measuring never stalls the pipeline
+class query_ring {
+ public:
+  // size is the number of frames a result may take
+  query_ring(GLenum target, std::size_t size = 3);
+  // free query objects
+  ~query_ring();
+
+  // owns gpu objects, so only one instance may refer to them
+  query_ring(query_ring const&) = delete;
+  query_ring& operator=(query_ring const&) = delete;
+
+  // start a query, returns false and measures nothing if all queries are still in flight
+  bool begin();
+  // end the query started last, only if begin returned true
+  void end();
+  // fetch the oldest finished result without waiting, returns false while it is in flight
+  bool poll(GLuint64& result);
+
+ private:
+  GLenum target_;
+  std::vector<GLuint> queries_;
+  // queries in flight, handled in order
+  std::size_t first_;
+  std::size_t count_;
+};
+
+#endif
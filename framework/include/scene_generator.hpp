@@ -0,0 +1,23 @@
+#ifndef SCENE_GENERATOR_HPP
+#define SCENE_GENERATOR_HPP
+
+#include "model.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+class Node;
+
+namespace scene_generator {
+
+// planets on random orbits around the sun below holders added to root, each with moons around it,
+// root_p is the parent the holders refer to, texture paths cycle through the planet maps below texture_path
+// and are only stored, so a scene without a context passes an empty model and path
+void add_planets(Node& root, std::shared_ptr<Node> const& root_p, std::shared_ptr<Node> const& sun_p,
+                 model const& planet_model, std::string const& texture_path, std::size_t planets,
+                 unsigned moons_per_planet, unsigned seed);
+
+}
+
+#endif
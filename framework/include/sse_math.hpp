@@ -0,0 +1,48 @@
+#ifndef SSE_MATH_HPP
+#define SSE_MATH_HPP
+
+// sse2 helpers shared by the vectorized orbit evaluations, SSE_MATH is defined where they are available
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SSE_MATH
+
+#include <glm/gtc/constants.hpp>
+
+namespace sse_math {
+  // sine and cosine of four angles of moderate size, error below 1e-6
+  inline void sincos4(__m128 angle, __m128& sine, __m128& cosine) {
+    // quadrant and remainder in [-pi/4, pi/4], pi/2 split in two parts to keep the remainder exact
+    __m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(angle, _mm_set1_ps(2.0f / glm::pi<float>())));
+    __m128 q = _mm_cvtepi32_ps(quadrant);
+    __m128 r = _mm_sub_ps(angle, _mm_mul_ps(q, _mm_set1_ps(1.5707963705062866f)));
+    r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(-4.37113900018624283e-8f)));
+    __m128 r2 = _mm_mul_ps(r, r);
+
+    __m128 s = _mm_add_ps(_mm_set1_ps(1.0f / 120.0f), _mm_mul_ps(r2, _mm_set1_ps(-1.0f / 5040.0f)));
+    s = _mm_add_ps(_mm_set1_ps(-1.0f / 6.0f), _mm_mul_ps(r2, s));
+    s = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, r2), s));
+    __m128 c = _mm_add_ps(_mm_set1_ps(-1.0f / 720.0f), _mm_mul_ps(r2, _mm_set1_ps(1.0f / 40320.0f)));
+    c = _mm_add_ps(_mm_set1_ps(1.0f / 24.0f), _mm_mul_ps(r2, c));
+    c = _mm_add_ps(_mm_set1_ps(-0.5f), _mm_mul_ps(r2, c));
+    c = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(r2, c));
+
+    // odd quadrants swap sine and cosine, the second bit of the quadrant flips the sign
+    __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+    __m128 sine_sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+    __m128 cosine_sign = _mm_castsi128_ps(
+      _mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+    sine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s)), sine_sign);
+    cosine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c)), cosine_sign);
+  }
+
+  // offset + rate * time of two lanes, reduced to [-pi, pi] in double precision before rounding to float
+  inline __m128 reduce2(__m128d offset, __m128d rate, __m128d time) {
+    __m128d angle = _mm_add_pd(offset, _mm_mul_pd(rate, time));
+    __m128d turns = _mm_cvtepi32_pd(_mm_cvtpd_epi32(_mm_mul_pd(angle, _mm_set1_pd(1.0 / glm::two_pi<double>()))));
+    return _mm_cvtpd_ps(_mm_sub_pd(angle, _mm_mul_pd(turns, _mm_set1_pd(glm::two_pi<double>()))));
+  }
+}
+
+#endif
+
+#endif
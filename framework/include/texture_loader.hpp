@@ -7,6 +7,10 @@
 
 namespace texture_loader {
   pixel_data file(std::string const& file_name);
+  // bilinear resampling of 8 bit images, e.g. to fit them into a texture array
+  pixel_data resize(pixel_data const& image, std::size_t width, std::size_t height);
+  // expand 8 bit images to GL_RED, GL_RG, GL_RGB or GL_RGBA, grey is copied to all colors and missing alpha is opaque
+  pixel_data convert(pixel_data const& image, GLenum channels);
 }
 
 #endif
\ No newline at end of file
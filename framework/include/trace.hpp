@@ -0,0 +1,63 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <cstdint>
+#include <string>
+
+// cpu zones, counters and frame markers written as chrome trace_event json, viewable in chrome://tracing or perfetto,
+// the TRACE_ macros record only in builds with TRACING defined (cmake option ENABLE_TRACING) and are empty otherwise
+namespace trace {
+  // take "--trace FILE" out of the arguments, the others keep their order, returns an empty path without it
+  std::string read_options(int& argc, char* argv[]);
+
+  // record the events of all threads until stop
+  void start(std::string const& file_path);
+  // write the recorded events to the file of start and stop recording, nothing happens when not recording,
+  // no other thread may be inside a zone meanwhile
+  void stop();
+  bool recording();
+
+  // name the lane of the calling thread in the viewer, threads without a name are listed as workers
+  void thread_name(char const* name);
+  // value of a counter from now on, drawn as a graph over time
+  void counter(char const* name, double value);
+  // start of a frame, marked over all lanes
+  void frame_marker();
+
+  // time from construction to destruction on the calling thread, names must outlive the recording,
+  // like string literals, a detail such as a file name is copied, but only while recording,
+  // a recorded zone costs one time stamp read at each end and one appended event, so it stays above two reads
+  // of the counter, which take about 25 ns each where a virtual machine traps them
+  class zone {
+   public:
+    explicit zone(char const* name);
+    zone(char const* name, std::string const& detail);
+    ~zone();
+
+    zone(zone const&) = delete;
+    zone& operator=(zone const&) = delete;
+
+   private:
+    char const* name_;
+    std::uint64_t start_;
+    std::uint32_t detail_;
+    bool active_;
+  };
+}
+
+#define TRACE_JOIN_LINE(prefix, line) prefix##line
+#define TRACE_JOIN(prefix, line) TRACE_JOIN_LINE(prefix, line)
+
+#ifdef TRACING
+#define TRACE_ZONE(name) trace::zone TRACE_JOIN(trace_zone_, __LINE__){name}
+#define TRACE_ZONE_DETAIL(name, detail) trace::zone TRACE_JOIN(trace_zone_, __LINE__){name, detail}
+#define TRACE_COUNTER(name, value) trace::counter(name, double(value))
+#define TRACE_FRAME() trace::frame_marker()
+#else
+#define TRACE_ZONE(name) ((void)0)
+#define TRACE_ZONE_DETAIL(name, detail) ((void)0)
+#define TRACE_COUNTER(name, value) ((void)0)
+#define TRACE_FRAME() ((void)0)
+#endif
+
+#endif
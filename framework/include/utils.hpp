@@ -2,11 +2,13 @@
 #define UTILS_HPP
 
 #include <glbinding/gl/types.h>
+#include <glbinding/gl/extension.h>
 // use gl definitions from glbinding 
 using namespace gl;
 
 #include <glm/gtc/type_precision.hpp>
 
+#include <chrono>
 #include <map>
 #include <vector>
 
@@ -16,6 +18,8 @@ struct texture_object;
 namespace utils {
   // generate texture object from texture struct
   texture_object create_texture_object(pixel_data const& tex);
+  // generate 2d array texture object, all layers must have the same size, differing formats are converted to one
+  texture_object create_texture_array(std::vector<pixel_data> const& layers);
   // print bound textures for all texture units
   void print_bound_textures();
 
@@ -36,6 +40,15 @@ namespace utils {
 
   // calculate Vert+ FOV projection matrix
   glm::fmat4 calculate_projection_matrix(float aspect);
+
+  // check if the current context has at least the given version or provides the extension
+  bool supports(unsigned major, unsigned minor, GLextension extension);
+
+  // value below which the fraction of the sorted samples lies, interpolated between the two nearest samples,
+  // 0 without samples, shared by all frame time reports so their percentiles are comparable
+  double percentile(std::vector<double> const& sorted, double fraction);
+  // length of a steady clock duration in milliseconds
+  double milliseconds(std::chrono::steady_clock::duration const& duration);
 }
 
 #endif
\ No newline at end of file
@@ -1,6 +1,9 @@
 #ifndef WINDOW_HANDLER_HPP
 #define WINDOW_HANDLER_HPP
 
+#include "frame_stats.hpp"
+#include "gl_validation.hpp"
+
 #include <glm/gtc/type_precision.hpp>
 
 //dont load gl bindings from glfw
@@ -12,14 +15,15 @@ class Application;
 class GLFWwindow;
 
 namespace window_handler { 
-  // create window and set callbacks
-  GLFWwindow* initialize(glm::uvec2 const& resolution, unsigned ver_major, unsigned ver_minor);
+  // create window and set callbacks, with a debug context if the validation level reads the debug output
+  GLFWwindow* initialize(glm::uvec2 const& resolution, unsigned ver_major, unsigned ver_minor,
+                         gl_validation::options const& validation = gl_validation::options{});
   // load shader programs and update uniform locations
   void set_callback_object(GLFWwindow* window, Application* app);
   // free resources
   void close_and_quit(GLFWwindow* window, int status);
-    // calculate fps and show in window title
-  void show_fps(GLFWwindow* window);
+  // show the median and 99th percentile of the frame times and the hitches in the window title
+  void show_frame_stats(GLFWwindow* window, frame_stats::summary const& stats);
 }
 
 #endif
\ No newline at end of file
@@ -2,7 +2,22 @@
 
 GeometryNode::GeometryNode():
     Node{},
-    geometry_{}{}
+    geometry_{},
+    textureLayer_{-1},
+    normalTextureLayer_{-1}{}
+
+GeometryNode::GeometryNode(std::shared_ptr<Node> const& parent, std::string const& name, 
+                           std::string const& path, int depth, std::shared_ptr<Node> const& origin):
+    Node{parent, name, path, depth, origin},
+    geometry_{},
+    textureObject_{},
+    texPath_{},
+    texture_{},
+    hasNormalMap_{false},
+    texPaths_{},
+    textures_{},
+    textureLayer_{-1},
+    normalTextureLayer_{-1}{}
 
 GeometryNode::GeometryNode(std::shared_ptr<Node> const& parent, std::string const& name, 
                            std::string const& path, int depth, std::shared_ptr<Node> const& origin, std::string const& texPath /*int id,*/):
@@ -13,7 +28,9 @@ GeometryNode::GeometryNode(std::shared_ptr<Node> const& parent, std::string cons
     texture_{},
     hasNormalMap_{false},
     texPaths_{},
-    textures_{}{
+    textures_{},
+    textureLayer_{-1},
+    normalTextureLayer_{-1}{
         //load texture information and store in planet
         //std::cout<< texPath.substr(33, texPath.size()-37) << std::endl;
         setTexture(texPath_);
@@ -33,7 +50,9 @@ GeometryNode::GeometryNode(std::shared_ptr<Node> const& parent, std::string cons
     normalTexture_{},
     hasNormalMap_{true},
     texPaths_{},
-    textures_{}{
+    textures_{},
+    textureLayer_{-1},
+    normalTextureLayer_{-1}{
         setTexture(texPath_);
         setNormalTexture(normalTexPath_);
 
@@ -50,7 +69,9 @@ GeometryNode::GeometryNode(std::string const& name, std::string const& texPath,
     texture_{},
     hasNormalMap_{false},
     texPaths_{std::vector<std::string>{texPath,texPath2,texPath3,texPath4, texPath5, texPath6}}, 
-    textures_{}{
+    textures_{},
+    textureLayer_{-1},
+    normalTextureLayer_{-1}{
         setTextures(texPaths_);
 
     }
@@ -124,6 +145,23 @@ void GeometryNode::setHasNormalMapping(bool normalMapping) {
 
 }
 
+//Texture Arrays
+int GeometryNode::getTextureLayer() const{
+    return textureLayer_;
+}
+
+void GeometryNode::setTextureLayer(int layer){
+    textureLayer_ = layer;
+}
+
+int GeometryNode::getNormalTextureLayer() const{
+    return normalTextureLayer_;
+}
+
+void GeometryNode::setNormalTextureLayer(int layer){
+    normalTextureLayer_ = layer;
+}
+
 //Skybox
 std::vector<std::string> GeometryNode::getTexpaths() const{
      return texPaths_;
@@ -244,6 +244,22 @@ void Node::setHasNormalMapping(bool normalMapping) {
     //nothin to do here
 }
 
+int Node::getTextureLayer() const{
+    return -1;
+}
+
+void Node::setTextureLayer(int layer){
+    //nothing to do here
+}
+
+int Node::getNormalTextureLayer() const{
+    return -1;
+}
+
+void Node::setNormalTextureLayer(int layer){
+    //nothing to do here
+}
+
 
 // int Node::getPlanetID() const{
 //     return 0;
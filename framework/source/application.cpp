@@ -3,6 +3,7 @@
 #include "utils.hpp"
 #include "window_handler.hpp"
 #include "shader_loader.hpp"
+#include "trace.hpp"
 
 #include <glbinding/gl/gl.h>
 // use gl definitions from glbinding 
@@ -30,6 +31,7 @@ Application::~Application() {
 }
 
 void Application::reloadShaders(bool throwing) {
+  TRACE_ZONE("reloadShaders");
   // recompile shaders from source files
   update_shader_programs(m_shaders, throwing);
   // after shader programs are recompiled, uniform locations may change
@@ -72,6 +74,31 @@ void Application::mouse_callback(GLFWwindow* window, double pos_x, double pos_y)
   glfwSetCursorPos(window, 0.0, 0.0);
 }
 
+// handle mouse button input
+void Application::mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
+  int window_width = 0, window_height = 0;
+  int buffer_width = 0, buffer_height = 0;
+  glfwGetWindowSize(window, &window_width, &window_height);
+  glfwGetFramebufferSize(window, &buffer_width, &buffer_height);
+
+  double pos_x = 0.0, pos_y = 0.0;
+  // a disabled cursor steers the camera and stays hidden, use the window center as cursor
+  if (glfwGetInputMode(window, GLFW_CURSOR) == GLFW_CURSOR_DISABLED) {
+    pos_x = 0.5 * window_width;
+    pos_y = 0.5 * window_height;
+  }
+  else {
+    glfwGetCursorPos(window, &pos_x, &pos_y);
+  }
+  // window coordinates may differ from pixels on high dpi screens
+  if (window_width > 0 && window_height > 0) {
+    pos_x *= double(buffer_width) / double(window_width);
+    pos_y *= double(buffer_height) / double(window_height);
+  }
+  // pass input to derived class
+  mouseButtonCallback(button, action, mods, pos_x, pos_y);
+}
+
 // handle window resizing
 void Application::resize_callback(unsigned width, unsigned height) {
   // resize framebuffer
@@ -0,0 +1,193 @@
+#include "asteroid_belt.hpp"
+
+#include "icosphere.hpp"
+#include "parallel.hpp"
+
+#include <glm/geometric.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/common.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <unordered_map>
+
+namespace asteroid_belt {
+
+// uniform float in [0, 1), independent of the standard library distributions so a seed gives the same belt everywhere
+static float unit(std::mt19937& generator) {
+  return float(generator() >> 8) * (1.0f / 16777216.0f);
+}
+
+// mixes bits of a key into a well distributed hash
+static std::uint32_t hash(std::uint32_t key) {
+  key ^= key >> 16;
+  key *= 0x7feb352du;
+  key ^= key >> 15;
+  key *= 0x846ca68bu;
+  key ^= key >> 16;
+  return key;
+}
+
+belt::belt()
+ :params_{}
+ ,orbits_{}
+ ,packed_{}
+{}
+
+void belt::generate(parameters const& params) {
+  params_ = params;
+  params_.variants = std::max(params_.variants, 1u);
+  params_.layers = std::min(std::max(params_.layers, 1u), 256u);
+
+  std::size_t count = params_.count;
+  orbits_.clear();
+  orbits_.reserve(count);
+  packed_.resize(count);
+
+  std::mt19937 generator{params_.seed};
+  float inner_squared = params_.inner_radius * params_.inner_radius;
+  float outer_squared = params_.outer_radius * params_.outer_radius;
+  for (std::size_t i = 0; i < count; ++i) {
+    kepler::elements orbit{};
+    // uniform density over the ring area
+    orbit.semi_major_axis = std::sqrt(inner_squared + (outer_squared - inner_squared) * unit(generator));
+    orbit.eccentricity = params_.max_eccentricity * unit(generator);
+    orbit.inclination = params_.max_inclination * (2.0f * unit(generator) - 1.0f);
+    orbit.ascending_node = glm::two_pi<float>() * unit(generator);
+    orbit.periapsis = glm::two_pi<float>() * unit(generator);
+    orbit.mean_anomaly = glm::two_pi<float>() * unit(generator);
+    orbit.mean_motion = params_.inner_speed * std::pow(params_.inner_radius / orbit.semi_major_axis, 1.5f);
+    orbits_.push_back(orbit);
+
+    // cubed, so most rocks are small
+    float size = unit(generator);
+    size = params_.min_size + (params_.max_size - params_.min_size) * size * size * size;
+    std::uint32_t quantized_size = std::uint32_t(std::lround(size / params_.max_size * 65535.0f));
+    std::uint32_t spin = generator() & 0xffu;
+    std::uint32_t layer = std::uint32_t(unit(generator) * float(params_.layers)) % params_.layers;
+    packed_[i] = std::min(quantized_size, 65535u) | spin << 16 | layer << 24;
+  }
+}
+
+void belt::propagate(double time, std::vector<instance>& instances) const {
+  instances.resize(size());
+  instance* out = instances.data();
+  parallel::for_range(size(), 16384, [&](unsigned, std::size_t begin, std::size_t end) {
+    // kepler writes the positions into the instances, four floats apart
+    orbits_.propagate(time, begin, end, &out[0].position.x, sizeof(instance) / sizeof(float));
+    for (std::size_t i = begin; i < end; ++i) {
+      out[i].packed = packed_[i];
+    }
+  });
+}
+
+std::size_t belt::size() const {
+  return packed_.size();
+}
+
+parameters const& belt::params() const {
+  return params_;
+}
+
+std::size_t belt::variant_first(unsigned variant) const {
+  return size() * std::size_t(variant) / params_.variants;
+}
+
+std::size_t belt::variant_count(unsigned variant) const {
+  return variant_first(variant + 1) - variant_first(variant);
+}
+
+model rock(std::uint32_t seed, unsigned subdivisions) {
+  model sphere = icosphere::generate(subdivisions);
+  std::size_t const components = sphere.vertex_bytes / sizeof(GLfloat);
+
+  // vertices duplicated at the texture seam share their position, so the key is built from it
+  auto position_key = [](GLfloat const* vertex) {
+    std::uint64_t key = 0;
+    for (unsigned c = 0; c < 3; ++c) {
+      key = key << 21 | (std::uint64_t(std::lround((vertex[c] + 2.0f) * 4096.0f)) & 0x1fffffu);
+    }
+    return key;
+  };
+
+  // push each vertex in or out along the sphere normal
+  for (std::size_t v = 0; v < sphere.vertex_num; ++v) {
+    GLfloat* vertex = &sphere.data[v * components];
+    std::uint64_t key = position_key(vertex);
+    std::uint32_t random = hash(seed ^ hash(std::uint32_t(key) ^ hash(std::uint32_t(key >> 32))));
+    float scale = 0.7f + 0.4f * float(random >> 8) * (1.0f / 16777216.0f);
+    for (unsigned c = 0; c < 3; ++c) {
+      vertex[c] *= scale;
+    }
+  }
+
+  // smooth normals from the displaced faces, accumulated over all copies of a position
+  std::unordered_map<std::uint64_t, glm::fvec3> normals{};
+  for (std::size_t i = 0; i < sphere.indices.size(); i += 3) {
+    glm::fvec3 corners[3];
+    for (unsigned c = 0; c < 3; ++c) {
+      GLfloat const* vertex = &sphere.data[sphere.indices[i + c] * components];
+      corners[c] = glm::fvec3{vertex[0], vertex[1], vertex[2]};
+    }
+    glm::fvec3 face_normal = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+    for (unsigned c = 0; c < 3; ++c) {
+      normals[position_key(&sphere.data[sphere.indices[i + c] * components])] += face_normal;
+    }
+  }
+  for (std::size_t v = 0; v < sphere.vertex_num; ++v) {
+    GLfloat* vertex = &sphere.data[v * components];
+    glm::fvec3 normal = glm::normalize(normals[position_key(vertex)]);
+    vertex[3] = normal.x;
+    vertex[4] = normal.y;
+    vertex[5] = normal.z;
+  }
+  return sphere;
+}
+
+std::vector<pixel_data> rock_textures(std::uint32_t seed, unsigned layers, std::size_t size) {
+  std::vector<pixel_data> textures{};
+  for (unsigned layer = 0; layer < layers; ++layer) {
+    std::uint32_t layer_seed = hash(seed + layer * 0x9e3779b9u);
+    // lattice value at a wrapped cell, so the texture tiles
+    auto lattice = [&](std::size_t x, std::size_t y, std::size_t cells) {
+      return float(hash(layer_seed ^ hash(std::uint32_t((y % cells) * cells + x % cells) + std::uint32_t(cells))) >> 8)
+             * (1.0f / 16777216.0f);
+    };
+
+    // base tint between grey and brown
+    float warmth = float(hash(layer_seed) >> 8) * (1.0f / 16777216.0f);
+    glm::fvec3 tint = glm::mix(glm::fvec3{0.55f, 0.55f, 0.55f}, glm::fvec3{0.6f, 0.48f, 0.36f}, warmth);
+
+    std::vector<std::uint8_t> pixels(size * size * 4);
+    for (std::size_t y = 0; y < size; ++y) {
+      for (std::size_t x = 0; x < size; ++x) {
+        // three octaves of bilinear value noise
+        float value = 0.0f;
+        float amplitude = 0.5f;
+        for (std::size_t cells = 4; cells <= 16; cells *= 2) {
+          float fx = float(x * cells) / float(size);
+          float fy = float(y * cells) / float(size);
+          std::size_t cx = std::size_t(fx);
+          std::size_t cy = std::size_t(fy);
+          float tx = fx - float(cx);
+          float ty = fy - float(cy);
+          float top = glm::mix(lattice(cx, cy, cells), lattice(cx + 1, cy, cells), tx);
+          float bottom = glm::mix(lattice(cx, cy + 1, cells), lattice(cx + 1, cy + 1, cells), tx);
+          value += amplitude * glm::mix(top, bottom, ty);
+          amplitude *= 0.5f;
+        }
+        glm::fvec3 color = glm::clamp(tint * (0.5f + value), 0.0f, 1.0f);
+        std::uint8_t* pixel = &pixels[(y * size + x) * 4];
+        pixel[0] = std::uint8_t(color.r * 255.0f);
+        pixel[1] = std::uint8_t(color.g * 255.0f);
+        pixel[2] = std::uint8_t(color.b * 255.0f);
+        pixel[3] = 255;
+      }
+    }
+    textures.push_back(pixel_data{pixels, GL_RGBA, GL_UNSIGNED_BYTE, size, size});
+  }
+  return textures;
+}
+
+}
@@ -0,0 +1,338 @@
+#include "bvh.hpp"
+#include "parallel.hpp"
+
+#include <glm/geometric.hpp>
+#include <glm/common.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace bvh {
+
+// traversal stacks are bounded by the tree depth, median splits keep it logarithmic
+static std::size_t const max_depth = 64;
+// nodes per thread when refitting
+static std::size_t const refit_grain = 16384;
+
+static void sphere_bounds(culling::sphere_batch const& spheres, std::uint32_t index, glm::fvec3& min, glm::fvec3& max) {
+  glm::fvec3 center{spheres.x[index], spheres.y[index], spheres.z[index]};
+  glm::fvec3 radius{spheres.radius[index]};
+  min = center - radius;
+  max = center + radius;
+}
+
+// whether the ray hits the box before max_distance, enter is the ray parameter of the entry point
+static bool ray_box(glm::fvec3 const& origin, glm::fvec3 const& inverse_direction, node const& box, float max_distance,
+                    float& enter) {
+  glm::fvec3 t_min = (box.min - origin) * inverse_direction;
+  glm::fvec3 t_max = (box.max - origin) * inverse_direction;
+  glm::fvec3 t_near = glm::min(t_min, t_max);
+  glm::fvec3 t_far = glm::max(t_min, t_max);
+  enter = std::max(std::max(t_near.x, t_near.y), std::max(t_near.z, 0.0f));
+  float exit = std::min(std::min(t_far.x, t_far.y), std::min(t_far.z, max_distance));
+  return enter <= exit;
+}
+
+static float point_box_distance(glm::fvec3 const& point, node const& box) {
+  glm::fvec3 outside = glm::max(glm::max(box.min - point, point - box.max), glm::fvec3{0.0f});
+  return glm::length(outside);
+}
+
+tree::tree()
+ :nodes_{}
+ ,primitives_{}
+{}
+
+void tree::build(culling::sphere_batch const& spheres, std::uint32_t leaf_size) {
+  nodes_.clear();
+  primitives_.resize(spheres.size());
+  for (std::uint32_t i = 0; i < primitives_.size(); ++i) {
+    primitives_[i] = i;
+  }
+  if (primitives_.empty()) {
+    return;
+  }
+  // a balanced binary tree has less than 2n / leaf_size nodes
+  nodes_.reserve(2 * primitives_.size() / std::max(leaf_size, 1u) + 1);
+  build_recursive(spheres, 0, std::uint32_t(primitives_.size()), std::max(leaf_size, 1u));
+}
+
+std::uint32_t tree::build_recursive(culling::sphere_batch const& spheres, std::uint32_t begin, std::uint32_t end,
+                                    std::uint32_t leaf_size) {
+  std::uint32_t index = std::uint32_t(nodes_.size());
+  nodes_.push_back(node{});
+
+  glm::fvec3 min{std::numeric_limits<float>::max()};
+  glm::fvec3 max{-std::numeric_limits<float>::max()};
+  glm::fvec3 center_min = min;
+  glm::fvec3 center_max = max;
+  for (std::uint32_t i = begin; i < end; ++i) {
+    glm::fvec3 sphere_min, sphere_max;
+    sphere_bounds(spheres, primitives_[i], sphere_min, sphere_max);
+    min = glm::min(min, sphere_min);
+    max = glm::max(max, sphere_max);
+    glm::fvec3 center{spheres.x[primitives_[i]], spheres.y[primitives_[i]], spheres.z[primitives_[i]]};
+    center_min = glm::min(center_min, center);
+    center_max = glm::max(center_max, center);
+  }
+  nodes_[index].min = min;
+  nodes_[index].max = max;
+
+  if (end - begin <= leaf_size) {
+    nodes_[index].offset = begin;
+    nodes_[index].count = end - begin;
+    return index;
+  }
+
+  // split at the median center along the axis with the largest center spread
+  glm::fvec3 extent = center_max - center_min;
+  int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+  std::vector<float> const& coordinate = axis == 0 ? spheres.x : (axis == 1 ? spheres.y : spheres.z);
+  std::uint32_t middle = begin + (end - begin) / 2;
+  std::nth_element(primitives_.begin() + begin, primitives_.begin() + middle, primitives_.begin() + end,
+                   [&coordinate](std::uint32_t a, std::uint32_t b) { return coordinate[a] < coordinate[b]; });
+
+  build_recursive(spheres, begin, middle, leaf_size);
+  std::uint32_t second = build_recursive(spheres, middle, end, leaf_size);
+  nodes_[index].offset = second;
+  nodes_[index].count = 0;
+  return index;
+}
+
+void tree::refit(culling::sphere_batch const& spheres) {
+  // leaves read the spheres and are independent of each other
+  parallel::for_range(nodes_.size(), refit_grain, [&](unsigned, std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+      node& current = nodes_[i];
+      if (current.count == 0) {
+        continue;
+      }
+      sphere_bounds(spheres, primitives_[current.offset], current.min, current.max);
+      for (std::uint32_t p = current.offset + 1; p < current.offset + current.count; ++p) {
+        glm::fvec3 sphere_min, sphere_max;
+        sphere_bounds(spheres, primitives_[p], sphere_min, sphere_max);
+        current.min = glm::min(current.min, sphere_min);
+        current.max = glm::max(current.max, sphere_max);
+      }
+    }
+  });
+
+  // children are stored after their parent, so walking backwards updates them first
+  for (std::size_t i = nodes_.size(); i-- > 0;) {
+    node& current = nodes_[i];
+    if (current.count == 0) {
+      node const& first = nodes_[i + 1];
+      node const& second = nodes_[current.offset];
+      current.min = glm::min(first.min, second.min);
+      current.max = glm::max(first.max, second.max);
+    }
+  }
+}
+
+void tree::frustum_query(culling::frustum const& planes, culling::sphere_batch const& spheres,
+                         std::vector<std::uint32_t>& visible) const {
+  visible.clear();
+  if (nodes_.empty()) {
+    return;
+  }
+
+  // bit p of a mask is set while plane p still has to be tested, boxes fully inside a plane clear it
+  struct entry {
+    std::uint32_t node;
+    std::uint32_t mask;
+  };
+  entry stack[max_depth * 2];
+  std::size_t stack_size = 0;
+  stack[stack_size++] = entry{0, (1u << 6) - 1};
+
+  while (stack_size > 0) {
+    entry current = stack[--stack_size];
+    node const& box = nodes_[current.node];
+    glm::fvec3 center = (box.min + box.max) * 0.5f;
+    glm::fvec3 half_extent = (box.max - box.min) * 0.5f;
+
+    bool outside = false;
+    std::uint32_t mask = current.mask;
+    for (std::uint32_t p = 0; p < 6; ++p) {
+      if (!(mask & (1u << p))) {
+        continue;
+      }
+      glm::fvec4 const& plane = planes.planes[p];
+      float distance = glm::dot(glm::fvec3{plane}, center) + plane.w;
+      float radius = glm::dot(glm::abs(glm::fvec3{plane}), half_extent);
+      if (distance < -radius) {
+        outside = true;
+        break;
+      }
+      if (distance >= radius) {
+        mask &= ~(1u << p);
+      }
+    }
+    if (outside) {
+      continue;
+    }
+
+    if (mask == 0) {
+      // subtree lies completely inside, its primitives are stored contiguously
+      // from the leftmost to the rightmost leaf
+      std::uint32_t leftmost = current.node;
+      while (nodes_[leftmost].count == 0) {
+        leftmost = leftmost + 1;
+      }
+      std::uint32_t rightmost = current.node;
+      while (nodes_[rightmost].count == 0) {
+        rightmost = nodes_[rightmost].offset;
+      }
+      visible.insert(visible.end(), primitives_.begin() + nodes_[leftmost].offset,
+                     primitives_.begin() + nodes_[rightmost].offset + nodes_[rightmost].count);
+      continue;
+    }
+
+    if (box.count > 0) {
+      // the box of a leaf may intersect while its spheres do not, they are tested four at a time
+      for (std::uint32_t first = box.offset; first < box.offset + box.count; first += 4) {
+        std::uint32_t count = std::min(box.offset + box.count - first, 4u);
+        unsigned inside = culling::cull_four(planes, spheres, &primitives_[first], count);
+        for (std::uint32_t p = 0; p < count; ++p) {
+          if (inside & (1u << p)) {
+            visible.push_back(primitives_[first + p]);
+          }
+        }
+      }
+    }
+    else {
+      stack[stack_size++] = entry{box.offset, mask};
+      stack[stack_size++] = entry{current.node + 1, mask};
+    }
+  }
+}
+
+bool tree::ray_query(glm::fvec3 const& origin, glm::fvec3 const& direction, culling::sphere_batch const& spheres,
+                     hit& result, float max_distance) const {
+  result = hit{};
+  result.distance = max_distance;
+  bool found = false;
+  if (nodes_.empty()) {
+    return false;
+  }
+
+  glm::fvec3 inverse_direction = 1.0f / direction;
+  // nodes are stored with their entry distance, so nodes behind a closer hit can be skipped
+  struct entry {
+    std::uint32_t node;
+    float enter;
+  };
+  entry stack[max_depth];
+  std::size_t stack_size = 0;
+  float enter = 0.0f;
+  if (ray_box(origin, inverse_direction, nodes_[0], result.distance, enter)) {
+    stack[stack_size++] = entry{0, enter};
+  }
+
+  while (stack_size > 0) {
+    entry current = stack[--stack_size];
+    if (current.enter > result.distance) {
+      continue;
+    }
+    node const& box = nodes_[current.node];
+    if (box.count > 0) {
+      for (std::uint32_t p = box.offset; p < box.offset + box.count; ++p) {
+        std::uint32_t index = primitives_[p];
+        glm::fvec3 to_center = glm::fvec3{spheres.x[index], spheres.y[index], spheres.z[index]} - origin;
+        float projection = glm::dot(to_center, direction);
+        float radius = spheres.radius[index];
+        float discriminant = projection * projection - glm::dot(to_center, to_center) + radius * radius;
+        if (discriminant < 0.0f) {
+          continue;
+        }
+        float root = std::sqrt(discriminant);
+        // entry point, or exit point when starting inside the sphere
+        float t = projection - root >= 0.0f ? projection - root : projection + root;
+        if (t >= 0.0f && t < result.distance) {
+          result.index = index;
+          result.distance = t;
+          found = true;
+        }
+      }
+      continue;
+    }
+
+    // visit the nearer child first, push it last
+    entry first{current.node + 1, 0.0f};
+    entry second{box.offset, 0.0f};
+    bool hit_first = ray_box(origin, inverse_direction, nodes_[first.node], result.distance, first.enter);
+    bool hit_second = ray_box(origin, inverse_direction, nodes_[second.node], result.distance, second.enter);
+    if (hit_first && hit_second) {
+      if (first.enter > second.enter) {
+        std::swap(first, second);
+      }
+      stack[stack_size++] = second;
+      stack[stack_size++] = first;
+    }
+    else if (hit_first) {
+      stack[stack_size++] = first;
+    }
+    else if (hit_second) {
+      stack[stack_size++] = second;
+    }
+  }
+  return found;
+}
+
+bool tree::nearest_query(glm::fvec3 const& point, culling::sphere_batch const& spheres, hit& result) const {
+  result = hit{};
+  bool found = false;
+  if (nodes_.empty()) {
+    return false;
+  }
+
+  // nodes are stored with their distance, so nodes farther than the current best can be skipped
+  struct entry {
+    std::uint32_t node;
+    float distance;
+  };
+  entry stack[max_depth];
+  std::size_t stack_size = 0;
+  stack[stack_size++] = entry{0, point_box_distance(point, nodes_[0])};
+
+  while (stack_size > 0) {
+    entry current = stack[--stack_size];
+    if (current.distance >= result.distance) {
+      continue;
+    }
+    node const& box = nodes_[current.node];
+    if (box.count > 0) {
+      for (std::uint32_t p = box.offset; p < box.offset + box.count; ++p) {
+        std::uint32_t index = primitives_[p];
+        glm::fvec3 center{spheres.x[index], spheres.y[index], spheres.z[index]};
+        float distance = std::max(glm::length(point - center) - spheres.radius[index], 0.0f);
+        if (distance < result.distance) {
+          result.index = index;
+          result.distance = distance;
+          found = true;
+        }
+      }
+      continue;
+    }
+
+    // visit the nearer child first, push it last
+    entry first{current.node + 1, point_box_distance(point, nodes_[current.node + 1])};
+    entry second{box.offset, point_box_distance(point, nodes_[box.offset])};
+    if (first.distance > second.distance) {
+      std::swap(first, second);
+    }
+    stack[stack_size++] = second;
+    stack[stack_size++] = first;
+  }
+  return found;
+}
+
+std::size_t tree::size() const {
+  return primitives_.size();
+}
+
+std::vector<node> const& tree::nodes() const {
+  return nodes_;
+}
+
+}
@@ -0,0 +1,356 @@
+#include "chebyshev.hpp"
+
+#include "parallel.hpp"
+#include "sse_math.hpp"
+
+#include <glm/geometric.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace chebyshev {
+
+// first bytes and version of a table file, the numbers are stored in the byte order of the machine
+static char const file_magic[4] = {'C', 'H', 'E', 'B'};
+static std::uint32_t const file_version = 2;
+// points per segment and coefficient at which the fit is compared with the analytic orbit
+static unsigned const error_samples = 2;
+// the sampled residual is mostly float rounding of the coefficients and of the analytic orbit,
+// which may be larger between the samples
+static float const residual_safety = 2.0f;
+// floats per degree in memory, x, y, z and a zero so a degree loads as one sse vector, files leave the zero out
+static unsigned const stride = 4;
+
+template<typename T>
+static void write_value(std::ofstream& file, T const& value) {
+  file.write(reinterpret_cast<char const*>(&value), sizeof(T));
+}
+
+template<typename T>
+static T read_value(std::ifstream& file) {
+  T value{};
+  file.read(reinterpret_cast<char*>(&value), sizeof(T));
+  return value;
+}
+
+// fnv-1a over the bytes of the value
+template<typename T>
+static void hash_value(std::uint64_t& hash, T const& value) {
+  unsigned char const* bytes = reinterpret_cast<unsigned char const*>(&value);
+  for (std::size_t i = 0; i < sizeof(T); ++i) {
+    hash = (hash ^ bytes[i]) * 1099511628211ull;
+  }
+}
+
+std::uint64_t hash(ephemeris::body_set const& bodies, parameters const& params) {
+  std::uint64_t hash = 14695981039346656037ull;
+  hash_value(hash, params.start);
+  hash_value(hash, params.end);
+  hash_value(hash, params.segment_length);
+  hash_value(hash, params.degree);
+  hash_value(hash, std::uint64_t(bodies.size()));
+  for (std::size_t b = 0; b < bodies.size(); ++b) {
+    ephemeris::body_orbit const& orbit = bodies.orbit(b);
+    hash_value(hash, std::uint64_t(orbit.path.size()));
+    for (char c : orbit.path) {
+      hash_value(hash, c);
+    }
+    hash_value(hash, std::uint64_t(orbit.levels.size()));
+    for (auto const& level : orbit.levels) {
+      hash_value(hash, level.frame);
+      hash_value(hash, level.speed);
+      hash_value(hash, level.offset);
+    }
+  }
+  return hash;
+}
+
+table::table()
+ :start_{0.0}
+ ,segment_length_{1.0}
+ ,segment_count_{0}
+ ,degree_{0}
+ ,source_hash_{0}
+ ,paths_{}
+ ,max_errors_{}
+ ,coefficients_{}
+{}
+
+void table::clear() {
+  segment_count_ = 0;
+  source_hash_ = 0;
+  paths_.clear();
+  max_errors_.clear();
+  coefficients_.clear();
+}
+
+void table::fit(ephemeris::body_set const& bodies, parameters const& params) {
+  clear();
+  start_ = params.start;
+  segment_length_ = std::max(params.segment_length, 1e-6);
+  segment_count_ = std::max(std::size_t(std::ceil((params.end - params.start) / segment_length_)), std::size_t{1});
+  degree_ = params.degree;
+  source_hash_ = hash(bodies, params);
+  for (std::size_t b = 0; b < bodies.size(); ++b) {
+    paths_.push_back(bodies.orbit(b).path);
+  }
+
+  unsigned const nodes = degree_ + 1;
+  std::size_t const segment_floats = stride * std::size_t(nodes);
+  coefficients_.resize(bodies.size() * segment_count_ * segment_floats);
+  std::vector<float> segment_errors(bodies.size() * segment_count_);
+
+  // x of the chebyshev nodes in [-1, 1], the polynomials interpolate the orbit there,
+  // the finer nodes estimate the coefficients the polynomials leave out
+  unsigned const fine_nodes = 2 * nodes;
+  std::vector<double> node_x(nodes);
+  for (unsigned k = 0; k < nodes; ++k) {
+    node_x[k] = std::cos(glm::pi<double>() * (double(k) + 0.5) / double(nodes));
+  }
+  std::vector<double> fine_x(fine_nodes);
+  for (unsigned k = 0; k < fine_nodes; ++k) {
+    fine_x[k] = std::cos(glm::pi<double>() * (double(k) + 0.5) / double(fine_nodes));
+  }
+
+  parallel::for_range(bodies.size() * segment_count_, 64, [&](unsigned, std::size_t begin, std::size_t end) {
+    std::vector<glm::dvec3> values(nodes);
+    std::vector<glm::dvec3> fine_values(fine_nodes);
+    for (std::size_t item = begin; item < end; ++item) {
+      std::size_t body = item / segment_count_;
+      double segment_start = start_ + double(item % segment_count_) * segment_length_;
+      double half = 0.5 * segment_length_;
+      double middle = segment_start + half;
+      for (unsigned k = 0; k < nodes; ++k) {
+        values[k] = glm::dvec3{bodies.position(body, middle + half * node_x[k])};
+      }
+      for (unsigned k = 0; k < fine_nodes; ++k) {
+        fine_values[k] = glm::dvec3{bodies.position(body, middle + half * fine_x[k])};
+      }
+
+      // discrete cosine transform of the node values gives the coefficients
+      float* coefficients = &coefficients_[item * segment_floats];
+      for (unsigned j = 0; j < nodes; ++j) {
+        glm::dvec3 sum{0.0};
+        for (unsigned k = 0; k < nodes; ++k) {
+          sum += values[k] * std::cos(glm::pi<double>() * double(j) * (double(k) + 0.5) / double(nodes));
+        }
+        sum *= (j == 0 ? 1.0 : 2.0) / double(nodes);
+        for (unsigned axis = 0; axis < 3; ++axis) {
+          coefficients[j * stride + axis] = float(sum[axis]);
+        }
+      }
+
+      // the interpolation error is at most twice the sum of the coefficients above the degree,
+      // which the finer fit approximates well once they decay
+      glm::dvec3 tail{0.0};
+      for (unsigned j = nodes; j < fine_nodes; ++j) {
+        glm::dvec3 sum{0.0};
+        for (unsigned k = 0; k < fine_nodes; ++k) {
+          sum += fine_values[k] * std::cos(glm::pi<double>() * double(j) * (double(k) + 0.5) / double(fine_nodes));
+        }
+        tail += glm::abs(sum) * (2.0 / double(fine_nodes));
+      }
+
+      // evenly spaced samples fall between the nodes, where the interpolation error is largest,
+      // all of them inside this segment since the neighbours may not be fitted yet
+      float residual = 0.0f;
+      unsigned const checks = error_samples * nodes;
+      for (unsigned c = 0; c < checks; ++c) {
+        double time = segment_start + segment_length_ * (double(c) + 0.5) / double(checks);
+        residual = std::max(residual, glm::distance(position(body, time), bodies.position(body, time)));
+      }
+      segment_errors[item] = float(2.0 * glm::length(tail)) + residual_safety * residual;
+    }
+  });
+
+  max_errors_.assign(bodies.size(), 0.0f);
+  for (std::size_t item = 0; item < segment_errors.size(); ++item) {
+    float& error = max_errors_[item / segment_count_];
+    error = std::max(error, segment_errors[item]);
+  }
+}
+
+void table::save(std::string const& file_path) const {
+  std::ofstream file(file_path, std::ios::binary);
+  if (!file) {
+    throw std::logic_error("chebyshev: cannot write " + file_path);
+  }
+  file.write(file_magic, sizeof(file_magic));
+  write_value(file, file_version);
+  write_value(file, source_hash_);
+  write_value(file, std::uint32_t(paths_.size()));
+  write_value(file, std::uint32_t(segment_count_));
+  write_value(file, std::uint32_t(degree_));
+  write_value(file, start_);
+  write_value(file, segment_length_);
+  for (std::size_t b = 0; b < paths_.size(); ++b) {
+    write_value(file, std::uint32_t(paths_[b].size()));
+    file.write(paths_[b].data(), std::streamsize(paths_[b].size()));
+    write_value(file, max_errors_[b]);
+  }
+  for (std::size_t i = 0; i < coefficients_.size(); i += stride) {
+    file.write(reinterpret_cast<char const*>(&coefficients_[i]), std::streamsize(3 * sizeof(float)));
+  }
+  if (!file) {
+    throw std::logic_error("chebyshev: cannot write " + file_path);
+  }
+}
+
+void table::load(std::string const& file_path) {
+  std::ifstream file(file_path, std::ios::binary);
+  char magic[sizeof(file_magic)] = {};
+  file.read(magic, sizeof(magic));
+  if (!file || std::memcmp(magic, file_magic, sizeof(magic)) != 0 || read_value<std::uint32_t>(file) != file_version) {
+    throw std::logic_error("chebyshev: " + file_path + " is no orbit table");
+  }
+
+  std::uint64_t source_hash = read_value<std::uint64_t>(file);
+  std::uint32_t body_count = read_value<std::uint32_t>(file);
+  std::uint32_t segment_count = read_value<std::uint32_t>(file);
+  std::uint32_t degree = read_value<std::uint32_t>(file);
+  double start = read_value<double>(file);
+  double segment_length = read_value<double>(file);
+  std::vector<std::string> paths{};
+  std::vector<float> max_errors{};
+  for (std::uint32_t b = 0; b < body_count && file; ++b) {
+    std::string path(read_value<std::uint32_t>(file), '\0');
+    file.read(&path[0], std::streamsize(path.size()));
+    paths.push_back(path);
+    max_errors.push_back(read_value<float>(file));
+  }
+  std::vector<float> coefficients(std::size_t(body_count) * segment_count * stride * (degree + 1));
+  for (std::size_t i = 0; i < coefficients.size() && file; i += stride) {
+    file.read(reinterpret_cast<char*>(&coefficients[i]), std::streamsize(3 * sizeof(float)));
+  }
+  if (!file || segment_count == 0 || !(segment_length > 0.0)) {
+    throw std::logic_error("chebyshev: " + file_path + " is truncated");
+  }
+
+  start_ = start;
+  segment_length_ = segment_length;
+  segment_count_ = segment_count;
+  degree_ = degree;
+  source_hash_ = source_hash;
+  paths_.swap(paths);
+  max_errors_.swap(max_errors);
+  coefficients_.swap(coefficients);
+}
+
+std::size_t table::size() const {
+  return paths_.size();
+}
+
+std::size_t table::find(std::string const& path) const {
+  for (std::size_t i = 0; i < paths_.size(); ++i) {
+    if (paths_[i] == path) {
+      return i;
+    }
+  }
+  throw std::logic_error("chebyshev: no body with path " + path);
+}
+
+std::string const& table::path(std::size_t body) const {
+  return paths_[body];
+}
+
+std::uint64_t table::source_hash() const {
+  return source_hash_;
+}
+
+float table::max_error(std::size_t body) const {
+  return max_errors_[body];
+}
+
+bool table::covers(double time) const {
+  return segment_count_ > 0 && time >= start() && time <= end();
+}
+
+double table::start() const {
+  return start_;
+}
+
+double table::end() const {
+  return start_ + double(segment_count_) * segment_length_;
+}
+
+std::size_t table::segment_count() const {
+  return segment_count_;
+}
+
+std::size_t table::bytes() const {
+  return coefficients_.size() * sizeof(float);
+}
+
+float const* table::segment(std::size_t body, double time, float& u) const {
+  // time in segment lengths from the start, clamped to the window
+  double scaled = std::min(std::max((time - start_) / segment_length_, 0.0), double(segment_count_));
+  std::size_t index = std::min(std::size_t(scaled), segment_count_ - 1);
+  // time within the segment mapped to [-1, 1]
+  u = float(2.0 * (scaled - double(index)) - 1.0);
+  return &coefficients_[((body * segment_count_) + index) * stride * (degree_ + 1)];
+}
+
+glm::fvec3 table::position(std::size_t body, double time) const {
+  float u = 0.0f;
+  float const* c = segment(body, time, u);
+  // clenshaw recurrence for the three coordinates at once
+  glm::fvec3 b1{0.0f};
+  glm::fvec3 b2{0.0f};
+  for (unsigned j = degree_; j > 0; --j) {
+    glm::fvec3 b0 = 2.0f * u * b1 - b2 + glm::fvec3{c[j * stride], c[j * stride + 1], c[j * stride + 2]};
+    b2 = b1;
+    b1 = b0;
+  }
+  return u * b1 - b2 + glm::fvec3{c[0], c[1], c[2]};
+}
+
+void table::positions(std::size_t body, double const* times, std::size_t count, float* x, float* y, float* z) const {
+  std::size_t i = 0;
+#ifdef SSE_MATH
+  // four independent recurrences side by side hide their latency, each lane holds x, y and z of one time
+  for (; i + 4 <= count; i += 4) {
+    float const* c[4];
+    __m128 u[4];
+    __m128 two_u[4];
+    __m128 b1[4];
+    __m128 b2[4];
+    for (unsigned lane = 0; lane < 4; ++lane) {
+      float segment_u = 0.0f;
+      c[lane] = segment(body, times[i + lane], segment_u);
+      u[lane] = _mm_set1_ps(segment_u);
+      two_u[lane] = _mm_add_ps(u[lane], u[lane]);
+      b1[lane] = _mm_setzero_ps();
+      b2[lane] = _mm_setzero_ps();
+    }
+    for (unsigned j = degree_; j > 0; --j) {
+      for (unsigned lane = 0; lane < 4; ++lane) {
+        __m128 b0 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(two_u[lane], b1[lane]), b2[lane]), _mm_loadu_ps(c[lane] + j * stride));
+        b2[lane] = b1[lane];
+        b1[lane] = b0;
+      }
+    }
+    __m128 value[4];
+    for (unsigned lane = 0; lane < 4; ++lane) {
+      value[lane] = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(u[lane], b1[lane]), b2[lane]), _mm_loadu_ps(c[lane]));
+    }
+    _MM_TRANSPOSE4_PS(value[0], value[1], value[2], value[3]);
+    _mm_storeu_ps(x + i, value[0]);
+    _mm_storeu_ps(y + i, value[1]);
+    _mm_storeu_ps(z + i, value[2]);
+  }
+#endif
+  // remaining times, or all of them without SSE
+  for (; i < count; ++i) {
+    glm::fvec3 p = position(body, times[i]);
+    x[i] = p.x;
+    y[i] = p.y;
+    z[i] = p.z;
+  }
+}
+
+}
@@ -0,0 +1,143 @@
+#include "culling.hpp"
+
+#include <glm/geometric.hpp>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define CULLING_SSE
+#endif
+
+namespace culling {
+
+void sphere_batch::clear() {
+  x.clear();
+  y.clear();
+  z.clear();
+  radius.clear();
+}
+
+void sphere_batch::push_back(glm::fvec3 const& center, float sphere_radius) {
+  x.push_back(center.x);
+  y.push_back(center.y);
+  z.push_back(center.z);
+  radius.push_back(sphere_radius);
+}
+
+std::size_t sphere_batch::size() const {
+  return radius.size();
+}
+
+frustum extract_frustum(glm::fmat4 const& view_projection) {
+  // rows of the matrix, glm matrices are stored column major
+  glm::fvec4 row[4];
+  for (int i = 0; i < 4; ++i) {
+    row[i] = glm::fvec4{view_projection[0][i], view_projection[1][i], view_projection[2][i], view_projection[3][i]};
+  }
+
+  frustum result{};
+  // left, right, bottom, top, near, far
+  result.planes[0] = row[3] + row[0];
+  result.planes[1] = row[3] - row[0];
+  result.planes[2] = row[3] + row[1];
+  result.planes[3] = row[3] - row[1];
+  result.planes[4] = row[3] + row[2];
+  result.planes[5] = row[3] - row[2];
+  // normalize so the plane equation yields euclidean distances
+  for (auto& plane : result.planes) {
+    plane /= glm::length(glm::fvec3{plane});
+  }
+  return result;
+}
+
+bool sphere_visible(frustum const& planes, glm::fvec3 const& center, float radius) {
+  for (auto const& plane : planes.planes) {
+    if (glm::dot(glm::fvec3{plane}, center) + plane.w < -radius) {
+      return false;
+    }
+  }
+  return true;
+}
+
+#ifdef CULLING_SSE
+// planes with every component in all four lanes
+struct wide_planes {
+  __m128 x[6];
+  __m128 y[6];
+  __m128 z[6];
+  __m128 w[6];
+
+  explicit wide_planes(frustum const& planes) {
+    for (std::size_t p = 0; p < 6; ++p) {
+      x[p] = _mm_set1_ps(planes.planes[p].x);
+      y[p] = _mm_set1_ps(planes.planes[p].y);
+      z[p] = _mm_set1_ps(planes.planes[p].z);
+      w[p] = _mm_set1_ps(planes.planes[p].w);
+    }
+  }
+};
+
+// four spheres against all planes at once, bit i is set if sphere i lies outside of one
+static int outside_mask(wide_planes const& planes, __m128 x, __m128 y, __m128 z, __m128 radius) {
+  __m128 const zero = _mm_setzero_ps();
+  __m128 negative_radius = _mm_sub_ps(zero, radius);
+  __m128 outside = zero;
+  for (std::size_t p = 0; p < 6; ++p) {
+    __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planes.x[p], x), _mm_mul_ps(planes.y[p], y)),
+                                 _mm_add_ps(_mm_mul_ps(planes.z[p], z), planes.w[p]));
+    outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negative_radius));
+  }
+  return _mm_movemask_ps(outside);
+}
+#endif
+
+std::size_t cull_spheres(frustum const& planes, sphere_batch const& spheres, std::vector<std::uint8_t>& visible) {
+  std::size_t const count = spheres.size();
+  visible.resize(count);
+  std::size_t num_visible = 0;
+  std::size_t i = 0;
+
+#ifdef CULLING_SSE
+  wide_planes const wide{planes};
+  for (; i + 4 <= count; i += 4) {
+    int mask = outside_mask(wide, _mm_loadu_ps(&spheres.x[i]), _mm_loadu_ps(&spheres.y[i]),
+                            _mm_loadu_ps(&spheres.z[i]), _mm_loadu_ps(&spheres.radius[i]));
+    for (std::size_t lane = 0; lane < 4; ++lane) {
+      std::uint8_t inside = (mask & (1 << lane)) ? 0 : 1;
+      visible[i + lane] = inside;
+      num_visible += inside;
+    }
+  }
+#endif
+
+  // remaining spheres, or all of them without SSE
+  for (; i < count; ++i) {
+    bool inside = sphere_visible(planes, glm::fvec3{spheres.x[i], spheres.y[i], spheres.z[i]}, spheres.radius[i]);
+    visible[i] = inside ? 1 : 0;
+    num_visible += inside ? 1 : 0;
+  }
+  return num_visible;
+}
+
+unsigned cull_four(frustum const& planes, sphere_batch const& spheres, std::uint32_t const* indices, std::size_t count) {
+  unsigned visible = 0;
+#ifdef CULLING_SSE
+  if (count == 4) {
+    // gathered into lanes, the spheres of a leaf are not stored next to each other
+    std::uint32_t a = indices[0], b = indices[1], c = indices[2], d = indices[3];
+    int mask = outside_mask(wide_planes{planes}, _mm_setr_ps(spheres.x[a], spheres.x[b], spheres.x[c], spheres.x[d]),
+                            _mm_setr_ps(spheres.y[a], spheres.y[b], spheres.y[c], spheres.y[d]),
+                            _mm_setr_ps(spheres.z[a], spheres.z[b], spheres.z[c], spheres.z[d]),
+                            _mm_setr_ps(spheres.radius[a], spheres.radius[b], spheres.radius[c], spheres.radius[d]));
+    return unsigned(~mask) & 0xfu;
+  }
+#endif
+  for (std::size_t i = 0; i < count && i < 4; ++i) {
+    std::uint32_t index = indices[i];
+    if (sphere_visible(planes, glm::fvec3{spheres.x[index], spheres.y[index], spheres.z[index]}, spheres.radius[index])) {
+      visible |= 1u << i;
+    }
+  }
+  return visible;
+}
+
+}
@@ -0,0 +1,314 @@
+#include "ephemeris.hpp"
+
+#include "Node.hpp"
+#include "parallel.hpp"
+#include "sse_math.hpp"
+
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace ephemeris {
+
+// times evaluated together, the sines and cosines of a block stay on the stack
+static std::size_t const block_size = 64;
+
+// angle of a rotation with the speed at the time, reduced in double precision so late times keep their accuracy
+static float reduced_angle(float speed, double time) {
+  return float(std::remainder(double(speed) * time, glm::two_pi<double>()));
+}
+
+// sines and cosines of the rotation angles at count times
+static void rotation_block(float speed, double const* times, std::size_t count, float* sines, float* cosines) {
+  std::size_t i = 0;
+#ifdef SSE_MATH
+  __m128d const zero = _mm_setzero_pd();
+  __m128d const speed2 = _mm_set1_pd(double(speed));
+  for (; i + 4 <= count; i += 4) {
+    __m128 low = sse_math::reduce2(zero, speed2, _mm_loadu_pd(times + i));
+    __m128 high = sse_math::reduce2(zero, speed2, _mm_loadu_pd(times + i + 2));
+    __m128 sine{};
+    __m128 cosine{};
+    sse_math::sincos4(_mm_movelh_ps(low, high), sine, cosine);
+    _mm_storeu_ps(sines + i, sine);
+    _mm_storeu_ps(cosines + i, cosine);
+  }
+#endif
+  // remaining times, or all of them without SSE
+  for (; i < count; ++i) {
+    float angle = reduced_angle(speed, times[i]);
+    sines[i] = std::sin(angle);
+    cosines[i] = std::cos(angle);
+  }
+}
+
+// moves count points by the offset of the level, rotates them around y and applies the frame
+static void apply_level(orbit_level const& level, float const* sines, float const* cosines, std::size_t count,
+                        float* x, float* y, float* z) {
+  glm::fmat4 const& f = level.frame;
+  std::size_t i = 0;
+#ifdef SSE_MATH
+  __m128 const offset_x = _mm_set1_ps(level.offset.x);
+  __m128 const offset_y = _mm_set1_ps(level.offset.y);
+  __m128 const offset_z = _mm_set1_ps(level.offset.z);
+  for (; i + 4 <= count; i += 4) {
+    __m128 sine = _mm_loadu_ps(sines + i);
+    __m128 cosine = _mm_loadu_ps(cosines + i);
+    __m128 px = _mm_add_ps(_mm_loadu_ps(x + i), offset_x);
+    __m128 py = _mm_add_ps(_mm_loadu_ps(y + i), offset_y);
+    __m128 pz = _mm_add_ps(_mm_loadu_ps(z + i), offset_z);
+    __m128 rx = _mm_add_ps(_mm_mul_ps(cosine, px), _mm_mul_ps(sine, pz));
+    __m128 rz = _mm_sub_ps(_mm_mul_ps(cosine, pz), _mm_mul_ps(sine, px));
+    for (int row = 0; row < 3; ++row) {
+      __m128 value = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(f[0][row]), rx), _mm_mul_ps(_mm_set1_ps(f[1][row]), py)),
+                                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(f[2][row]), rz), _mm_set1_ps(f[3][row])));
+      _mm_storeu_ps((row == 0 ? x : row == 1 ? y : z) + i, value);
+    }
+  }
+#endif
+  for (; i < count; ++i) {
+    glm::fvec3 p = glm::fvec3{x[i], y[i], z[i]} + level.offset;
+    glm::fvec4 rotated{cosines[i] * p.x + sines[i] * p.z, p.y, cosines[i] * p.z - sines[i] * p.x, 1.0f};
+    glm::fvec4 moved = f * rotated;
+    x[i] = moved.x;
+    y[i] = moved.y;
+    z[i] = moved.z;
+  }
+}
+
+// right multiplies the matrix with a rotation around y
+static glm::fmat4 rotate_y(glm::fmat4 const& matrix, float sine, float cosine) {
+  glm::fmat4 result{matrix};
+  result[0] = matrix[0] * cosine - matrix[2] * sine;
+  result[2] = matrix[0] * sine + matrix[2] * cosine;
+  return result;
+}
+
+#ifdef SSE_MATH
+// matrices of four times, component c of the column major matrix in m[c]
+static void multiply4(__m128* m, glm::fmat4 const& frame) {
+  __m128 product[16];
+  for (int column = 0; column < 4; ++column) {
+    for (int row = 0; row < 4; ++row) {
+      __m128 sum = _mm_mul_ps(m[row], _mm_set1_ps(frame[column][0]));
+      for (int k = 1; k < 4; ++k) {
+        sum = _mm_add_ps(sum, _mm_mul_ps(m[k * 4 + row], _mm_set1_ps(frame[column][k])));
+      }
+      product[column * 4 + row] = sum;
+    }
+  }
+  std::copy(product, product + 16, m);
+}
+
+static void rotate_y4(__m128* m, __m128 sine, __m128 cosine) {
+  for (int row = 0; row < 4; ++row) {
+    __m128 x = m[row];
+    __m128 z = m[8 + row];
+    m[row] = _mm_sub_ps(_mm_mul_ps(x, cosine), _mm_mul_ps(z, sine));
+    m[8 + row] = _mm_add_ps(_mm_mul_ps(x, sine), _mm_mul_ps(z, cosine));
+  }
+}
+
+static void translate4(__m128* m, glm::fvec3 const& offset) {
+  for (int row = 0; row < 4; ++row) {
+    __m128 moved = _mm_add_ps(_mm_mul_ps(m[row], _mm_set1_ps(offset.x)), _mm_mul_ps(m[4 + row], _mm_set1_ps(offset.y)));
+    m[12 + row] = _mm_add_ps(m[12 + row], _mm_add_ps(moved, _mm_mul_ps(m[8 + row], _mm_set1_ps(offset.z))));
+  }
+}
+#endif
+
+body_orbit orbit_of(Node const& body) {
+  body_orbit orbit{};
+  orbit.path = body.getPath();
+  orbit.self_rotation = body.getSelfRotation();
+  orbit.radius = body.getRadius();
+
+  auto origin = body.getOrigin();
+  if (body.getDepth() == 4 && origin) {
+    // moons first rotate around their planet, which rotates around the sun from its local frame
+    orbit.levels.push_back(orbit_level{origin->getLocalTransform(), origin->getSpeed(), -origin->getDistanceOrigin()});
+    orbit.levels.push_back(orbit_level{body.getLocalTransform(), body.getSpeed(), -body.getDistanceOrigin()});
+  } else {
+    orbit.levels.push_back(orbit_level{body.getWorldTransform() * body.getLocalTransform(), body.getSpeed(),
+                                       -body.getDistanceOrigin()});
+  }
+  return orbit;
+}
+
+glm::fmat4 place(body_orbit const& orbit, glm::fvec3 const& position, double time) {
+  glm::fmat4 model_matrix = glm::translate(glm::fmat4{}, position);
+  model_matrix = glm::rotate(model_matrix, reduced_angle(orbit.self_rotation, time), glm::fvec3{0.0f, 1.0f, 0.0f});
+  return glm::scale(model_matrix, glm::fvec3{orbit.radius, orbit.radius, orbit.radius});
+}
+
+body_set::body_set()
+ :orbits_{}
+{}
+
+void body_set::clear() {
+  orbits_.clear();
+}
+
+std::size_t body_set::add(body_orbit const& orbit) {
+  orbits_.push_back(orbit);
+  return orbits_.size() - 1;
+}
+
+void body_set::add_scene(Node const& root) {
+  // children before their parents and holding nodes skipped, like the flat body list of the renderer
+  for (auto const& child : root.getChildrenList()) {
+    add_scene(*child);
+    if (child->getDepth() == 2 || child->getDepth() == 4) {
+      add(orbit_of(*child));
+    }
+  }
+}
+
+std::size_t body_set::size() const {
+  return orbits_.size();
+}
+
+std::size_t body_set::find(std::string const& path) const {
+  for (std::size_t i = 0; i < orbits_.size(); ++i) {
+    if (orbits_[i].path == path) {
+      return i;
+    }
+  }
+  throw std::logic_error("ephemeris: no body with path " + path);
+}
+
+body_orbit const& body_set::orbit(std::size_t index) const {
+  return orbits_[index];
+}
+
+glm::fmat4 body_set::transform(std::size_t index, double time) const {
+  body_orbit const& orbit = orbits_[index];
+  glm::fmat4 model_matrix{};
+  for (auto const& level : orbit.levels) {
+    model_matrix = glm::rotate(model_matrix * level.frame, reduced_angle(level.speed, time), glm::fvec3{0.0f, 1.0f, 0.0f});
+    model_matrix = glm::translate(model_matrix, level.offset);
+  }
+  model_matrix = glm::rotate(model_matrix, reduced_angle(orbit.self_rotation, time), glm::fvec3{0.0f, 1.0f, 0.0f});
+  return glm::scale(model_matrix, glm::fvec3{orbit.radius, orbit.radius, orbit.radius});
+}
+
+glm::fvec3 body_set::position(std::size_t index, double time) const {
+  return glm::fvec3{transform(index, time)[3]};
+}
+
+void body_set::positions(std::size_t index, double const* times, std::size_t count, float* x, float* y, float* z) const {
+  body_orbit const& orbit = orbits_[index];
+  float sines[block_size];
+  float cosines[block_size];
+  for (std::size_t first = 0; first < count; first += block_size) {
+    std::size_t block = std::min(block_size, count - first);
+    std::fill(x + first, x + first + block, 0.0f);
+    std::fill(y + first, y + first + block, 0.0f);
+    std::fill(z + first, z + first + block, 0.0f);
+    // the innermost rotation moves the origin of the body first, the own rotation and scale leave it in place
+    for (auto level = orbit.levels.rbegin(); level != orbit.levels.rend(); ++level) {
+      rotation_block(level->speed, times + first, block, sines, cosines);
+      apply_level(*level, sines, cosines, block, x + first, y + first, z + first);
+    }
+  }
+}
+
+void body_set::transforms(std::size_t index, double const* times, std::size_t count, float* const* matrix) const {
+  body_orbit const& orbit = orbits_[index];
+  std::size_t const rotations = orbit.levels.size() + 1;
+  std::vector<float> sines(rotations * block_size);
+  std::vector<float> cosines(rotations * block_size);
+  for (std::size_t first = 0; first < count; first += block_size) {
+    std::size_t block = std::min(block_size, count - first);
+    // trigonometry of all levels and the own rotation first, then the matrix products of four times at once
+    for (std::size_t r = 0; r < rotations; ++r) {
+      float speed = r < orbit.levels.size() ? orbit.levels[r].speed : orbit.self_rotation;
+      rotation_block(speed, times + first, block, &sines[r * block_size], &cosines[r * block_size]);
+    }
+    std::size_t i = 0;
+#ifdef SSE_MATH
+    __m128 const radius = _mm_set1_ps(orbit.radius);
+    for (; i + 4 <= block; i += 4) {
+      __m128 m[16];
+      for (int c = 0; c < 16; ++c) {
+        m[c] = _mm_set1_ps(c % 5 == 0 ? 1.0f : 0.0f);
+      }
+      for (std::size_t r = 0; r < orbit.levels.size(); ++r) {
+        multiply4(m, orbit.levels[r].frame);
+        rotate_y4(m, _mm_loadu_ps(&sines[r * block_size + i]), _mm_loadu_ps(&cosines[r * block_size + i]));
+        translate4(m, orbit.levels[r].offset);
+      }
+      std::size_t self = orbit.levels.size() * block_size + i;
+      rotate_y4(m, _mm_loadu_ps(&sines[self]), _mm_loadu_ps(&cosines[self]));
+      for (int c = 0; c < 16; ++c) {
+        _mm_storeu_ps(matrix[c] + first + i, c < 12 ? _mm_mul_ps(m[c], radius) : m[c]);
+      }
+    }
+#endif
+    // remaining times, or all of them without SSE
+    for (; i < block; ++i) {
+      glm::fmat4 model_matrix{};
+      for (std::size_t r = 0; r < orbit.levels.size(); ++r) {
+        model_matrix = rotate_y(model_matrix * orbit.levels[r].frame, sines[r * block_size + i], cosines[r * block_size + i]);
+        model_matrix = glm::translate(model_matrix, orbit.levels[r].offset);
+      }
+      std::size_t self = orbit.levels.size() * block_size + i;
+      model_matrix = rotate_y(model_matrix, sines[self], cosines[self]);
+      model_matrix = glm::scale(model_matrix, glm::fvec3{orbit.radius, orbit.radius, orbit.radius});
+      for (int c = 0; c < 16; ++c) {
+        matrix[c][first + i] = model_matrix[c / 4][c % 4];
+      }
+    }
+  }
+}
+
+columns body_set::query(std::vector<std::string> const& paths, std::vector<double> const& times, bool matrices) const {
+  columns result{};
+  query(paths, times, matrices, result);
+  return result;
+}
+
+void body_set::query(std::vector<std::string> const& paths, std::vector<double> const& times, bool matrices,
+                   columns& result) const {
+  // unknown paths throw before anything is computed
+  std::vector<std::size_t> indices{};
+  for (auto const& path : paths) {
+    indices.push_back(find(path));
+  }
+
+  std::size_t const count = indices.size() * times.size();
+  result.bodies = indices.size();
+  result.times = times.size();
+  result.x.resize(count);
+  result.y.resize(count);
+  result.z.resize(count);
+  for (auto& component : result.matrix) {
+    component.resize(matrices ? count : 0);
+  }
+  if (count == 0) {
+    return;
+  }
+
+  // chunks run over the flattened samples, so few bodies at many times split as well as many bodies at few times
+  parallel::for_range(count, 4096, [&](unsigned, std::size_t begin, std::size_t end) {
+    while (begin < end) {
+      std::size_t body = begin / times.size();
+      std::size_t time = begin % times.size();
+      std::size_t block = std::min(end - begin, times.size() - time);
+      positions(indices[body], &times[time], block, &result.x[begin], &result.y[begin], &result.z[begin]);
+      if (matrices) {
+        float* matrix[16];
+        for (int c = 0; c < 16; ++c) {
+          matrix[c] = &result.matrix[c][begin];
+        }
+        transforms(indices[body], &times[time], block, matrix);
+      }
+      begin += block;
+    }
+  });
+}
+
+}
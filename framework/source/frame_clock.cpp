@@ -0,0 +1,46 @@
+#include "frame_clock.hpp"
+
+//dont load gl bindings from glfw
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+#include <chrono>
+
+namespace frame_clock {
+
+enum class source {glfw, steady, fixed_step};
+
+static source current = source::glfw;
+static std::chrono::steady_clock::time_point steady_start{};
+static double fixed_time = 0.0;
+static double fixed_step = 0.0;
+
+double now() {
+  switch (current) {
+    case source::steady:
+      return std::chrono::duration<double>(std::chrono::steady_clock::now() - steady_start).count();
+    case source::fixed_step:
+      return fixed_time;
+    default:
+      return glfwGetTime();
+  }
+}
+
+void use_steady_clock() {
+  current = source::steady;
+  steady_start = std::chrono::steady_clock::now();
+}
+
+void use_fixed_step(double start, double step) {
+  current = source::fixed_step;
+  fixed_time = start;
+  fixed_step = step;
+}
+
+void tick() {
+  if (current == source::fixed_step) {
+    fixed_time += fixed_step;
+  }
+}
+
+}
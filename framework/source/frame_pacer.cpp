@@ -0,0 +1,171 @@
+#include "frame_pacer.hpp"
+
+#include "utils.hpp"
+
+//dont load gl bindings from glfw
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+// sleeps observed before the estimate weighs new ones less, so it keeps following the scheduler
+static std::size_t const sleep_history = 1000;
+
+static char const* vsync_name(frame_pacer::vsync mode) {
+  switch (mode) {
+    case frame_pacer::vsync::off: return "off";
+    case frame_pacer::vsync::on: return "on";
+    case frame_pacer::vsync::adaptive: return "adaptive";
+  }
+  return "unknown";
+}
+
+frame_pacer::parameters frame_pacer::read_options(int& argc, char* argv[]) {
+  parameters params{};
+  int kept = 1;
+  for (int i = 1; i < argc; ++i) {
+    std::string argument{argv[i]};
+    if (argument == "--fps") {
+      if (i + 1 >= argc) {
+        throw std::logic_error("frame_pacer: --fps needs the target frame rate");
+      }
+      params.target_fps = std::strtod(argv[++i], nullptr);
+      if (params.target_fps <= 0.0) {
+        throw std::logic_error("frame_pacer: the target frame rate must be positive");
+      }
+    }
+    else if (argument == "--vsync") {
+      std::string mode = i + 1 < argc ? argv[++i] : "";
+      if (mode == "off") {
+        params.swap = vsync::off;
+      }
+      else if (mode == "on") {
+        params.swap = vsync::on;
+      }
+      else if (mode == "adaptive") {
+        params.swap = vsync::adaptive;
+      }
+      else {
+        throw std::logic_error("frame_pacer: --vsync needs one of off, on or adaptive");
+      }
+    }
+    else {
+      argv[kept++] = argv[i];
+    }
+  }
+  argc = kept;
+  return params;
+}
+
+frame_pacer::frame_pacer()
+ :frame_pacer(parameters{})
+{}
+
+frame_pacer::frame_pacer(parameters const& params)
+ :params_(params)
+ ,period_{}
+ ,deadline_{}
+ ,last_report_{}
+ ,started_{false}
+ ,errors_{}
+ ,missed_{0}
+ ,sleep_estimate_{2.0}
+ ,sleep_mean_{1.0}
+ ,sleep_variance_{0.0}
+ ,sleeps_{0}
+{
+  if (params_.target_fps > 0.0) {
+    period_ = std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double>(1.0 / params_.target_fps));
+  }
+}
+
+void frame_pacer::set_swap_interval() {
+  vsync applied = params_.swap;
+  // a negative interval allows late swaps to tear instead of waiting for the next refresh
+  if (applied == vsync::adaptive && !glfwExtensionSupported("WGL_EXT_swap_control_tear")
+                                 && !glfwExtensionSupported("GLX_EXT_swap_control_tear")) {
+    applied = vsync::on;
+  }
+  glfwSwapInterval(applied == vsync::off ? 0 : (applied == vsync::on ? 1 : -1));
+
+  std::cout << "Vsync: " << vsync_name(applied);
+  if (params_.target_fps > 0.0) {
+    std::cout << ", frame rate limited to " << params_.target_fps << " fps";
+  }
+  std::cout << std::endl;
+}
+
+void frame_pacer::wait() {
+  if (params_.target_fps <= 0.0) {
+    return;
+  }
+  clock_type::time_point now = clock_type::now();
+  if (!started_) {
+    deadline_ = now;
+    last_report_ = now;
+    started_ = true;
+    return;
+  }
+
+  deadline_ += period_;
+  if (now > deadline_) {
+    // a late frame starts at once, and the following ones keep their period from it instead of catching up
+    ++missed_;
+    errors_.push_back(utils::milliseconds(now - deadline_));
+    deadline_ = now;
+  }
+  else {
+    wait_until(deadline_);
+    errors_.push_back(utils::milliseconds(clock_type::now() - deadline_));
+  }
+
+  if (std::chrono::duration<double>(deadline_ - last_report_).count() >= params_.report_interval) {
+    report();
+    last_report_ = deadline_;
+  }
+}
+
+void frame_pacer::wait_until(clock_type::time_point deadline) {
+  // a sleep may return much later than asked, so only sleep while even a late wake up is in time
+  while (utils::milliseconds(deadline - clock_type::now()) > sleep_estimate_) {
+    clock_type::time_point start = clock_type::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    double observed = utils::milliseconds(clock_type::now() - start);
+
+    // running mean and variance of the sleeps, weighted exponentially once the history is full
+    sleeps_ = std::min(sleeps_ + 1, sleep_history);
+    double weight = 1.0 / double(sleeps_);
+    double delta = observed - sleep_mean_;
+    sleep_mean_ += weight * delta;
+    sleep_variance_ = (1.0 - weight) * (sleep_variance_ + weight * delta * delta);
+    double deviation = std::sqrt(sleep_variance_);
+    sleep_estimate_ = sleep_mean_ + deviation;
+  }
+  // the last part is spun, the scheduler would wake up too late for it
+  while (clock_type::now() < deadline) {
+    std::this_thread::yield();
+  }
+}
+
+void frame_pacer::report() {
+  if (errors_.empty()) {
+    return;
+  }
+  std::sort(errors_.begin(), errors_.end());
+  double sum = 0.0;
+  for (double error : errors_) {
+    sum += error;
+  }
+  std::cout << "Frame pacing (target " << params_.target_fps << " fps, last " << errors_.size()
+            << " frames): error mean " << sum / double(errors_.size()) << " p99 " << utils::percentile(errors_, 0.99)
+            << " max " << errors_.back() << " ms, " << missed_ << " missed, sleep estimate " << sleep_estimate_
+            << " ms" << std::endl;
+  errors_.clear();
+  missed_ = 0;
+}
@@ -0,0 +1,247 @@
+#include "frame_stats.hpp"
+
+#include "utils.hpp"
+
+#include <glbinding/gl/functions.h>
+#include <glbinding/gl/enum.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+using clock_type = std::chrono::steady_clock;
+
+// frames whose timestamps may be in flight at once
+static std::size_t const timer_latency = 4;
+
+static frame_stats::percentiles summarize_times(std::vector<double> samples) {
+  frame_stats::percentiles result{};
+  if (samples.empty()) {
+    return result;
+  }
+  std::sort(samples.begin(), samples.end());
+  double sum = 0.0;
+  for (double sample : samples) {
+    sum += sample;
+  }
+  result.frames = samples.size();
+  result.mean = sum / double(samples.size());
+  result.p50 = utils::percentile(samples, 0.5);
+  result.p95 = utils::percentile(samples, 0.95);
+  result.p99 = utils::percentile(samples, 0.99);
+  result.max = samples.back();
+  return result;
+}
+
+static void write_percentiles(std::ofstream& file, char const* name, frame_stats::percentiles const& times) {
+  file << "  \"" << name << "\": {\"frames\": " << times.frames << ", \"mean_ms\": " << times.mean << ", \"p50_ms\": "
+       << times.p50 << ", \"p95_ms\": " << times.p95 << ", \"p99_ms\": " << times.p99 << ", \"max_ms\": " << times.max
+       << "},\n";
+}
+
+frame_stats::parameters frame_stats::read_options(int& argc, char* argv[]) {
+  parameters params{};
+  int kept = 1;
+  for (int i = 1; i < argc; ++i) {
+    std::string argument{argv[i]};
+    if (argument == "--frame-stats") {
+      if (i + 1 >= argc) {
+        throw std::logic_error("frame_stats: --frame-stats needs the file to write");
+      }
+      params.export_path = argv[++i];
+    }
+    else {
+      argv[kept++] = argv[i];
+    }
+  }
+  argc = kept;
+  return params;
+}
+
+frame_stats::frame_stats()
+ :frame_stats(parameters{})
+{}
+
+frame_stats::frame_stats(parameters const& params)
+ :params_(params)
+ ,records_(std::max(params.capacity, std::size_t(1)))
+ ,timers_(timer_latency)
+ ,frames_{0}
+ ,checked_{false}
+ ,supported_{false}
+ ,timing_{false}
+ ,frame_start_{}
+ ,last_present_{}
+ ,last_report_{clock_type::now()}
+ ,median_present_{0.0}
+ ,total_hitches_{0}
+{
+  params_.buckets = std::max(params_.buckets, std::size_t(1));
+}
+
+frame_stats::~frame_stats() {
+  for (auto const& frame_timer : timers_) {
+    if (frame_timer.queries[0] != 0) {
+      glDeleteQueries(2, frame_timer.queries);
+    }
+  }
+}
+
+void frame_stats::begin_frame() {
+  // checked on first use, so no context is needed on construction
+  if (!checked_) {
+    supported_ = utils::supports(3, 3, GLextension::GL_ARB_timer_query);
+    checked_ = true;
+  }
+  records_[frames_ % records_.size()] = frame_record{};
+  frame_start_ = clock_type::now();
+
+  timing_ = false;
+  if (supported_) {
+    collect();
+    // the timer of this frame is skipped when its last frame is still in flight, so nothing waits
+    timer& frame_timer = timers_[frames_ % timers_.size()];
+    if (!frame_timer.in_flight) {
+      if (frame_timer.queries[0] == 0) {
+        glGenQueries(2, frame_timer.queries);
+      }
+      glQueryCounter(frame_timer.queries[0], GL_TIMESTAMP);
+      frame_timer.frame = frames_;
+      timing_ = true;
+    }
+  }
+  ++frames_;
+}
+
+void frame_stats::end_frame() {
+  std::size_t frame = frames_ - 1;
+  records_[frame % records_.size()].cpu_ms = utils::milliseconds(clock_type::now() - frame_start_);
+  if (timing_) {
+    timer& frame_timer = timers_[frame % timers_.size()];
+    glQueryCounter(frame_timer.queries[1], GL_TIMESTAMP);
+    frame_timer.in_flight = true;
+  }
+}
+
+bool frame_stats::presented() {
+  clock_type::time_point now = clock_type::now();
+  // the first frame has no interval
+  if (frames_ > 1) {
+    double interval = utils::milliseconds(now - last_present_);
+    records_[(frames_ - 1) % records_.size()].present_ms = interval;
+    if (median_present_ > 0.0 && interval > params_.hitch_factor * median_present_) {
+      ++total_hitches_;
+    }
+  }
+  last_present_ = now;
+
+  if (std::chrono::duration<double>(now - last_report_).count() < params_.report_interval) {
+    return false;
+  }
+  last_report_ = now;
+  summary current = summarize();
+  median_present_ = current.present.p50;
+  report(current);
+  if (!params_.export_path.empty()) {
+    write_json(params_.export_path);
+  }
+  return true;
+}
+
+void frame_stats::collect() {
+  for (auto& frame_timer : timers_) {
+    if (!frame_timer.in_flight) {
+      continue;
+    }
+    GLuint available = 0;
+    glGetQueryObjectuiv(frame_timer.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+      continue;
+    }
+    GLuint64 start_ns = 0, end_ns = 0;
+    glGetQueryObjectui64v(frame_timer.queries[0], GL_QUERY_RESULT, &start_ns);
+    glGetQueryObjectui64v(frame_timer.queries[1], GL_QUERY_RESULT, &end_ns);
+    frame_timer.in_flight = false;
+    // the record of the frame may already be overwritten in a small ring buffer
+    if (frames_ - frame_timer.frame <= records_.size()) {
+      records_[frame_timer.frame % records_.size()].gpu_ms = double(end_ns - start_ns) / 1000000.0;
+    }
+  }
+}
+
+frame_stats::summary frame_stats::summarize() const {
+  std::vector<double> cpu{};
+  std::vector<double> gpu{};
+  std::vector<double> present{};
+  for (auto const& record : records_) {
+    if (record.cpu_ms >= 0.0) {
+      cpu.push_back(record.cpu_ms);
+    }
+    if (record.gpu_ms >= 0.0) {
+      gpu.push_back(record.gpu_ms);
+    }
+    if (record.present_ms >= 0.0) {
+      present.push_back(record.present_ms);
+    }
+  }
+
+  summary result{};
+  result.cpu = summarize_times(cpu);
+  result.gpu = summarize_times(gpu);
+  result.present = summarize_times(present);
+  result.total_hitches = total_hitches_;
+  result.total_frames = frames_;
+  result.histogram.assign(params_.buckets, 0);
+  for (double interval : present) {
+    std::size_t bucket = std::min(std::size_t(interval / params_.bucket_ms), params_.buckets - 1);
+    ++result.histogram[bucket];
+    if (interval > params_.hitch_factor * result.present.p50) {
+      ++result.hitches;
+    }
+  }
+  return result;
+}
+
+void frame_stats::report(summary const& current) const {
+  std::cout << "Frame times (last " << current.present.frames << " frames): present p50 " << current.present.p50
+            << " p95 " << current.present.p95 << " p99 " << current.present.p99 << " max " << current.present.max
+            << " ms, cpu p50 " << current.cpu.p50 << " p99 " << current.cpu.p99 << " ms, gpu ";
+  if (current.gpu.frames > 0) {
+    std::cout << "p50 " << current.gpu.p50 << " p99 " << current.gpu.p99 << " ms";
+  }
+  else {
+    std::cout << "not available";
+  }
+  std::cout << ", " << current.hitches << " hitches, " << current.total_hitches << " since start" << std::endl;
+
+  std::cout << "Present histogram (" << params_.bucket_ms << " ms buckets):";
+  for (std::size_t count : current.histogram) {
+    std::cout << " " << count;
+  }
+  std::cout << std::endl;
+}
+
+void frame_stats::write_json(std::string const& file_path) const {
+  std::ofstream file(file_path);
+  if (!file) {
+    throw std::logic_error("frame_stats: cannot write " + file_path);
+  }
+  summary current = summarize();
+  file << "{\n";
+  file << "  \"frames\": " << current.total_frames << ",\n";
+  write_percentiles(file, "cpu", current.cpu);
+  write_percentiles(file, "gpu", current.gpu);
+  write_percentiles(file, "present", current.present);
+  file << "  \"hitch_factor\": " << params_.hitch_factor << ",\n";
+  file << "  \"hitches\": " << current.hitches << ",\n";
+  file << "  \"total_hitches\": " << current.total_hitches << ",\n";
+  file << "  \"bucket_ms\": " << params_.bucket_ms << ",\n";
+  file << "  \"histogram\": [";
+  for (std::size_t i = 0; i < current.histogram.size(); ++i) {
+    file << (i > 0 ? ", " : "") << current.histogram[i];
+  }
+  file << "]\n}\n";
+}
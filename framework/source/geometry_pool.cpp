@@ -0,0 +1,137 @@
+#include "geometry_pool.hpp"
+
+#include <glbinding/gl/functions.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <cstdint>
+#include <stdexcept>
+
+// position, normal, texcoord, tangent and bitangent
+GLsizei const geometry_pool::vertex_components = 3 + 3 + 2 + 3 + 3;
+
+// point the attributes of the bound vertex array into the shared vertex buffer
+static void attach_vertex_buffer(GLuint vertex_buffer) {
+  glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+  GLsizei stride = GLsizei(sizeof(GLfloat)) * geometry_pool::vertex_components;
+  std::size_t offset = 0;
+  for (GLuint location = 0; location < model::VERTEX_ATTRIBS.size(); ++location) {
+    model::attribute const& attribute = model::VERTEX_ATTRIBS[location];
+    // activate attribute on gpu
+    glEnableVertexAttribArray(location);
+    glVertexAttribPointer(location, attribute.components, attribute.type, false, stride, (GLvoid*)offset);
+    offset += std::size_t(attribute.size * attribute.components);
+  }
+}
+
+geometry_pool::geometry_pool()
+ :vertex_data_{}
+ ,index_data_{}
+ ,vertex_AO_{0}
+ ,vertex_BO_{0}
+ ,element_BO_{0}
+ ,pass_AOs_{}
+{}
+
+geometry_pool::~geometry_pool() {
+  glDeleteBuffers(1, &vertex_BO_);
+  glDeleteBuffers(1, &element_BO_);
+  glDeleteVertexArrays(1, &vertex_AO_);
+  glDeleteVertexArrays(GLsizei(pass_AOs_.size()), pass_AOs_.data());
+}
+
+mesh_range geometry_pool::add(model const& mesh, GLenum draw_mode) {
+  if (vertex_AO_ != 0) {
+    throw std::logic_error("geometry_pool: meshes must be added before upload");
+  }
+
+  mesh_range range{};
+  range.draw_mode = draw_mode;
+  range.base_vertex = GLint(vertex_data_.size() / std::size_t(vertex_components));
+  range.num_vertices = GLsizei(mesh.vertex_num);
+  range.first_index = GLuint(index_data_.size());
+  range.num_elements = GLsizei(mesh.indices.size());
+
+  std::size_t mesh_components = std::size_t(mesh.vertex_bytes) / sizeof(GLfloat);
+  std::vector<GLfloat> vertex(vertex_components, 0.0f);
+  for (std::size_t i = 0; i < mesh.vertex_num; ++i) {
+    GLfloat const* source = mesh.data.data() + i * mesh_components;
+    GLsizei offset = 0;
+    // copy the attributes the model contains into their slot of the shared layout
+    for (auto const& attribute : model::VERTEX_ATTRIBS) {
+      auto mesh_offset = mesh.offsets.find(attribute);
+      for (GLint c = 0; c < attribute.components; ++c) {
+        vertex[offset + c] = mesh_offset == mesh.offsets.end() ? 0.0f
+          : source[uintptr_t(mesh_offset->second) / sizeof(GLfloat) + std::size_t(c)];
+      }
+      offset += attribute.components;
+    }
+    vertex_data_.insert(vertex_data_.end(), vertex.begin(), vertex.end());
+  }
+  // indices stay relative to the mesh, they are offset by base_vertex when drawing
+  index_data_.insert(index_data_.end(), mesh.indices.begin(), mesh.indices.end());
+
+  return range;
+}
+
+void geometry_pool::upload() {
+  // generate vertex array object
+  glGenVertexArrays(1, &vertex_AO_);
+  // bind the array for attaching buffers
+  glBindVertexArray(vertex_AO_);
+
+  // generate generic buffer
+  glGenBuffers(1, &vertex_BO_);
+  // bind this as an vertex array buffer containing all attributes
+  glBindBuffer(GL_ARRAY_BUFFER, vertex_BO_);
+  // configure currently bound array buffer
+  glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(sizeof(GLfloat) * vertex_data_.size()), vertex_data_.data(), GL_STATIC_DRAW);
+
+  attach_vertex_buffer(vertex_BO_);
+
+  // generate generic buffer
+  glGenBuffers(1, &element_BO_);
+  // bind this as an element buffer, stays attached to the vertex array
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_BO_);
+  // configure currently bound array buffer
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, GLsizeiptr(model::INDEX.size * index_data_.size()), index_data_.data(), GL_STATIC_DRAW);
+
+  // data lives on the gpu now
+  vertex_data_ = std::vector<GLfloat>{};
+  index_data_ = std::vector<GLuint>{};
+}
+
+GLuint geometry_pool::add_vertex_array() {
+  if (vertex_AO_ == 0) {
+    throw std::logic_error("geometry_pool: vertex arrays can only be added after upload");
+  }
+  GLuint vertex_array = 0;
+  glGenVertexArrays(1, &vertex_array);
+  glBindVertexArray(vertex_array);
+  attach_vertex_buffer(vertex_BO_);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_BO_);
+  pass_AOs_.push_back(vertex_array);
+  return vertex_array;
+}
+
+void geometry_pool::bind() const {
+  glBindVertexArray(vertex_AO_);
+}
+
+void geometry_pool::draw(mesh_range const& mesh) const {
+  if (mesh.num_elements > 0) {
+    glDrawElementsBaseVertex(mesh.draw_mode, mesh.num_elements, model::INDEX.type,
+                             (GLvoid*)(uintptr_t(mesh.first_index) * model::INDEX.size), mesh.base_vertex);
+  }
+  else {
+    glDrawArrays(mesh.draw_mode, mesh.base_vertex, mesh.num_vertices);
+  }
+}
+
+draw_elements_command geometry_pool::command(mesh_range const& mesh, GLuint base_instance) {
+  return draw_elements_command{GLuint(mesh.num_elements), 1, mesh.first_index, mesh.base_vertex, base_instance};
+}
+
+GLuint geometry_pool::vertex_array() const {
+  return vertex_AO_;
+}
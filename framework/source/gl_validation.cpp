@@ -0,0 +1,187 @@
+#include "gl_validation.hpp"
+
+#include "utils.hpp"
+
+#include <glbinding/gl/gl.h>
+// load glbinding callbacks
+#include <glbinding/Binding.h>
+// load meta info extension
+#include <glbinding/Meta.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <cctype>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace gl_validation {
+
+static options current{};
+static unsigned frame_count = 0;
+// whether the calls are followed by glGetError right now
+static bool checking = false;
+
+static void GL_APIENTRY debug_message(
+  GLenum source,
+  GLenum type,
+  GLuint id,
+  GLenum severity,
+  GLsizei length,
+  const GLchar* message,
+  const void* userParam
+){
+  (void)source; (void)id; (void)length; (void)userParam;
+  if (severity == GL_DEBUG_SEVERITY_NOTIFICATION || type == GL_DEBUG_TYPE_PERFORMANCE) {
+    return;
+  }
+  std::cerr << glbinding::Meta::getString(severity) << " - " << glbinding::Meta::getString(type) << ": ";
+  std::cerr << message << std::endl;
+}
+
+static void check_error(glbinding::FunctionCall const& call) {
+  GLenum error = glGetError();
+  if (error != GL_NO_ERROR) {
+    // print name
+    std::cerr << "OpenGL Error: " << call.function->name() << "(";
+    // parameters
+    for (unsigned i = 0; i < call.parameters.size(); ++i) {
+      std::cerr << call.parameters[i]->asString();
+      if (i < call.parameters.size() - 1) {
+        std::cerr << ", ";
+      }
+    }
+    std::cerr << ")";
+    // return value
+    if (call.returnValue) {
+      std::cerr << " -> " << call.returnValue->asString();
+    }
+    // error
+    std::cerr << " - " << glbinding::Meta::getString(error) << std::endl;
+    // throw exception to allow for backtrace
+    throw std::runtime_error("OpenGl error: " + std::string(call.function->name()));
+  }
+}
+
+static void watch_gl_errors(bool activate) {
+  if (activate) {
+    // add callback after each function call
+    glbinding::setCallbackMaskExcept(glbinding::CallbackMask::After | glbinding::CallbackMask::ParametersAndReturnValue, {"glGetError", "glBegin", "glVertex3f", "glColor3f"});
+  }
+  else {
+    glbinding::setCallbackMask(glbinding::CallbackMask::None);
+  }
+  checking = activate;
+}
+
+// errors of calls that were not followed by glGetError, only the error itself is known
+static void report_unchecked_errors() {
+  for (GLenum error = glGetError(); error != GL_NO_ERROR; error = glGetError()) {
+    std::cerr << "OpenGL Error in the frames before frame " << frame_count << ": "
+              << glbinding::Meta::getString(error) << std::endl;
+  }
+}
+
+options read_options(int& argc, char* argv[]) {
+  options settings{};
+  int kept = 1;
+  for (int i = 1; i < argc; ++i) {
+    std::string argument{argv[i]};
+    if (argument == "--gl-validation") {
+      std::string mode = i + 1 < argc ? argv[++i] : "";
+      if (mode == "off") {
+        settings.mode = level::off;
+      }
+      else if (mode == "sampled") {
+        settings.mode = level::sampled;
+        // interval is optional, a resource path never starts with a digit here
+        if (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+          settings.interval = unsigned(std::strtoul(argv[++i], nullptr, 10));
+        }
+      }
+      else if (mode == "callback") {
+        settings.mode = level::callback;
+      }
+      else if (mode == "full") {
+        settings.mode = level::full;
+      }
+      else {
+        throw std::logic_error("gl_validation: --gl-validation needs one of off, sampled, callback or full");
+      }
+    }
+    else {
+      argv[kept++] = argv[i];
+    }
+  }
+  argc = kept;
+  if (settings.interval == 0) {
+    throw std::logic_error("gl_validation: the sampling interval must be at least one frame");
+  }
+  return settings;
+}
+
+char const* name(level mode) {
+  switch (mode) {
+    case level::off: return "off";
+    case level::sampled: return "sampled";
+    case level::callback: return "callback";
+    case level::full: return "full";
+  }
+  return "unknown";
+}
+
+bool needs_debug_context(level mode) {
+  return mode == level::callback || mode == level::full;
+}
+
+void enable(options const& settings) {
+  current = settings;
+  frame_count = 0;
+
+  glbinding::setAfterCallback(check_error);
+  watch_gl_errors(settings.mode == level::full);
+
+  // debug output is core from 4.3 on, without it the driver messages of the debug levels are missing
+  bool debug_output = utils::supports(4, 3, GLextension::GL_KHR_debug);
+  if (!debug_output) {
+    if (needs_debug_context(settings.mode)) {
+      std::cerr << "gl_validation: context has no debug output, driver messages are not shown" << std::endl;
+    }
+    return;
+  }
+  if (needs_debug_context(settings.mode)) {
+    glEnable(GL_DEBUG_OUTPUT);
+    // the full level reports messages inside the failing call, the callback level lets the driver defer them
+    if (settings.mode == level::full) {
+      glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    }
+    else {
+      glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    }
+    glDebugMessageCallback(debug_message, nullptr);
+    glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, true);
+  }
+  else {
+    glDisable(GL_DEBUG_OUTPUT);
+    glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+  }
+}
+
+void frame() {
+  if (current.mode != level::sampled) {
+    return;
+  }
+  // switching the callbacks touches every function of the binding, so only at the ends of a sampled frame
+  bool sample = frame_count % current.interval == 0;
+  if (sample && !checking) {
+    report_unchecked_errors();
+    watch_gl_errors(true);
+  }
+  else if (!sample && checking) {
+    watch_gl_errors(false);
+  }
+  ++frame_count;
+}
+
+}
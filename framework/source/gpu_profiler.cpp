@@ -0,0 +1,286 @@
+#include "gpu_profiler.hpp"
+
+#include "utils.hpp"
+
+#include <glbinding/gl/functions.h>
+#include <glbinding/gl/enum.h>
+#include <glbinding/gl/bitfield.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+// the whole frame is timed like a pass and listed first
+static std::string const frame_pass{"frame"};
+// a span whose end timestamp was not written yet
+static std::size_t const open_span = std::size_t(-1);
+
+// overlay bars in pixels
+static unsigned const bar_height = 8;
+static unsigned const bar_spacing = 3;
+static unsigned const bar_width = 240;
+static unsigned const overlay_margin = 8;
+// rgb of the bars, the frame first and then one color per pass in order
+static float const bar_colors[][3] = {
+  {0.9f, 0.9f, 0.9f}, {0.3f, 0.6f, 1.0f}, {1.0f, 0.6f, 0.2f}, {0.4f, 0.9f, 0.4f},
+  {1.0f, 0.3f, 0.3f}, {0.8f, 0.4f, 1.0f}, {1.0f, 0.9f, 0.3f}, {0.3f, 0.9f, 0.9f}
+};
+
+// clear a rectangle to the color, with the scissor test enabled
+static void fill(glm::uvec2 const& position, glm::uvec2 const& size, float r, float g, float b) {
+  glScissor(GLint(position.x), GLint(position.y), GLsizei(size.x), GLsizei(size.y));
+  glClearColor(r, g, b, 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT);
+}
+
+gpu_profiler::gpu_profiler(std::size_t latency, std::size_t history)
+ :frames_(std::max(latency, std::size_t(1)))
+ ,passes_{}
+ ,history_{std::max(history, std::size_t(1))}
+ ,current_{0}
+ ,oldest_{0}
+ ,recording_{false}
+ ,checked_{false}
+ ,supported_{false}
+ ,skipped_{0}
+{}
+
+gpu_profiler::~gpu_profiler() {
+  for (auto const& timed : frames_) {
+    if (!timed.queries.empty()) {
+      glDeleteQueries(GLsizei(timed.queries.size()), timed.queries.data());
+    }
+  }
+}
+
+void gpu_profiler::begin_frame() {
+  // checked on first use, so no context is needed on construction
+  if (!checked_) {
+    supported_ = utils::supports(3, 3, GLextension::GL_ARB_timer_query);
+    checked_ = true;
+  }
+  if (!supported_) {
+    return;
+  }
+  collect();
+  if (frames_[current_].in_flight) {
+    ++skipped_;
+    recording_ = false;
+    return;
+  }
+  frames_[current_].used = 0;
+  frames_[current_].spans.clear();
+  recording_ = true;
+  begin(frame_pass);
+}
+
+void gpu_profiler::end_frame() {
+  if (!recording_) {
+    return;
+  }
+  end(frame_pass);
+  frames_[current_].in_flight = true;
+  current_ = (current_ + 1) % frames_.size();
+  recording_ = false;
+}
+
+void gpu_profiler::begin(std::string const& pass) {
+  if (!recording_) {
+    return;
+  }
+  frame& current = frames_[current_];
+  std::size_t index = pass_index(pass);
+  current.spans.push_back(span{index, write_timestamp(current), open_span});
+}
+
+void gpu_profiler::end(std::string const& pass) {
+  if (!recording_) {
+    return;
+  }
+  frame& current = frames_[current_];
+  std::size_t index = pass_index(pass);
+  // the innermost open run of the pass
+  for (auto run = current.spans.rbegin(); run != current.spans.rend(); ++run) {
+    if (run->pass == index && run->end == open_span) {
+      run->end = write_timestamp(current);
+      return;
+    }
+  }
+}
+
+bool gpu_profiler::supported() const {
+  return supported_;
+}
+
+std::size_t gpu_profiler::skipped_frames() const {
+  return skipped_;
+}
+
+std::size_t gpu_profiler::pass_index(std::string const& name) {
+  for (std::size_t i = 0; i < passes_.size(); ++i) {
+    if (passes_[i].name == name) {
+      return i;
+    }
+  }
+  passes_.push_back(pass{});
+  passes_.back().name = name;
+  return passes_.size() - 1;
+}
+
+std::size_t gpu_profiler::write_timestamp(frame& current) {
+  // a frame gets more queries when it times more passes than before
+  if (current.used == current.queries.size()) {
+    GLuint query = 0;
+    glGenQueries(1, &query);
+    current.queries.push_back(query);
+  }
+  glQueryCounter(current.queries[current.used], GL_TIMESTAMP);
+  return current.used++;
+}
+
+void gpu_profiler::collect() {
+  while (frames_[oldest_].in_flight) {
+    frame& timed = frames_[oldest_];
+    // timestamps arrive in the order they were written, so the last one finishes the frame
+    GLuint available = 0;
+    glGetQueryObjectuiv(timed.queries[timed.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+      return;
+    }
+    std::vector<GLuint64> timestamps(timed.used, 0);
+    for (std::size_t i = 0; i < timed.used; ++i) {
+      glGetQueryObjectui64v(timed.queries[i], GL_QUERY_RESULT, &timestamps[i]);
+    }
+
+    // runs of the same pass add up
+    std::vector<double> durations(passes_.size(), -1.0);
+    for (auto const& run : timed.spans) {
+      if (run.end == open_span) {
+        continue;
+      }
+      double run_ms = double(timestamps[run.end] - timestamps[run.begin]) / 1000000.0;
+      durations[run.pass] = std::max(durations[run.pass], 0.0) + run_ms;
+    }
+    for (std::size_t i = 0; i < durations.size(); ++i) {
+      if (durations[i] < 0.0) {
+        continue;
+      }
+      pass& timed_pass = passes_[i];
+      if (timed_pass.samples.size() < history_) {
+        timed_pass.samples.push_back(durations[i]);
+      } else {
+        timed_pass.samples[timed_pass.next] = durations[i];
+      }
+      timed_pass.next = (timed_pass.next + 1) % history_;
+    }
+
+    timed.in_flight = false;
+    oldest_ = (oldest_ + 1) % frames_.size();
+  }
+}
+
+std::vector<double> gpu_profiler::history(pass const& timed) const {
+  // before the ring is full next is the end of the samples, afterwards their oldest
+  if (timed.samples.size() < history_) {
+    return timed.samples;
+  }
+  std::vector<double> ordered{timed.samples.begin() + std::ptrdiff_t(timed.next), timed.samples.end()};
+  ordered.insert(ordered.end(), timed.samples.begin(), timed.samples.begin() + std::ptrdiff_t(timed.next));
+  return ordered;
+}
+
+std::vector<gpu_profiler::pass_statistics> gpu_profiler::statistics() const {
+  std::vector<pass_statistics> result{};
+  for (auto const& timed : passes_) {
+    pass_statistics stats{};
+    stats.name = timed.name;
+    stats.frames = timed.samples.size();
+    if (!timed.samples.empty()) {
+      std::vector<double> sorted = history(timed);
+      stats.last = sorted.back();
+      std::sort(sorted.begin(), sorted.end());
+      double sum = 0.0;
+      for (double sample : sorted) {
+        sum += sample;
+      }
+      stats.mean = sum / double(sorted.size());
+      stats.median = utils::percentile(sorted, 0.5);
+      stats.p95 = utils::percentile(sorted, 0.95);
+      stats.min = sorted.front();
+      stats.max = sorted.back();
+    }
+    result.push_back(stats);
+  }
+  return result;
+}
+
+void gpu_profiler::draw_overlay(glm::uvec2 const& viewport, double budget_ms) const {
+  std::vector<pass_statistics> passes = statistics();
+  unsigned height = unsigned(passes.size()) * (bar_height + bar_spacing) + bar_spacing;
+  if (passes.empty() || viewport.x < bar_width + 2 * overlay_margin || viewport.y < height + overlay_margin) {
+    return;
+  }
+
+  // bars are scissored clears, no program or vertex array of the application is touched
+  GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+  GLfloat clear_color[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+  glGetFloatv(GL_COLOR_CLEAR_VALUE, clear_color);
+  glEnable(GL_SCISSOR_TEST);
+  // dark panel behind the bars, the scissor origin is the lower left corner
+  glm::uvec2 panel{overlay_margin, viewport.y - overlay_margin - height};
+  fill(panel, glm::uvec2{bar_width + 2 * bar_spacing, height}, 0.05f, 0.05f, 0.05f);
+
+  std::size_t colors = sizeof(bar_colors) / sizeof(bar_colors[0]);
+  for (std::size_t i = 0; i < passes.size(); ++i) {
+    float const* color = bar_colors[i % colors];
+    unsigned y = viewport.y - overlay_margin - unsigned(i + 1) * (bar_height + bar_spacing);
+    unsigned x = overlay_margin + bar_spacing;
+    unsigned mean_width = unsigned(std::min(1.0, passes[i].mean / budget_ms) * bar_width);
+    if (mean_width > 0) {
+      fill(glm::uvec2{x, y}, glm::uvec2{mean_width, bar_height}, color[0], color[1], color[2]);
+    }
+    unsigned p95_x = unsigned(std::min(1.0, passes[i].p95 / budget_ms) * (bar_width - 2));
+    fill(glm::uvec2{x + p95_x, y}, glm::uvec2{2, bar_height}, 1.0f, 1.0f, 1.0f);
+  }
+
+  glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
+  if (scissor == GL_FALSE) {
+    glDisable(GL_SCISSOR_TEST);
+  }
+}
+
+void gpu_profiler::write_csv(std::string const& file_path) const {
+  std::ofstream file(file_path);
+  if (!file) {
+    throw std::logic_error("gpu_profiler: cannot write " + file_path);
+  }
+  file << "pass,frames,last_ms,mean_ms,median_ms,p95_ms,min_ms,max_ms\n";
+  for (auto const& stats : statistics()) {
+    file << stats.name << "," << stats.frames << "," << stats.last << "," << stats.mean << "," << stats.median << ","
+         << stats.p95 << "," << stats.min << "," << stats.max << "\n";
+  }
+}
+
+void gpu_profiler::write_json(std::string const& file_path) const {
+  std::ofstream file(file_path);
+  if (!file) {
+    throw std::logic_error("gpu_profiler: cannot write " + file_path);
+  }
+  std::vector<pass_statistics> passes = statistics();
+  file << "{\n  \"skipped_frames\": " << skipped_ << ",\n  \"passes\": [\n";
+  for (std::size_t i = 0; i < passes.size(); ++i) {
+    pass_statistics const& stats = passes[i];
+    // pass names are identifiers given by the application, they need no escaping
+    file << "    {\"name\": \"" << stats.name << "\", \"frames\": " << stats.frames << ", \"last_ms\": " << stats.last
+         << ", \"mean_ms\": " << stats.mean << ", \"median_ms\": " << stats.median << ", \"p95_ms\": " << stats.p95
+         << ", \"min_ms\": " << stats.min << ", \"max_ms\": " << stats.max << ",\n     \"samples_ms\": [";
+    std::vector<double> samples = history(passes_[i]);
+    for (std::size_t s = 0; s < samples.size(); ++s) {
+      file << (s > 0 ? ", " : "") << samples[s];
+    }
+    file << "]}" << (i + 1 < passes.size() ? "," : "") << "\n";
+  }
+  file << "  ]\n}\n";
+}
@@ -0,0 +1,108 @@
+#include "gravity_compute.hpp"
+
+#include <glbinding/gl/functions.h>
+#include <glbinding/gl/enum.h>
+#include <glbinding/gl/bitfield.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <algorithm>
+
+gravity_compute::gravity_compute(float gravity, float softening)
+ :gravity_{gravity}
+ ,softening_{std::max(softening, 1e-6f)}
+ ,count_{0}
+ ,buffers_{{0, 0, 0, 0}}
+{}
+
+gravity_compute::~gravity_compute() {
+  if (buffers_.front() != 0) {
+    glDeleteBuffers(GLsizei(buffers_.size()), buffers_.data());
+  }
+}
+
+void gravity_compute::upload(shader_program const& program, std::vector<particle> const& particles,
+                             glm::fvec4 const& draw_info) {
+  // buffers are created on first use, so no context is needed on construction
+  if (buffers_.front() == 0) {
+    glGenBuffers(GLsizei(buffers_.size()), buffers_.data());
+  }
+  count_ = particles.size();
+
+  std::vector<glm::fvec4> positions(count_);
+  std::vector<glm::fvec4> velocities(count_);
+  for (std::size_t i = 0; i < count_; ++i) {
+    positions[i] = particles[i].position_mass;
+    velocities[i] = particles[i].velocity_radius;
+  }
+  // the shader writes only the matrices, the draw info stays as uploaded
+  std::vector<record> records(count_, record{glm::fmat4{}, draw_info});
+  std::vector<glm::fvec4> accelerations(count_, glm::fvec4{0.0f});
+
+  // at least one element each, so an empty set still binds valid buffers
+  auto fill = [](GLuint buffer, std::size_t bytes, void const* data) {
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, GLsizeiptr(std::max(bytes, sizeof(record))), bytes > 0 ? data : nullptr,
+                 GL_DYNAMIC_DRAW);
+  };
+  fill(buffers_[0], sizeof(glm::fvec4) * count_, positions.data());
+  fill(buffers_[1], sizeof(glm::fvec4) * count_, velocities.data());
+  fill(buffers_[2], sizeof(glm::fvec4) * count_, accelerations.data());
+  fill(buffers_[3], sizeof(record) * count_, records.data());
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+  // a step of length 0 only computes the accelerations and writes the matrices
+  dispatch(program, 0.0f, 1);
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
+void gravity_compute::step(shader_program const& program, float dt) {
+  if (count_ == 0) {
+    return;
+  }
+  dispatch(program, dt, 0);
+  // every position must have drifted before any acceleration is computed
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+  dispatch(program, dt, 1);
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
+std::vector<gravity_compute::particle> gravity_compute::download() const {
+  std::vector<particle> particles(count_);
+  if (count_ == 0) {
+    return particles;
+  }
+  std::vector<glm::fvec4> positions(count_);
+  std::vector<glm::fvec4> velocities(count_);
+  glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers_[0]);
+  glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, GLsizeiptr(sizeof(glm::fvec4) * count_), positions.data());
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers_[1]);
+  glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, GLsizeiptr(sizeof(glm::fvec4) * count_), velocities.data());
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  for (std::size_t i = 0; i < count_; ++i) {
+    particles[i] = particle{positions[i], velocities[i]};
+  }
+  return particles;
+}
+
+std::size_t gravity_compute::size() const {
+  return count_;
+}
+
+GLuint gravity_compute::record_buffer() const {
+  return buffers_[3];
+}
+
+void gravity_compute::dispatch(shader_program const& program, float dt, GLuint stage) const {
+  glUseProgram(program.handle);
+  glUniform1ui(program.u_locs.at("Count"), GLuint(count_));
+  glUniform1f(program.u_locs.at("TimeStep"), dt);
+  glUniform1f(program.u_locs.at("Gravity"), gravity_);
+  glUniform1f(program.u_locs.at("Softening"), softening_);
+  glUniform1ui(program.u_locs.at("Stage"), stage);
+  for (GLuint binding = 0; binding < buffers_.size(); ++binding) {
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffers_[binding]);
+  }
+  glDispatchCompute(GLuint((count_ + group_size - 1) / group_size), 1, 1);
+}
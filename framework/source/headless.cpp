@@ -0,0 +1,261 @@
+#include "headless.hpp"
+
+#include "application.hpp"
+#include "frame_clock.hpp"
+#include "gl_validation.hpp"
+#include "trace.hpp"
+#include "utils.hpp"
+
+#ifdef HEADLESS_EGL
+// only the surfaceless platform is used, keep the x11 types out
+#define EGL_NO_X11
+#define MESA_EGL_NO_X11_HEADERS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include <glbinding/gl/gl.h>
+// load glbinding extensions
+#include <glbinding/Binding.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace headless {
+
+#ifdef HEADLESS_EGL
+static EGLDisplay display = EGL_NO_DISPLAY;
+static EGLSurface surface = EGL_NO_SURFACE;
+static EGLContext context = EGL_NO_CONTEXT;
+
+// the surfaceless platform works without gpu or display server, e.g. with the mesa llvmpipe driver
+static EGLDisplay open_display() {
+  auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+  if (get_platform_display) {
+    EGLDisplay surfaceless = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (surfaceless != EGL_NO_DISPLAY && eglInitialize(surfaceless, nullptr, nullptr)) {
+      return surfaceless;
+    }
+  }
+  EGLDisplay fallback = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  if (fallback == EGL_NO_DISPLAY || !eglInitialize(fallback, nullptr, nullptr)) {
+    throw std::runtime_error("headless: no EGL display");
+  }
+  return fallback;
+}
+#endif
+
+// timestamps at the start and end of each frame, 0 without timer queries,
+// elapsed time queries would collide with the ones the applications nest inside their frames
+static GLuint timer_queries[2] = {0, 0};
+
+static void print_times(std::string const& name, std::vector<double> samples) {
+  std::sort(samples.begin(), samples.end());
+  double sum = 0.0;
+  for (double sample : samples) {
+    sum += sample;
+  }
+  std::cout << name << " ms: mean " << sum / double(samples.size()) << ", median " << utils::percentile(samples, 0.5)
+            << ", p95 " << utils::percentile(samples, 0.95) << ", p99 " << utils::percentile(samples, 0.99)
+            << ", min " << samples.front() << ", max " << samples.back() << std::endl;
+}
+
+options read_options(int& argc, char* argv[]) {
+  options settings{};
+  int kept = 1;
+  for (int i = 1; i < argc; ++i) {
+    std::string argument{argv[i]};
+    if (argument == "--headless") {
+      settings.enabled = true;
+      // frame count is optional, a resource path never starts with a digit here
+      if (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+        settings.frames = unsigned(std::strtoul(argv[++i], nullptr, 10));
+      }
+    }
+    else if (argument == "--resolution") {
+      unsigned width = 0, height = 0;
+      char separator = '\0';
+      if (i + 1 >= argc || std::sscanf(argv[++i], "%u%c%u", &width, &separator, &height) != 3 || separator != 'x'
+          || width == 0 || height == 0) {
+        throw std::logic_error("headless: resolution must be given as WIDTHxHEIGHT");
+      }
+      settings.resolution = glm::uvec2{width, height};
+    }
+    else {
+      argv[kept++] = argv[i];
+    }
+  }
+  argc = kept;
+  if (settings.enabled && settings.frames == 0) {
+    throw std::logic_error("headless: at least one frame must be rendered");
+  }
+  return settings;
+}
+
+bool available() {
+#ifdef HEADLESS_EGL
+  return true;
+#else
+  return false;
+#endif
+}
+
+void initialize(glm::uvec2 const& resolution, unsigned ver_major, unsigned ver_minor) {
+#ifdef HEADLESS_EGL
+  display = open_display();
+  if (!eglBindAPI(EGL_OPENGL_API)) {
+    throw std::runtime_error("headless: EGL does not provide desktop OpenGL");
+  }
+
+  // a pbuffer gives the context a default framebuffer, so the screen passes draw as with a window
+  EGLint const config_attributes[] = {
+    EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+    EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+    EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+    EGL_DEPTH_SIZE, 24,
+    EGL_NONE
+  };
+  EGLConfig config = nullptr;
+  EGLint config_count = 0;
+  if (!eglChooseConfig(display, config_attributes, &config, 1, &config_count) || config_count == 0) {
+    throw std::runtime_error("headless: no EGL config for offscreen OpenGL rendering");
+  }
+  EGLint const surface_attributes[] = {
+    EGL_WIDTH, EGLint(resolution.x),
+    EGL_HEIGHT, EGLint(resolution.y),
+    EGL_NONE
+  };
+  surface = eglCreatePbufferSurface(display, config, surface_attributes);
+  if (surface == EGL_NO_SURFACE) {
+    throw std::runtime_error("headless: cannot create EGL pbuffer");
+  }
+
+  // same version request as the window, core profile from 3.2 on
+  EGLint const context_attributes[] = {
+    EGL_CONTEXT_MAJOR_VERSION, EGLint(ver_major),
+    EGL_CONTEXT_MINOR_VERSION, EGLint(ver_minor),
+    EGL_NONE
+  };
+  context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+  if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, surface, surface, context)) {
+    throw std::runtime_error("headless: cannot create OpenGL " + std::to_string(ver_major) + "." + std::to_string(ver_minor) + " context");
+  }
+
+  // glbinding identifies contexts by their glx handle, use the egl one instead
+  glbinding::Binding::initialize(reinterpret_cast<glbinding::ContextHandle>(context), true, true);
+  // glfw is not initialized, the animations need another time source
+  frame_clock::use_steady_clock();
+
+  std::cout << "Created headless OpenGL profile with version " << glGetString(GL_VERSION) << " on "
+            << glGetString(GL_RENDERER) << std::endl;
+#else
+  (void)resolution; (void)ver_major; (void)ver_minor;
+  throw std::logic_error("headless: built without EGL");
+#endif
+}
+
+void prepare(Application& application, glm::uvec2 const& resolution) {
+  // initial shader load and uniform upload
+  application.reloadShaders(true);
+
+  // enable depth testing
+  glEnable(GL_DEPTH_TEST);
+  glDepthFunc(GL_LESS);
+  application.resize_callback(resolution.x, resolution.y);
+
+  // every frame is waited for, so one pair suffices and its results are ready right after the frame
+  if (timer_queries[0] == 0 && utils::supports(3, 3, GLextension::GL_ARB_timer_query)) {
+    glGenQueries(2, timer_queries);
+  }
+  glFinish();
+}
+
+frame_sample render_frame(Application& application) {
+  using clock = std::chrono::steady_clock;
+
+  TRACE_FRAME();
+  gl_validation::frame();
+  frame_sample sample{};
+  clock::time_point const start = clock::now();
+  if (timer_queries[0] != 0) {
+    glQueryCounter(timer_queries[0], GL_TIMESTAMP);
+  }
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  {
+    TRACE_ZONE("render");
+    application.render();
+  }
+  clock::time_point const submitted = clock::now();
+  if (timer_queries[0] != 0) {
+    glQueryCounter(timer_queries[1], GL_TIMESTAMP);
+  }
+  // nothing is presented, waiting for the gpu makes the frame time contain the rendering
+  {
+    TRACE_ZONE("wait for gpu");
+    glFinish();
+  }
+  clock::time_point const end = clock::now();
+  frame_clock::tick();
+
+  sample.cpu_ms = std::chrono::duration<double, std::milli>(submitted - start).count();
+  sample.frame_ms = std::chrono::duration<double, std::milli>(end - start).count();
+  if (timer_queries[0] != 0) {
+    GLuint64 start_ns = 0, end_ns = 0;
+    glGetQueryObjectui64v(timer_queries[0], GL_QUERY_RESULT, &start_ns);
+    glGetQueryObjectui64v(timer_queries[1], GL_QUERY_RESULT, &end_ns);
+    sample.gpu_ms = double(end_ns - start_ns) / 1000000.0;
+  }
+  return sample;
+}
+
+int render_frames(Application& application, options const& settings) {
+  prepare(application, settings.resolution);
+
+  std::vector<double> frame_ms{};
+  std::vector<double> cpu_ms{};
+  std::vector<double> gpu_ms{};
+  auto const run_start = std::chrono::steady_clock::now();
+  for (unsigned frame = 0; frame < settings.frames; ++frame) {
+    frame_sample sample = render_frame(application);
+    frame_ms.push_back(sample.frame_ms);
+    cpu_ms.push_back(sample.cpu_ms);
+    if (sample.gpu_ms >= 0.0) {
+      gpu_ms.push_back(sample.gpu_ms);
+    }
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - run_start).count();
+
+  std::cout << "\n---- Headless Run: ----\n" << std::endl;
+  std::cout << settings.frames << " frames at " << settings.resolution.x << " x " << settings.resolution.y << " in "
+            << seconds << " s, " << double(settings.frames) / seconds << " fps" << std::endl;
+  print_times("Frame", frame_ms);
+  print_times("CPU", cpu_ms);
+  if (!gpu_ms.empty()) {
+    print_times("GPU", gpu_ms);
+  }
+  return EXIT_SUCCESS;
+}
+
+void close_and_quit(int status) {
+#ifdef HEADLESS_EGL
+  if (display != EGL_NO_DISPLAY) {
+    glDeleteQueries(2, timer_queries);
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(display, context);
+    eglDestroySurface(display, surface);
+    eglTerminate(display);
+  }
+#endif
+  std::exit(status);
+}
+
+}
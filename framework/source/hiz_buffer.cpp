@@ -0,0 +1,115 @@
+#include "hiz_buffer.hpp"
+
+#include <glm/geometric.hpp>
+#include <glm/common.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+hiz_buffer::hiz_buffer()
+ :levels_{}
+ ,sizes_{}
+{}
+
+void hiz_buffer::resize(std::size_t width, std::size_t height) {
+  levels_.clear();
+  sizes_.clear();
+  glm::uvec2 size{std::max(width, std::size_t{1}), std::max(height, std::size_t{1})};
+  while (true) {
+    sizes_.push_back(size);
+    levels_.push_back(std::vector<float>(std::size_t(size.x) * size.y));
+    if (size.x == 1 && size.y == 1) {
+      break;
+    }
+    size = glm::uvec2{std::max((size.x + 1) / 2, 1u), std::max((size.y + 1) / 2, 1u)};
+  }
+  clear();
+}
+
+void hiz_buffer::clear() {
+  for (auto& level : levels_) {
+    std::fill(level.begin(), level.end(), std::numeric_limits<float>::infinity());
+  }
+}
+
+void hiz_buffer::add_disc(glm::fvec2 const& center, float radius, float depth) {
+  if (levels_.empty() || radius <= 0.0f) {
+    return;
+  }
+  glm::uvec2 const& size = sizes_.front();
+  int min_x = std::max(int(std::floor(center.x - radius)), 0);
+  int min_y = std::max(int(std::floor(center.y - radius)), 0);
+  int max_x = std::min(int(std::ceil(center.x + radius)), int(size.x) - 1);
+  int max_y = std::min(int(std::ceil(center.y + radius)), int(size.y) - 1);
+
+  std::vector<float>& base = levels_.front();
+  for (int y = min_y; y <= max_y; ++y) {
+    for (int x = min_x; x <= max_x; ++x) {
+      // texel is covered if its corner farthest from the center lies inside
+      float dx = std::max(std::abs(float(x) - center.x), std::abs(float(x + 1) - center.x));
+      float dy = std::max(std::abs(float(y) - center.y), std::abs(float(y + 1) - center.y));
+      if (dx * dx + dy * dy <= radius * radius) {
+        float& texel = base[std::size_t(y) * size.x + std::size_t(x)];
+        texel = std::min(texel, depth);
+      }
+    }
+  }
+}
+
+void hiz_buffer::build() {
+  for (std::size_t level = 1; level < levels_.size(); ++level) {
+    glm::uvec2 const& size = sizes_[level];
+    glm::uvec2 const& finer = sizes_[level - 1];
+    for (std::size_t y = 0; y < size.y; ++y) {
+      for (std::size_t x = 0; x < size.x; ++x) {
+        // odd sizes leave a single texel at the border
+        std::size_t x1 = std::min(2 * x + 1, std::size_t(finer.x) - 1);
+        std::size_t y1 = std::min(2 * y + 1, std::size_t(finer.y) - 1);
+        float farthest = std::max(std::max(texel(level - 1, 2 * x, 2 * y), texel(level - 1, x1, 2 * y)),
+                                  std::max(texel(level - 1, 2 * x, y1), texel(level - 1, x1, y1)));
+        levels_[level][y * size.x + x] = farthest;
+      }
+    }
+  }
+}
+
+bool hiz_buffer::occluded(glm::fvec2 const& min, glm::fvec2 const& max, float depth) const {
+  if (levels_.empty()) {
+    return false;
+  }
+  glm::uvec2 const& size = sizes_.front();
+  glm::fvec2 clamped_min = glm::clamp(min, glm::fvec2{0.0f}, glm::fvec2{size} - 1.0f);
+  glm::fvec2 clamped_max = glm::clamp(max, glm::fvec2{0.0f}, glm::fvec2{size} - 1.0f);
+
+  // level where the rectangle spans at most five texels in each direction,
+  // coarser levels would hardly find occlusion since their texels reach far beyond the rectangle
+  float extent = std::max(clamped_max.x - clamped_min.x, clamped_max.y - clamped_min.y) / 4.0f;
+  std::size_t level = extent > 1.0f ? std::size_t(std::ceil(std::log2(extent))) : 0;
+  level = std::min(level, levels_.size() - 1);
+
+  std::size_t min_x = std::size_t(clamped_min.x) >> level;
+  std::size_t min_y = std::size_t(clamped_min.y) >> level;
+  std::size_t max_x = std::min(std::size_t(clamped_max.x) >> level, std::size_t(sizes_[level].x) - 1);
+  std::size_t max_y = std::min(std::size_t(clamped_max.y) >> level, std::size_t(sizes_[level].y) - 1);
+  for (std::size_t y = min_y; y <= max_y; ++y) {
+    for (std::size_t x = min_x; x <= max_x; ++x) {
+      if (texel(level, x, y) >= depth) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+std::size_t hiz_buffer::width() const {
+  return sizes_.empty() ? 0 : sizes_.front().x;
+}
+
+std::size_t hiz_buffer::height() const {
+  return sizes_.empty() ? 0 : sizes_.front().y;
+}
+
+float hiz_buffer::texel(std::size_t level, std::size_t x, std::size_t y) const {
+  return levels_[level][y * sizes_[level].x + x];
+}
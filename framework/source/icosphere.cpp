@@ -0,0 +1,194 @@
+#include "icosphere.hpp"
+
+#include <glm/gtc/type_precision.hpp>
+#include <glm/geometric.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/common.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+
+namespace icosphere {
+
+// icosahedron with one vertex at each pole, so the texture poles fall onto vertices
+static void base_icosahedron(std::vector<glm::fvec3>& positions, std::vector<GLuint>& triangles) {
+  float const ring_latitude = std::atan(0.5f);
+  float const step = glm::two_pi<float>() / 5.0f;
+
+  positions.push_back(glm::fvec3{0.0f, 1.0f, 0.0f});
+  // upper ring
+  for (unsigned i = 0; i < 5; ++i) {
+    float longitude = float(i) * step;
+    positions.push_back(glm::fvec3{std::cos(ring_latitude) * std::cos(longitude), std::sin(ring_latitude),
+                                   std::cos(ring_latitude) * std::sin(longitude)});
+  }
+  // lower ring, rotated by half a step
+  for (unsigned i = 0; i < 5; ++i) {
+    float longitude = (float(i) + 0.5f) * step;
+    positions.push_back(glm::fvec3{std::cos(ring_latitude) * std::cos(longitude), -std::sin(ring_latitude),
+                                   std::cos(ring_latitude) * std::sin(longitude)});
+  }
+  positions.push_back(glm::fvec3{0.0f, -1.0f, 0.0f});
+
+  for (GLuint i = 0; i < 5; ++i) {
+    GLuint upper = 1 + i;
+    GLuint upper_next = 1 + (i + 1) % 5;
+    GLuint lower = 6 + i;
+    GLuint lower_next = 6 + (i + 1) % 5;
+    GLuint faces[4][3] = {{0, upper, upper_next},
+                          {upper, lower, upper_next},
+                          {upper_next, lower, lower_next},
+                          {11, lower_next, lower}};
+    for (auto const& face : faces) {
+      glm::fvec3 const& a = positions[face[0]];
+      glm::fvec3 const& b = positions[face[1]];
+      glm::fvec3 const& c = positions[face[2]];
+      // make all faces counter-clockwise when seen from outside
+      bool outwards = glm::dot(glm::cross(b - a, c - a), a + b + c) > 0.0f;
+      triangles.push_back(face[0]);
+      triangles.push_back(outwards ? face[1] : face[2]);
+      triangles.push_back(outwards ? face[2] : face[1]);
+    }
+  }
+}
+
+// split each triangle into four, new vertices are projected onto the sphere
+static void subdivide(std::vector<glm::fvec3>& positions, std::vector<GLuint>& triangles) {
+  std::unordered_map<std::uint64_t, GLuint> midpoints{};
+  auto midpoint = [&](GLuint a, GLuint b) {
+    // edge key independent of direction
+    std::uint64_t key = (std::uint64_t(std::min(a, b)) << 32) | std::max(a, b);
+    auto found = midpoints.find(key);
+    if (found != midpoints.end()) {
+      return found->second;
+    }
+    GLuint index = GLuint(positions.size());
+    positions.push_back(glm::normalize(positions[a] + positions[b]));
+    midpoints.emplace(key, index);
+    return index;
+  };
+
+  std::vector<GLuint> subdivided{};
+  subdivided.reserve(triangles.size() * 4);
+  for (std::size_t i = 0; i < triangles.size(); i += 3) {
+    GLuint a = triangles[i];
+    GLuint b = triangles[i + 1];
+    GLuint c = triangles[i + 2];
+    GLuint ab = midpoint(a, b);
+    GLuint bc = midpoint(b, c);
+    GLuint ca = midpoint(c, a);
+    GLuint faces[12] = {a, ab, ca,  ab, b, bc,  ca, bc, c,  ab, bc, ca};
+    subdivided.insert(subdivided.end(), faces, faces + 12);
+  }
+  triangles.swap(subdivided);
+}
+
+model generate(unsigned subdivisions) {
+  std::vector<glm::fvec3> positions{};
+  std::vector<GLuint> triangles{};
+  base_icosahedron(positions, triangles);
+  for (unsigned i = 0; i < subdivisions; ++i) {
+    subdivide(positions, triangles);
+  }
+
+  // equirectangular mapping, u grows eastwards and v towards the north pole
+  std::vector<glm::fvec2> texcoords(positions.size());
+  for (std::size_t i = 0; i < positions.size(); ++i) {
+    glm::fvec3 const& p = positions[i];
+    texcoords[i] = glm::fvec2{0.5f - std::atan2(p.z, p.x) / glm::two_pi<float>(),
+                              0.5f + std::asin(glm::clamp(p.y, -1.0f, 1.0f)) / glm::pi<float>()};
+  }
+
+  // duplicate vertices where triangles cross the texture seam or touch a pole
+  std::unordered_map<GLuint, GLuint> seam_copies{};
+  for (std::size_t i = 0; i < triangles.size(); i += 3) {
+    GLuint* face = &triangles[i];
+    float u_min = std::min(texcoords[face[0]].x, std::min(texcoords[face[1]].x, texcoords[face[2]].x));
+    float u_max = std::max(texcoords[face[0]].x, std::max(texcoords[face[1]].x, texcoords[face[2]].x));
+    if (u_max - u_min > 0.5f) {
+      // shift the vertices on the left side of the seam by one texture width
+      for (unsigned v = 0; v < 3; ++v) {
+        if (texcoords[face[v]].x < 0.5f) {
+          auto copy = seam_copies.find(face[v]);
+          if (copy == seam_copies.end()) {
+            GLuint index = GLuint(positions.size());
+            positions.push_back(positions[face[v]]);
+            texcoords.push_back(texcoords[face[v]] + glm::fvec2{1.0f, 0.0f});
+            copy = seam_copies.emplace(face[v], index).first;
+          }
+          face[v] = copy->second;
+        }
+      }
+    }
+  }
+  for (std::size_t i = 0; i < triangles.size(); i += 3) {
+    GLuint* face = &triangles[i];
+    for (unsigned v = 0; v < 3; ++v) {
+      if (std::abs(positions[face[v]].y) > 0.9999f) {
+        // pole gets the average u of the opposite edge, so each pole triangle is not sheared
+        float u = 0.5f * (texcoords[face[(v + 1) % 3]].x + texcoords[face[(v + 2) % 3]].x);
+        GLuint index = GLuint(positions.size());
+        positions.push_back(positions[face[v]]);
+        texcoords.push_back(glm::fvec2{u, texcoords[face[v]].y});
+        face[v] = index;
+      }
+    }
+  }
+
+  std::vector<GLfloat> data{};
+  data.reserve(positions.size() * 14);
+  for (std::size_t i = 0; i < positions.size(); ++i) {
+    glm::fvec3 const& normal = positions[i];
+    // tangent follows u, derived from the longitude of the texture coordinate to stay valid at the poles
+    float longitude = (0.5f - texcoords[i].x) * glm::two_pi<float>();
+    glm::fvec3 tangent{std::sin(longitude), 0.0f, -std::cos(longitude)};
+    glm::fvec3 bitangent = glm::cross(normal, tangent);
+
+    GLfloat vertex[14] = {normal.x, normal.y, normal.z,
+                          normal.x, normal.y, normal.z,
+                          texcoords[i].x, texcoords[i].y,
+                          tangent.x, tangent.y, tangent.z,
+                          bitangent.x, bitangent.y, bitangent.z};
+    data.insert(data.end(), vertex, vertex + 14);
+  }
+
+  return model{data, model::POSITION | model::NORMAL | model::TEXCOORD | model::TANGENT | model::BITANGENT, triangles};
+}
+
+model generate_levels(unsigned min_subdivisions, unsigned max_subdivisions, std::vector<level>& levels) {
+  std::vector<GLfloat> data{};
+  std::vector<GLuint> indices{};
+  levels.clear();
+
+  for (unsigned subdivisions = min_subdivisions; subdivisions <= max_subdivisions; ++subdivisions) {
+    model sphere = generate(subdivisions);
+
+    level lod{};
+    lod.subdivisions = subdivisions;
+    lod.first_index = GLuint(indices.size());
+    lod.num_indices = GLsizei(sphere.indices.size());
+    lod.base_vertex = GLint(data.size() * sizeof(GLfloat) / std::size_t(sphere.vertex_bytes));
+    levels.push_back(lod);
+
+    data.insert(data.end(), sphere.data.begin(), sphere.data.end());
+    indices.insert(indices.end(), sphere.indices.begin(), sphere.indices.end());
+  }
+
+  return model{data, model::POSITION | model::NORMAL | model::TEXCOORD | model::TANGENT | model::BITANGENT, indices};
+}
+
+std::size_t select_level(std::vector<level> const& levels, float pixel_radius, float pixels_per_triangle) {
+  // roughly half of the triangles face the camera
+  float covered_pixels = glm::pi<float>() * pixel_radius * pixel_radius;
+  for (std::size_t i = 0; i < levels.size(); ++i) {
+    float visible_triangles = float(levels[i].num_indices) / 6.0f;
+    if (visible_triangles * pixels_per_triangle >= covered_pixels) {
+      return i;
+    }
+  }
+  return levels.empty() ? 0 : levels.size() - 1;
+}
+
+}
@@ -0,0 +1,204 @@
+#include "kepler.hpp"
+
+#include "parallel.hpp"
+#include "sse_math.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace kepler {
+
+// newton steps stop once the eccentric anomaly changes less than this, or after the maximum
+static float const tolerance = 1e-6f;
+static unsigned const max_iterations = 12;
+
+// unit directions to the periapsis and of the motion there, in scene coordinates
+static void orbit_frame(elements const& orbit, glm::dvec3& periapsis, glm::dvec3& motion) {
+  double cos_node = std::cos(double(orbit.ascending_node));
+  double sin_node = std::sin(double(orbit.ascending_node));
+  double cos_periapsis = std::cos(double(orbit.periapsis));
+  double sin_periapsis = std::sin(double(orbit.periapsis));
+  double cos_inclination = std::cos(double(orbit.inclination));
+  double sin_inclination = std::sin(double(orbit.inclination));
+
+  // perifocal frame in the usual z up convention
+  glm::dvec3 p{cos_node * cos_periapsis - sin_node * sin_periapsis * cos_inclination,
+               sin_node * cos_periapsis + cos_node * sin_periapsis * cos_inclination,
+               sin_periapsis * sin_inclination};
+  glm::dvec3 q{-cos_node * sin_periapsis - sin_node * cos_periapsis * cos_inclination,
+               -sin_node * sin_periapsis + cos_node * cos_periapsis * cos_inclination,
+               cos_periapsis * sin_inclination};
+  // z up becomes y up, orbits run clockwise seen from above like the planets
+  periapsis = glm::dvec3{p.x, p.z, -p.y};
+  motion = glm::dvec3{q.x, q.z, -q.y};
+}
+
+double eccentric_anomaly(double mean_anomaly, double eccentricity) {
+  double m = std::remainder(mean_anomaly, glm::two_pi<double>());
+  // starting value of danby, newton converges from it for every eccentricity below 1
+  double e = m + std::copysign(0.85 * eccentricity, m);
+  for (unsigned i = 0; i < 50; ++i) {
+    double step = (e - eccentricity * std::sin(e) - m) / (1.0 - eccentricity * std::cos(e));
+    e -= step;
+    if (std::abs(step) < 1e-15) {
+      break;
+    }
+  }
+  return e;
+}
+
+void state(elements const& orbit, double time, glm::dvec3& position, glm::dvec3& velocity) {
+  glm::dvec3 periapsis{};
+  glm::dvec3 motion{};
+  orbit_frame(orbit, periapsis, motion);
+
+  double eccentricity = double(orbit.eccentricity);
+  double a = double(orbit.semi_major_axis);
+  double b = a * std::sqrt(1.0 - eccentricity * eccentricity);
+  double anomaly = eccentric_anomaly(double(orbit.mean_anomaly) + double(orbit.mean_motion) * time, eccentricity);
+  double cos_anomaly = std::cos(anomaly);
+  double sin_anomaly = std::sin(anomaly);
+
+  position = a * (cos_anomaly - eccentricity) * periapsis + b * sin_anomaly * motion;
+  // derivative of the eccentric anomaly from differentiating kepler's equation
+  double anomaly_rate = double(orbit.mean_motion) / (1.0 - eccentricity * cos_anomaly);
+  velocity = anomaly_rate * (-a * sin_anomaly * periapsis + b * cos_anomaly * motion);
+}
+
+orbit_set::orbit_set()
+ :periapsis_x_{}
+ ,periapsis_y_{}
+ ,periapsis_z_{}
+ ,motion_x_{}
+ ,motion_y_{}
+ ,motion_z_{}
+ ,eccentricity_{}
+ ,mean_anomaly_{}
+ ,mean_motion_{}
+{}
+
+void orbit_set::clear() {
+  for (auto* values : {&periapsis_x_, &periapsis_y_, &periapsis_z_, &motion_x_, &motion_y_, &motion_z_,
+                       &eccentricity_, &mean_anomaly_, &mean_motion_}) {
+    values->clear();
+  }
+}
+
+void orbit_set::reserve(std::size_t count) {
+  for (auto* values : {&periapsis_x_, &periapsis_y_, &periapsis_z_, &motion_x_, &motion_y_, &motion_z_,
+                       &eccentricity_, &mean_anomaly_, &mean_motion_}) {
+    values->reserve(count);
+  }
+}
+
+void orbit_set::push_back(elements const& orbit) {
+  glm::dvec3 periapsis{};
+  glm::dvec3 motion{};
+  orbit_frame(orbit, periapsis, motion);
+  // axes are folded into the directions, so a position is (cos E - e) * periapsis + sin E * motion
+  double a = double(orbit.semi_major_axis);
+  double b = a * std::sqrt(1.0 - double(orbit.eccentricity) * double(orbit.eccentricity));
+  periapsis *= a;
+  motion *= b;
+
+  periapsis_x_.push_back(float(periapsis.x));
+  periapsis_y_.push_back(float(periapsis.y));
+  periapsis_z_.push_back(float(periapsis.z));
+  motion_x_.push_back(float(motion.x));
+  motion_y_.push_back(float(motion.y));
+  motion_z_.push_back(float(motion.z));
+  eccentricity_.push_back(orbit.eccentricity);
+  // kept reduced, the time term is reduced again in double precision when propagating
+  mean_anomaly_.push_back(float(std::remainder(double(orbit.mean_anomaly), glm::two_pi<double>())));
+  mean_motion_.push_back(orbit.mean_motion);
+}
+
+std::size_t orbit_set::size() const {
+  return eccentricity_.size();
+}
+
+void orbit_set::propagate(double time, std::size_t begin, std::size_t end, float* out, std::size_t stride) const {
+  std::size_t i = begin;
+#ifdef SSE_MATH
+  __m128d const time2 = _mm_set1_pd(time);
+  __m128 const one = _mm_set1_ps(1.0f);
+  __m128 const abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+  __m128 const sign_mask = _mm_castsi128_ps(_mm_set1_epi32(int(0x80000000u)));
+  for (; i + 4 <= end; i += 4) {
+    __m128 anomaly = _mm_loadu_ps(&mean_anomaly_[i]);
+    __m128 motion = _mm_loadu_ps(&mean_motion_[i]);
+    __m128 low = sse_math::reduce2(_mm_cvtps_pd(anomaly), _mm_cvtps_pd(motion), time2);
+    __m128 high = sse_math::reduce2(_mm_cvtps_pd(_mm_movehl_ps(anomaly, anomaly)), _mm_cvtps_pd(_mm_movehl_ps(motion, motion)), time2);
+    __m128 mean = _mm_movelh_ps(low, high);
+    __m128 e = _mm_loadu_ps(&eccentricity_[i]);
+
+    // start of danby, E = M + 0.85 e sign(M), converges for every eccentricity below 1
+    __m128 anomaly_e = _mm_add_ps(mean, _mm_or_ps(_mm_mul_ps(_mm_set1_ps(0.85f), e), _mm_and_ps(mean, sign_mask)));
+    __m128 sine{};
+    __m128 cosine{};
+    for (unsigned iteration = 0; iteration < max_iterations; ++iteration) {
+      sse_math::sincos4(anomaly_e, sine, cosine);
+      __m128 f = _mm_sub_ps(_mm_sub_ps(anomaly_e, _mm_mul_ps(e, sine)), mean);
+      __m128 step = _mm_div_ps(f, _mm_sub_ps(one, _mm_mul_ps(e, cosine)));
+      anomaly_e = _mm_sub_ps(anomaly_e, step);
+      // all four converged
+      if (_mm_movemask_ps(_mm_cmpgt_ps(_mm_and_ps(step, abs_mask), _mm_set1_ps(tolerance))) == 0) {
+        break;
+      }
+    }
+    sse_math::sincos4(anomaly_e, sine, cosine);
+
+    __m128 along = _mm_sub_ps(cosine, e);
+    float x[4];
+    float y[4];
+    float z[4];
+    _mm_storeu_ps(x, _mm_add_ps(_mm_mul_ps(along, _mm_loadu_ps(&periapsis_x_[i])), _mm_mul_ps(sine, _mm_loadu_ps(&motion_x_[i]))));
+    _mm_storeu_ps(y, _mm_add_ps(_mm_mul_ps(along, _mm_loadu_ps(&periapsis_y_[i])), _mm_mul_ps(sine, _mm_loadu_ps(&motion_y_[i]))));
+    _mm_storeu_ps(z, _mm_add_ps(_mm_mul_ps(along, _mm_loadu_ps(&periapsis_z_[i])), _mm_mul_ps(sine, _mm_loadu_ps(&motion_z_[i]))));
+    for (unsigned lane = 0; lane < 4; ++lane) {
+      float* position = out + (i + lane) * stride;
+      position[0] = x[lane];
+      position[1] = y[lane];
+      position[2] = z[lane];
+    }
+  }
+#endif
+  // remaining orbits, or all of them without SSE
+  for (; i < end; ++i) {
+    float e = eccentricity_[i];
+    float mean = float(std::remainder(double(mean_anomaly_[i]) + double(mean_motion_[i]) * time, glm::two_pi<double>()));
+    float anomaly = mean + std::copysign(0.85f * e, mean);
+    float sine = 0.0f;
+    float cosine = 0.0f;
+    for (unsigned iteration = 0; iteration < max_iterations; ++iteration) {
+      sine = std::sin(anomaly);
+      cosine = std::cos(anomaly);
+      float step = (anomaly - e * sine - mean) / (1.0f - e * cosine);
+      anomaly -= step;
+      if (std::abs(step) <= tolerance) {
+        break;
+      }
+    }
+    sine = std::sin(anomaly);
+    cosine = std::cos(anomaly);
+
+    float along = cosine - e;
+    float* position = out + i * stride;
+    position[0] = along * periapsis_x_[i] + sine * motion_x_[i];
+    position[1] = along * periapsis_y_[i] + sine * motion_y_[i];
+    position[2] = along * periapsis_z_[i] + sine * motion_z_[i];
+  }
+}
+
+void orbit_set::propagate(double time, std::vector<glm::fvec3>& positions) const {
+  positions.resize(size());
+  float* out = positions.empty() ? nullptr : &positions[0].x;
+  parallel::for_range(size(), 4096, [&](unsigned, std::size_t begin, std::size_t end) {
+    propagate(time, begin, end, out, 3);
+  });
+}
+
+}
@@ -4,15 +4,20 @@
 #include <glm/gtc/type_precision.hpp>
 #include <glm/geometric.hpp>
 
+#include "parallel.hpp"
+#include "trace.hpp"
+
+#include <cmath>
 #include <iostream>
 
 namespace model_loader {
 
 void generate_normals(tinyobj::mesh_t& model);
 
-std::vector<glm::fvec3> generate_tangents(tinyobj::mesh_t const& model);
+void generate_tangents(tinyobj::mesh_t const& model, std::vector<glm::fvec3>& tangents, std::vector<glm::fvec3>& bitangents);
 
 model obj(std::string const& name, model::attrib_flag_t import_attribs){
+    TRACE_ZONE_DETAIL("load obj", name);
     std::vector<tinyobj::shape_t> shapes;
     std::vector<tinyobj::material_t> materials;
 
@@ -54,16 +59,28 @@ model obj(std::string const& name, model::attrib_flag_t import_attribs){
             }
         }
 
-        bool has_tangents = import_attribs & model::TANGENT;
+        bool has_tangents = (import_attribs & model::TANGENT) != 0;
+        bool has_bitangents = (import_attribs & model::BITANGENT) != 0;
         std::vector<glm::fvec3> tangents;
-        if (has_tangents) {
+        std::vector<glm::fvec3> bitangents;
+        if (has_tangents || has_bitangents) {
             if (!has_uvs) {
-                has_tangents = false;
-                attributes ^= model::TANGENT;
+                if (has_tangents) {
+                    has_tangents = false;
+                    attributes ^= model::TANGENT;
+                }
+                if (has_bitangents) {
+                    has_bitangents = false;
+                    attributes ^= model::BITANGENT;
+                }
                 std::cerr << "Shape has no texcoords" << std::endl;
             }
             else {
-                tangents = generate_tangents(curr_mesh);
+                // tangent frame is orthogonalized against the normals
+                if (curr_mesh.normals.empty()) {
+                    generate_normals(curr_mesh);
+                }
+                generate_tangents(curr_mesh, tangents, bitangents);
             }
         }
 
@@ -89,6 +106,12 @@ model obj(std::string const& name, model::attrib_flag_t import_attribs){
                 vertex_data.push_back(tangents[i].y);
                 vertex_data.push_back(tangents[i].z);
             }
+
+            if (has_bitangents) {
+                vertex_data.push_back(bitangents[i].x);
+                vertex_data.push_back(bitangents[i].y);
+                vertex_data.push_back(bitangents[i].z);
+            }
         }
 
         // add triangles
@@ -102,37 +125,60 @@ model obj(std::string const& name, model::attrib_flag_t import_attribs){
     return model{vertex_data, attributes, triangles};
 }
 
+// minimal number of triangles per thread for attribute generation
+static std::size_t const triangle_grain = 4096;
+
 void generate_normals(tinyobj::mesh_t& model) {
-  std::vector<glm::fvec3> positions(model.positions.size() / 3);
+  std::size_t num_vertices = model.positions.size() / 3;
+  std::size_t num_triangles = model.indices.size() / 3;
 
+  std::vector<glm::fvec3> positions(num_vertices);
   for (unsigned i = 0; i < model.positions.size(); i+=3) {
     positions[i / 3] = glm::fvec3{model.positions[i], model.positions[i + 1], model.positions[i + 2]};
   }
 
-  std::vector<glm::fvec3> normals(model.positions.size() / 3, glm::fvec3{0.0f});
-  for (unsigned i = 0; i < model.indices.size(); i+=3) {
-    glm::fvec3 normal = glm::cross(positions[model.indices[i+1]] - positions[model.indices[i]], positions[model.indices[i+2]] - positions[model.indices[i]]);
-
-    normals[model.indices[i]] += normal;
-    normals[model.indices[i+1]] += normal;
-    normals[model.indices[i+2]] += normal;
-  }
-
-  model.normals.reserve(model.positions.size());
-  for (unsigned i = 0; i < normals.size(); ++i) {
-    glm::fvec3 normal = glm::normalize(normals[i]);
-    model.normals[i * 3] = normal[0];
-    model.normals[i * 3 + 1] = normal[1];
-    model.normals[i * 3 + 2] = normal[2];
-  }
+  // each thread accumulates face normals of its triangles in a separate buffer
+  std::vector<std::vector<glm::fvec3>> accumulated(parallel::chunk_count(num_triangles, triangle_grain));
+  parallel::for_range(num_triangles, triangle_grain, [&](unsigned chunk, std::size_t begin, std::size_t end) {
+    std::vector<glm::fvec3>& normals = accumulated[chunk];
+    normals.assign(num_vertices, glm::fvec3{0.0f});
+    for (std::size_t t = begin; t < end; ++t) {
+      unsigned i0 = model.indices[t * 3];
+      unsigned i1 = model.indices[t * 3 + 1];
+      unsigned i2 = model.indices[t * 3 + 2];
+      // unnormalized cross product weights normal by triangle area
+      glm::fvec3 normal = glm::cross(positions[i1] - positions[i0], positions[i2] - positions[i0]);
+
+      normals[i0] += normal;
+      normals[i1] += normal;
+      normals[i2] += normal;
+    }
+  });
+
+  // sum up partial results and write them to the mesh
+  model.normals.resize(num_vertices * 3);
+  parallel::for_range(num_vertices, triangle_grain, [&](unsigned, std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+      glm::fvec3 normal{0.0f};
+      for (auto const& normals : accumulated) {
+        normal += normals[i];
+      }
+      normal = glm::normalize(normal);
+      model.normals[i * 3] = normal[0];
+      model.normals[i * 3 + 1] = normal[1];
+      model.normals[i * 3 + 2] = normal[2];
+    }
+  });
 }
 
-std::vector<glm::fvec3> generate_tangents(tinyobj::mesh_t const& model) {
+void generate_tangents(tinyobj::mesh_t const& model, std::vector<glm::fvec3>& tangents, std::vector<glm::fvec3>& bitangents) {
+  std::size_t num_vertices = model.positions.size() / 3;
+  std::size_t num_triangles = model.indices.size() / 3;
+
   // containers for vertex attributes
-  std::vector<glm::fvec3> positions(model.positions.size() / 3);
-  std::vector<glm::fvec3> normals(model.positions.size() / 3);
-  std::vector<glm::fvec2> texcoords(model.positions.size() / 3);
-  std::vector<glm::fvec3> tangents(model.positions.size() / 3, glm::fvec3{0.0f});
+  std::vector<glm::fvec3> positions(num_vertices);
+  std::vector<glm::fvec3> normals(num_vertices);
+  std::vector<glm::fvec2> texcoords(num_vertices);
 
   // get vertex positions and texture coordinates from mesh_t
   for (unsigned i = 0; i < model.positions.size(); i+=3) {
@@ -147,25 +193,73 @@ std::vector<glm::fvec3> generate_tangents(tinyobj::mesh_t const& model) {
     texcoords[i / 2] = glm::fvec2{model.texcoords[i], model.texcoords[i + 1]};
   }
 
-  // calculate tangent for triangles
-  for (unsigned i = 0; i < model.indices.size() / 3; i++) {
-    // indices of vertices of this triangle
-    // unsigned indices[3] = {model.indices[i * 3],
-    //                        model.indices[i * 3 + 1],
-    //                        model.indices[i * 3 + 2]};
-    // access an attribute of xth vert with vector access "attribute[indices[x]]"
-    
-    // calculate tangent for the triangle and add it to the accumulation tangents of the adjacent vertices
-    // see generate_normals() for similar workflow 
-  }
-  // normalize and orthogonalize accumulated vertex tangents
-  for (unsigned i = 0; i < tangents.size(); ++i) {
-    // implement orthogonalization and normalization here
-  }
+  // per thread accumulation buffers, see generate_normals() for similar workflow
+  unsigned chunks = parallel::chunk_count(num_triangles, triangle_grain);
+  std::vector<std::vector<glm::fvec3>> accum_tangents(chunks);
+  std::vector<std::vector<glm::fvec3>> accum_bitangents(chunks);
 
-  throw std::logic_error("Tangent creation not implemented yet");
+  // calculate tangent for triangles
+  parallel::for_range(num_triangles, triangle_grain, [&](unsigned chunk, std::size_t begin, std::size_t end) {
+    std::vector<glm::fvec3>& tangent_sum = accum_tangents[chunk];
+    std::vector<glm::fvec3>& bitangent_sum = accum_bitangents[chunk];
+    tangent_sum.assign(num_vertices, glm::fvec3{0.0f});
+    bitangent_sum.assign(num_vertices, glm::fvec3{0.0f});
+
+    for (std::size_t t = begin; t < end; ++t) {
+      // indices of vertices of this triangle
+      unsigned indices[3] = {model.indices[t * 3],
+                             model.indices[t * 3 + 1],
+                             model.indices[t * 3 + 2]};
+      // triangle edges in object and texture space
+      glm::fvec3 edge1 = positions[indices[1]] - positions[indices[0]];
+      glm::fvec3 edge2 = positions[indices[2]] - positions[indices[0]];
+      glm::fvec2 delta_uv1 = texcoords[indices[1]] - texcoords[indices[0]];
+      glm::fvec2 delta_uv2 = texcoords[indices[2]] - texcoords[indices[0]];
+
+      float det = delta_uv1.x * delta_uv2.y - delta_uv2.x * delta_uv1.y;
+      // skip triangles with degenerated texture coordinates
+      if (std::abs(det) < 1e-12f) {
+        continue;
+      }
+      float r = 1.0f / det;
+      glm::fvec3 tangent = (edge1 * delta_uv2.y - edge2 * delta_uv1.y) * r;
+      glm::fvec3 bitangent = (edge2 * delta_uv1.x - edge1 * delta_uv2.x) * r;
+
+      // add it to the accumulation tangents of the adjacent vertices
+      for (unsigned v = 0; v < 3; ++v) {
+        tangent_sum[indices[v]] += tangent;
+        bitangent_sum[indices[v]] += bitangent;
+      }
+    }
+  });
 
-  return tangents;
+  tangents.assign(num_vertices, glm::fvec3{0.0f});
+  bitangents.assign(num_vertices, glm::fvec3{0.0f});
+  // normalize and orthogonalize accumulated vertex tangents
+  parallel::for_range(num_vertices, triangle_grain, [&](unsigned, std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+      glm::fvec3 tangent{0.0f};
+      glm::fvec3 bitangent{0.0f};
+      for (unsigned chunk = 0; chunk < chunks; ++chunk) {
+        tangent += accum_tangents[chunk][i];
+        bitangent += accum_bitangents[chunk][i];
+      }
+      glm::fvec3 const& normal = normals[i];
+      // Gram-Schmidt, remove normal component from tangent
+      tangent = tangent - normal * glm::dot(normal, tangent);
+      // vertex is not part of any valid triangle, build arbitrary frame
+      if (glm::dot(tangent, tangent) < 1e-12f) {
+        glm::fvec3 axis = std::abs(normal.x) < 0.9f ? glm::fvec3{1.0f, 0.0f, 0.0f} : glm::fvec3{0.0f, 1.0f, 0.0f};
+        tangent = glm::cross(axis, normal);
+      }
+      tangent = glm::normalize(tangent);
+      // keep handedness of the texture mapping for mirrored uvs
+      float handedness = glm::dot(glm::cross(normal, tangent), bitangent) < 0.0f ? -1.0f : 1.0f;
+
+      tangents[i] = tangent;
+      bitangents[i] = glm::cross(normal, tangent) * handedness;
+    }
+  });
 }
 
 }
\ No newline at end of file
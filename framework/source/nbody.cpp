@@ -0,0 +1,358 @@
+#include "nbody.hpp"
+
+#include "parallel.hpp"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace nbody {
+
+// octree depth, three bits of the morton key per level
+static unsigned const max_level = 21;
+// primary of particles which are not bound to another one
+static std::uint32_t const no_primary = std::numeric_limits<std::uint32_t>::max();
+
+// spread the lower 21 bits of a value so two zero bits follow each
+static std::uint64_t spread_bits(std::uint64_t value) {
+  value &= 0x1fffff;
+  value = (value | value << 32) & 0x1f00000000ffffull;
+  value = (value | value << 16) & 0x1f0000ff0000ffull;
+  value = (value | value << 8) & 0x100f00f00f00f00full;
+  value = (value | value << 4) & 0x10c30c30c30c30c3ull;
+  value = (value | value << 2) & 0x1249249249249249ull;
+  return value;
+}
+
+simulation::simulation()
+ :simulation{parameters{}}
+{}
+
+simulation::simulation(parameters const& params)
+ :params_(params)
+ ,time_{0.0}
+ ,evaluated_{false}
+ ,has_initial_energy_{false}
+ ,initial_energy_{0.0}
+ ,positions_{}
+ ,velocities_{}
+ ,accelerations_{}
+ ,masses_{}
+ ,potentials_{}
+ ,primaries_{}
+ ,satellites_{}
+ ,keys_{}
+ ,order_{}
+ ,sorted_positions_{}
+ ,sorted_masses_{}
+ ,cells_{}
+{
+  params_.leaf_size = std::max(params_.leaf_size, std::size_t{1});
+}
+
+void simulation::clear() {
+  time_ = 0.0;
+  evaluated_ = false;
+  has_initial_energy_ = false;
+  positions_.clear();
+  velocities_.clear();
+  accelerations_.clear();
+  masses_.clear();
+  potentials_.clear();
+  primaries_.clear();
+  satellites_.clear();
+  cells_.clear();
+}
+
+void simulation::reserve(std::size_t count) {
+  positions_.reserve(count);
+  velocities_.reserve(count);
+  accelerations_.reserve(count);
+  masses_.reserve(count);
+  potentials_.reserve(count);
+  primaries_.reserve(count);
+}
+
+std::size_t simulation::add(double mass, glm::dvec3 const& position, glm::dvec3 const& velocity) {
+  positions_.push_back(position);
+  velocities_.push_back(velocity);
+  accelerations_.push_back(glm::dvec3{0.0});
+  masses_.push_back(mass);
+  potentials_.push_back(0.0);
+  primaries_.push_back(no_primary);
+  // the total energy changed, the drift starts over
+  evaluated_ = false;
+  has_initial_energy_ = false;
+  return positions_.size() - 1;
+}
+
+std::size_t simulation::add(double mass, glm::dvec3 const& position, glm::dvec3 const& velocity, std::size_t primary) {
+  if (primary >= size() || primaries_[primary] != no_primary) {
+    throw std::logic_error("nbody: the primary must be an earlier particle without a primary");
+  }
+  std::size_t index = add(mass, position, velocity);
+  primaries_[index] = std::uint32_t(primary);
+  satellites_.push_back(std::uint32_t(index));
+  return index;
+}
+
+std::size_t simulation::size() const {
+  return positions_.size();
+}
+
+void simulation::step(double dt) {
+  if (!evaluated_) {
+    evaluate();
+  }
+
+  double half_dt = 0.5 * dt;
+  parallel::for_range(size(), 16384, [&](unsigned, std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+      velocities_[i] += half_dt * accelerations_[i];
+      positions_[i] += dt * velocities_[i];
+    }
+  });
+
+  evaluate();
+
+  parallel::for_range(size(), 16384, [&](unsigned, std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+      velocities_[i] += half_dt * accelerations_[i];
+    }
+  });
+  time_ += dt;
+}
+
+void simulation::evaluate() {
+  build_tree();
+
+  // sorted particles are close in space, so neighbouring threads walk similar parts of the tree
+  parallel::for_range(order_.size(), 1024, [&](unsigned, std::size_t begin, std::size_t end) {
+    for (std::size_t s = begin; s < end; ++s) {
+      std::uint32_t i = order_[s];
+      gravity_at(s, accelerations_[i], potentials_[i]);
+    }
+  });
+  // bound particles follow their primaries, which are free and evaluated now
+  for (std::uint32_t i : satellites_) {
+    satellite_gravity(i, accelerations_[i], potentials_[i]);
+  }
+  evaluated_ = true;
+}
+
+diagnostics simulation::energy() {
+  if (!evaluated_) {
+    evaluate();
+  }
+
+  diagnostics result{};
+  for (std::size_t i = 0; i < size(); ++i) {
+    if (primaries_[i] == no_primary) {
+      result.kinetic += 0.5 * masses_[i] * glm::dot(velocities_[i], velocities_[i]);
+      // every pair is part of both potentials
+      result.potential += 0.5 * masses_[i] * potentials_[i];
+    }
+    else {
+      // a bound particle keeps its energy in the frame of its primary, only the pair with the primary counts
+      glm::dvec3 velocity = velocities_[i] - velocities_[primaries_[i]];
+      result.kinetic += 0.5 * masses_[i] * glm::dot(velocity, velocity);
+      result.potential += masses_[i] * potentials_[i];
+    }
+  }
+  result.total = result.kinetic + result.potential;
+
+  if (!has_initial_energy_) {
+    initial_energy_ = result.total;
+    has_initial_energy_ = true;
+  }
+  if (initial_energy_ != 0.0) {
+    result.drift = (result.total - initial_energy_) / std::abs(initial_energy_);
+  }
+  return result;
+}
+
+double simulation::time() const {
+  return time_;
+}
+
+parameters const& simulation::params() const {
+  return params_;
+}
+
+glm::dvec3 const& simulation::position(std::size_t index) const {
+  return positions_[index];
+}
+
+glm::dvec3 const& simulation::velocity(std::size_t index) const {
+  return velocities_[index];
+}
+
+double simulation::mass(std::size_t index) const {
+  return masses_[index];
+}
+
+std::size_t simulation::primary(std::size_t index) const {
+  return primaries_[index] == no_primary ? size() : std::size_t(primaries_[index]);
+}
+
+void simulation::build_tree() {
+  // bound particles act on nothing but their primary, so the tree holds only the free ones
+  std::vector<std::uint32_t> free_particles{};
+  free_particles.reserve(size() - satellites_.size());
+  for (std::size_t i = 0; i < size(); ++i) {
+    if (primaries_[i] == no_primary) {
+      free_particles.push_back(std::uint32_t(i));
+    }
+  }
+  std::size_t count = free_particles.size();
+  cells_.clear();
+  order_.clear();
+  if (count == 0) {
+    return;
+  }
+
+  // bounding cube of all particles
+  glm::dvec3 lower{std::numeric_limits<double>::max()};
+  glm::dvec3 upper{-std::numeric_limits<double>::max()};
+  for (std::uint32_t i : free_particles) {
+    lower = glm::min(lower, positions_[i]);
+    upper = glm::max(upper, positions_[i]);
+  }
+  glm::dvec3 extent = upper - lower;
+  double size = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-9));
+
+  // sort the particles along a morton curve, cells of the octree become contiguous ranges
+  double scale = double(1u << max_level) / size;
+  std::vector<std::pair<std::uint64_t, std::uint32_t>> sorted(count);
+  parallel::for_range(count, 16384, [&](unsigned, std::size_t begin, std::size_t end) {
+    std::uint64_t const max_coordinate = (1u << max_level) - 1;
+    for (std::size_t i = begin; i < end; ++i) {
+      glm::dvec3 cube = (positions_[free_particles[i]] - lower) * scale;
+      std::uint64_t key = 0;
+      for (int axis = 0; axis < 3; ++axis) {
+        key |= spread_bits(std::min(std::uint64_t(cube[axis]), max_coordinate)) << (2 - axis);
+      }
+      sorted[i] = std::make_pair(key, free_particles[i]);
+    }
+  });
+  std::sort(sorted.begin(), sorted.end());
+
+  keys_.resize(count);
+  order_.resize(count);
+  sorted_positions_.resize(count);
+  sorted_masses_.resize(count);
+  for (std::size_t s = 0; s < count; ++s) {
+    keys_[s] = sorted[s].first;
+    order_[s] = sorted[s].second;
+    sorted_positions_[s] = positions_[sorted[s].second];
+    sorted_masses_[s] = masses_[sorted[s].second];
+  }
+
+  cells_.reserve(2 * count / params_.leaf_size + 1);
+  build_cell(0, count, 0, lower, size);
+}
+
+std::uint32_t simulation::build_cell(std::size_t begin, std::size_t end, unsigned level,
+                                     glm::dvec3 const& corner, double size) {
+  std::uint32_t index = std::uint32_t(cells_.size());
+  cells_.push_back(cell{});
+
+  glm::dvec3 center_of_mass{0.0};
+  double mass = 0.0;
+  std::uint32_t first = 0;
+  std::uint32_t count = 0;
+  if (end - begin <= params_.leaf_size || level == max_level) {
+    for (std::size_t s = begin; s < end; ++s) {
+      center_of_mass += sorted_masses_[s] * sorted_positions_[s];
+      mass += sorted_masses_[s];
+    }
+    first = std::uint32_t(begin);
+    count = std::uint32_t(end - begin);
+  } else {
+    // children are the runs of equal octant bits below this level
+    unsigned shift = 3 * (max_level - level - 1);
+    double half = 0.5 * size;
+    std::size_t child_begin = begin;
+    while (child_begin < end) {
+      std::uint64_t octant = keys_[child_begin] >> shift & 7;
+      std::size_t child_end = std::size_t(std::partition_point(
+          keys_.begin() + std::ptrdiff_t(child_begin), keys_.begin() + std::ptrdiff_t(end),
+          [&](std::uint64_t key) { return (key >> shift & 7) == octant; }) - keys_.begin());
+      glm::dvec3 child_corner = corner + half * glm::dvec3{double(octant >> 2 & 1), double(octant >> 1 & 1), double(octant & 1)};
+      std::uint32_t child = build_cell(child_begin, child_end, level + 1, child_corner, half);
+      center_of_mass += cells_[child].mass * cells_[child].center_of_mass;
+      mass += cells_[child].mass;
+      child_begin = child_end;
+    }
+  }
+  center_of_mass = mass > 0.0 ? center_of_mass / mass : corner + 0.5 * size;
+
+  // a cell is opened within size / angle of its mass center plus the offset of the mass center from the cube
+  // center, so a particle is never approximated by a cell containing it
+  double open_distance = std::numeric_limits<double>::max();
+  if (params_.opening_angle > 0.0) {
+    open_distance = size / params_.opening_angle + glm::distance(center_of_mass, corner + 0.5 * size);
+  }
+
+  cell& current = cells_[index];
+  current.center_of_mass = center_of_mass;
+  current.mass = mass;
+  current.open_distance = open_distance;
+  current.first = first;
+  current.count = count;
+  current.next = std::uint32_t(cells_.size());
+  return index;
+}
+
+void simulation::gravity_at(std::size_t sorted, glm::dvec3& acceleration, double& potential) const {
+  glm::dvec3 const position = sorted_positions_[sorted];
+  double const softening_squared = params_.softening * params_.softening;
+  glm::dvec3 sum{0.0};
+  double sum_potential = 0.0;
+
+  // stackless walk, a cell either is taken whole or its first child is visited next
+  std::size_t index = 0;
+  std::size_t const cell_count = cells_.size();
+  while (index < cell_count) {
+    cell const& current = cells_[index];
+    glm::dvec3 offset = current.center_of_mass - position;
+    double distance_squared = glm::dot(offset, offset);
+    if (distance_squared > current.open_distance * current.open_distance) {
+      double inverse = 1.0 / std::sqrt(distance_squared + softening_squared);
+      sum += (current.mass * inverse * inverse * inverse) * offset;
+      sum_potential -= current.mass * inverse;
+      index = current.next;
+    } else if (current.count > 0) {
+      for (std::size_t s = current.first; s < current.first + current.count; ++s) {
+        if (s == sorted) {
+          continue;
+        }
+        glm::dvec3 pair_offset = sorted_positions_[s] - position;
+        double inverse = 1.0 / std::sqrt(glm::dot(pair_offset, pair_offset) + softening_squared);
+        sum += (sorted_masses_[s] * inverse * inverse * inverse) * pair_offset;
+        sum_potential -= sorted_masses_[s] * inverse;
+      }
+      index = current.next;
+    } else {
+      ++index;
+    }
+  }
+
+  acceleration = params_.gravity * sum;
+  potential = params_.gravity * sum_potential;
+}
+
+void simulation::satellite_gravity(std::size_t index, glm::dvec3& acceleration, double& potential) const {
+  std::uint32_t primary = primaries_[index];
+  glm::dvec3 offset = positions_[primary] - positions_[index];
+  double inverse = 1.0 / std::sqrt(glm::dot(offset, offset) + params_.softening * params_.softening);
+  // the other particles pull the primary and the bound particle alike, so only the primary moves it relative to it
+  acceleration = accelerations_[primary] + (params_.gravity * masses_[primary] * inverse * inverse * inverse) * offset;
+  potential = -params_.gravity * masses_[primary] * inverse;
+}
+
+}
@@ -0,0 +1,73 @@
+#include "parallel.hpp"
+
+#include "trace.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+
+unsigned thread_count() {
+  // hardware_concurrency may return 0 if unknown
+  static unsigned const threads = std::max(1u, std::thread::hardware_concurrency());
+  return threads;
+}
+
+unsigned chunk_count(std::size_t count, std::size_t grain) {
+  if (count == 0) {
+    return 0;
+  }
+  grain = std::max(grain, std::size_t{1});
+  std::size_t chunks = std::min(std::size_t{thread_count()}, (count + grain - 1) / grain);
+  return unsigned(std::max(chunks, std::size_t{1}));
+}
+
+void for_range(std::size_t count, std::size_t grain,
+               std::function<void(unsigned chunk, std::size_t begin, std::size_t end)> const& func) {
+  unsigned chunks = chunk_count(count, grain);
+  if (chunks == 0) {
+    return;
+  }
+  // small ranges are not worth spawning threads for
+  if (chunks == 1) {
+    func(0, 0, count);
+    return;
+  }
+
+  std::size_t chunk_size = (count + chunks - 1) / chunks;
+  std::vector<std::exception_ptr> errors(chunks);
+  std::vector<std::thread> workers{};
+  workers.reserve(chunks - 1);
+
+  auto run_chunk = [&](unsigned chunk) {
+    TRACE_ZONE("parallel chunk");
+    std::size_t begin = std::min(count, chunk * chunk_size);
+    std::size_t end = std::min(count, begin + chunk_size);
+    try {
+      func(chunk, begin, end);
+    }
+    catch (...) {
+      errors[chunk] = std::current_exception();
+    }
+  };
+
+  for (unsigned chunk = 1; chunk < chunks; ++chunk) {
+    workers.emplace_back(run_chunk, chunk);
+  }
+  // calling thread processes the first chunk itself
+  run_chunk(0);
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  // forward first exception to caller
+  for (auto const& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+}
@@ -0,0 +1,26 @@
+#include "picking.hpp"
+
+#include <glm/geometric.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+
+namespace picking {
+
+ray screen_ray(glm::fvec2 const& pixel, glm::uvec2 const& viewport, glm::fmat4 const& projection, glm::fmat4 const& view) {
+  // pixel center to normalized device coordinates, window y points down
+  glm::fvec2 ndc{(pixel.x + 0.5f) / float(viewport.x) * 2.0f - 1.0f,
+                 1.0f - (pixel.y + 0.5f) / float(viewport.y) * 2.0f};
+
+  // unproject points on the near and far plane
+  glm::fmat4 inverse_view_projection = glm::inverse(projection * view);
+  glm::fvec4 near_point = inverse_view_projection * glm::fvec4{ndc, -1.0f, 1.0f};
+  glm::fvec4 far_point = inverse_view_projection * glm::fvec4{ndc, 1.0f, 1.0f};
+  near_point /= near_point.w;
+  far_point /= far_point.w;
+
+  ray result{};
+  result.origin = glm::fvec3{near_point};
+  result.direction = glm::normalize(glm::fvec3{far_point - near_point});
+  return result;
+}
+
+}
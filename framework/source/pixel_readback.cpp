@@ -0,0 +1,72 @@
+#include "pixel_readback.hpp"
+
+#include <glbinding/gl/functions.h>
+#include <glbinding/gl/enum.h>
+#include <glbinding/gl/bitfield.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+pixel_readback::pixel_readback()
+ :slots_{}
+ ,first_{0}
+ ,count_{0}
+{}
+
+pixel_readback::~pixel_readback() {
+  for (auto& slot : slots_) {
+    if (slot.fence) {
+      glDeleteSync(slot.fence);
+    }
+    glDeleteBuffers(1, &slot.buffer);
+  }
+}
+
+bool pixel_readback::request(GLenum attachment, GLint x, GLint y) {
+  if (count_ == slots_.size()) {
+    return false;
+  }
+  slot& target = slots_[(first_ + count_) % slots_.size()];
+  // buffers are created on first use, so no context is needed on construction
+  if (target.buffer == 0) {
+    glGenBuffers(1, &target.buffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, target.buffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, sizeof(GLuint), NULL, GL_STREAM_READ);
+  }
+
+  // with a pack buffer bound, the pixel is copied asynchronously into the buffer
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, target.buffer);
+  glReadBuffer(attachment);
+  glReadPixels(x, y, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  target.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, GL_UNUSED_BIT);
+  ++count_;
+  return true;
+}
+
+bool pixel_readback::poll(GLuint& value) {
+  if (count_ == 0) {
+    return false;
+  }
+  slot& oldest = slots_[first_];
+  // zero timeout only checks the state, flushing makes sure the fence is eventually reached
+  GLenum state = glClientWaitSync(oldest.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+  if (state != GL_ALREADY_SIGNALED && state != GL_CONDITION_SATISFIED) {
+    return false;
+  }
+  glDeleteSync(oldest.fence);
+  oldest.fence = nullptr;
+
+  // copy has finished, reading the buffer does not wait
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, oldest.buffer);
+  glGetBufferSubData(GL_PIXEL_PACK_BUFFER, 0, sizeof(GLuint), &value);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  first_ = (first_ + 1) % slots_.size();
+  --count_;
+  return true;
+}
+
+bool pixel_readback::pending() const {
+  return count_ > 0;
+}
@@ -0,0 +1,346 @@
+#include "proximity.hpp"
+
+#include "parallel.hpp"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace proximity {
+
+// bands are this much higher than twice the largest box half extent, so growing boxes rarely force a rebuild
+static float const band_slack = 1.25f;
+
+static bool contact_less(contact const& a, contact const& b) {
+  return a.first < b.first || (a.first == b.first && a.second < b.second);
+}
+
+detector::detector()
+ :detector{parameters{}}
+{}
+
+detector::detector(parameters const& params)
+ :params_(params)
+ ,axis_{0}
+ ,band_axis_{2}
+ ,band_origin_{0.0f}
+ ,band_height_{1.0f}
+ ,band_count_{1}
+ ,band_start_{}
+ ,previous_{}
+ ,boxes_{}
+ ,sorted_boxes_{}
+ ,contacts_{}
+ ,last_contacts_{}
+ ,events_{}
+ ,chunk_contacts_{}
+ ,stats_{}
+{}
+
+void detector::clear() {
+  band_start_.clear();
+  previous_.clear();
+  boxes_.clear();
+  contacts_.clear();
+  last_contacts_.clear();
+  events_.clear();
+  stats_ = update_stats{};
+}
+
+void detector::update(culling::sphere_batch const& spheres) {
+  std::size_t const count = spheres.size();
+
+  // new or different spheres start without motion and without contacts
+  bool restart = count != previous_.size();
+  if (restart) {
+    clear();
+    previous_.resize(count);
+    boxes_.resize(count);
+    for (std::size_t i = 0; i < count; ++i) {
+      previous_[i] = glm::fvec3{spheres.x[i], spheres.y[i], spheres.z[i]};
+      boxes_[i].index = std::uint32_t(i);
+    }
+  }
+  stats_ = update_stats{};
+
+  float max_extent = refresh_boxes(spheres);
+  if (restart || 2.0f * max_extent > band_height_) {
+    rebuild();
+  } else {
+    resort();
+  }
+
+  // bands are swept independently, each finds its pairs with itself and with the next band
+  unsigned const chunks = parallel::chunk_count(band_count_, 1);
+  chunk_contacts_.resize(chunks);
+  std::vector<std::size_t> chunk_pairs(chunks, 0);
+  parallel::for_range(band_count_, 1, [&](unsigned chunk, std::size_t begin, std::size_t end) {
+    chunk_contacts_[chunk].clear();
+    for (std::size_t band = begin; band < end; ++band) {
+      sweep(spheres, band, chunk_contacts_[chunk], chunk_pairs[chunk]);
+    }
+  });
+
+  last_contacts_.swap(contacts_);
+  contacts_.clear();
+  for (unsigned chunk = 0; chunk < chunks; ++chunk) {
+    contacts_.insert(contacts_.end(), chunk_contacts_[chunk].begin(), chunk_contacts_[chunk].end());
+    stats_.broad_pairs += chunk_pairs[chunk];
+  }
+  std::sort(contacts_.begin(), contacts_.end(), contact_less);
+  stats_.contacts = contacts_.size();
+
+  // both lists are sorted, so entering and leaving pairs fall out of one merge
+  events_.clear();
+  auto current = contacts_.begin();
+  auto last = last_contacts_.begin();
+  while (current != contacts_.end() || last != last_contacts_.end()) {
+    if (last == last_contacts_.end() || (current != contacts_.end() && contact_less(*current, *last))) {
+      events_.push_back(event{*current++, event_kind::enter});
+    } else if (current == contacts_.end() || contact_less(*last, *current)) {
+      events_.push_back(event{*last++, event_kind::leave});
+    } else {
+      ++current;
+      ++last;
+    }
+  }
+
+  parallel::for_range(count, 16384, [&](unsigned, std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+      previous_[i] = glm::fvec3{spheres.x[i], spheres.y[i], spheres.z[i]};
+    }
+  });
+}
+
+std::vector<contact> const& detector::contacts() const {
+  return contacts_;
+}
+
+std::vector<event> const& detector::events() const {
+  return events_;
+}
+
+update_stats const& detector::stats() const {
+  return stats_;
+}
+
+parameters const& detector::params() const {
+  return params_;
+}
+
+float detector::refresh_boxes(culling::sphere_batch const& spheres) {
+  // half the margin on each box, so overlapping boxes are necessary for spheres within the margin
+  float const half_margin = 0.5f * params_.margin;
+  std::vector<float> chunk_extents(parallel::chunk_count(boxes_.size(), 16384), 0.0f);
+  parallel::for_range(boxes_.size(), 16384, [&](unsigned chunk, std::size_t begin, std::size_t end) {
+    float max_extent = 0.0f;
+    for (std::size_t k = begin; k < end; ++k) {
+      swept_box& box = boxes_[k];
+      std::uint32_t i = box.index;
+      glm::fvec3 current{spheres.x[i], spheres.y[i], spheres.z[i]};
+      glm::fvec3 extent{spheres.radius[i] + half_margin};
+      box.min = glm::min(previous_[i], current) - extent;
+      box.max = glm::max(previous_[i], current) + extent;
+      max_extent = std::max(max_extent, box.max[band_axis_] - box.min[band_axis_]);
+    }
+    chunk_extents[chunk] = 0.5f * max_extent;
+  });
+  return chunk_extents.empty() ? 0.0f : *std::max_element(chunk_extents.begin(), chunk_extents.end());
+}
+
+std::uint32_t detector::band_of(swept_box const& box) const {
+  float center = 0.5f * (box.min[band_axis_] + box.max[band_axis_]);
+  float band = std::floor((center - band_origin_) / band_height_);
+  // boxes beyond the outer bands join them, which keeps them correct and only costs pairs
+  return std::uint32_t(std::min(std::max(band, 0.0f), float(band_count_ - 1)));
+}
+
+void detector::rebuild() {
+  std::size_t const count = boxes_.size();
+  stats_.full_sort = true;
+
+  // sweep along the axis of the largest spread, which prunes the most pairs, and stack the bands along the second
+  glm::fvec3 mean{0.0f};
+  glm::fvec3 squares{0.0f};
+  glm::fvec3 lower{0.0f};
+  glm::fvec3 upper{0.0f};
+  float max_extent = 0.0f;
+  for (std::size_t k = 0; k < count; ++k) {
+    glm::fvec3 center = 0.5f * (boxes_[k].min + boxes_[k].max);
+    mean += center;
+    squares += center * center;
+    lower = k == 0 ? center : glm::min(lower, center);
+    upper = k == 0 ? center : glm::max(upper, center);
+    max_extent = std::max(max_extent, glm::fvec3{boxes_[k].max - boxes_[k].min}[band_axis_]);
+  }
+  if (count > 0) {
+    glm::fvec3 variance = squares / float(count) - (mean / float(count)) * (mean / float(count));
+    unsigned order[3] = {0, 1, 2};
+    std::sort(order, order + 3, [&](unsigned a, unsigned b) { return variance[a] > variance[b]; });
+    axis_ = order[0];
+    band_axis_ = order[1];
+    max_extent = 0.0f;
+    for (auto const& box : boxes_) {
+      max_extent = std::max(max_extent, box.max[band_axis_] - box.min[band_axis_]);
+    }
+  }
+
+  // about the square root of the count in bands, a uniform disc then has few boxes in reach of each box
+  float span = upper[band_axis_] - lower[band_axis_];
+  std::size_t target = std::max(std::size_t(std::sqrt(double(count))), std::size_t{1});
+  band_height_ = std::max(band_slack * max_extent, span / float(target));
+  band_height_ = std::max(band_height_, 1e-6f);
+  band_origin_ = lower[band_axis_];
+  band_count_ = std::min(target, std::size_t(span / band_height_) + 1);
+
+  for (auto& box : boxes_) {
+    box.band = band_of(box);
+  }
+  std::sort(boxes_.begin(), boxes_.end(), [this](swept_box const& a, swept_box const& b) {
+    return a.band < b.band || (a.band == b.band && a.min[axis_] < b.min[axis_]);
+  });
+  band_start_.assign(band_count_ + 1, 0);
+  for (auto const& box : boxes_) {
+    ++band_start_[box.band + 1];
+  }
+  for (std::size_t band = 0; band < band_count_; ++band) {
+    band_start_[band + 1] += band_start_[band];
+  }
+}
+
+void detector::resort() {
+  std::size_t const count = boxes_.size();
+
+  // stable counting sort by the new band, each band then holds three runs in the previous sweep order:
+  // boxes from lower bands, boxes that stayed and boxes from higher bands
+  std::vector<std::size_t> run_start(3 * band_count_ + 1, 0);
+  std::vector<std::uint32_t> keys(count);
+  for (std::size_t k = 0; k < count; ++k) {
+    std::uint32_t band = band_of(boxes_[k]);
+    std::uint32_t run = band > boxes_[k].band ? 0 : band == boxes_[k].band ? 1 : 2;
+    keys[k] = 3 * band + run;
+    ++run_start[keys[k] + 1];
+  }
+  for (std::size_t run = 0; run < 3 * band_count_; ++run) {
+    run_start[run + 1] += run_start[run];
+  }
+  sorted_boxes_.resize(count);
+  std::vector<std::size_t> next(run_start.begin(), run_start.end() - 1);
+  for (std::size_t k = 0; k < count; ++k) {
+    swept_box& box = sorted_boxes_[next[keys[k]]++];
+    box = boxes_[k];
+    box.band = keys[k] / 3;
+  }
+  boxes_.swap(sorted_boxes_);
+  for (std::size_t band = 0; band <= band_count_; ++band) {
+    band_start_[band] = run_start[3 * band];
+  }
+
+  // runs are nearly sorted by the coherent motion, insertion sort fixes them and merges join the three
+  auto less = [this](swept_box const& a, swept_box const& b) { return a.min[axis_] < b.min[axis_]; };
+  std::vector<std::size_t> chunk_moves(parallel::chunk_count(band_count_, 1), 0);
+  parallel::for_range(band_count_, 1, [&](unsigned chunk, std::size_t begin, std::size_t end) {
+    for (std::size_t band = begin; band < end; ++band) {
+      for (std::size_t run = 3 * band; run < 3 * band + 3; ++run) {
+        std::size_t const first = run_start[run];
+        std::size_t const last = run_start[run + 1];
+        std::size_t const max_moves = params_.max_moves_per_sphere * (last - first);
+        std::size_t moves = 0;
+        for (std::size_t k = first + 1; k < last && moves <= max_moves; ++k) {
+          swept_box moving = boxes_[k];
+          std::size_t m = k;
+          for (; m > first && less(moving, boxes_[m - 1]) && moves <= max_moves; --m, ++moves) {
+            boxes_[m] = boxes_[m - 1];
+          }
+          boxes_[m] = moving;
+        }
+        // too far from sorted, a run that moved a lot is sorted from scratch
+        if (moves > max_moves) {
+          std::sort(boxes_.begin() + std::ptrdiff_t(first), boxes_.begin() + std::ptrdiff_t(last), less);
+        }
+        chunk_moves[chunk] += moves;
+      }
+      auto first = boxes_.begin() + std::ptrdiff_t(run_start[3 * band]);
+      std::inplace_merge(first, boxes_.begin() + std::ptrdiff_t(run_start[3 * band + 1]),
+                         boxes_.begin() + std::ptrdiff_t(run_start[3 * band + 2]), less);
+      std::inplace_merge(first, boxes_.begin() + std::ptrdiff_t(run_start[3 * band + 2]),
+                         boxes_.begin() + std::ptrdiff_t(run_start[3 * band + 3]), less);
+    }
+  });
+  for (std::size_t moves : chunk_moves) {
+    stats_.moves += moves;
+  }
+}
+
+void detector::sweep(culling::sphere_batch const& spheres, std::size_t band, std::vector<contact>& found,
+                     std::size_t& pairs) const {
+  auto test = [&](swept_box const& a, swept_box const& b) {
+    if (a.min.x > b.max.x || b.min.x > a.max.x || a.min.y > b.max.y || b.min.y > a.max.y ||
+        a.min.z > b.max.z || b.min.z > a.max.z) {
+      return;
+    }
+    ++pairs;
+    contact result{};
+    if (narrow_phase(spheres, a.index, b.index, result)) {
+      found.push_back(result);
+    }
+  };
+
+  // a box meets the following boxes of its band that start before it ends
+  std::size_t const first = band_start_[band];
+  std::size_t const last = band_start_[band + 1];
+  for (std::size_t k = first; k < last; ++k) {
+    float const limit = boxes_[k].max[axis_];
+    for (std::size_t m = k + 1; m < last && boxes_[m].min[axis_] <= limit; ++m) {
+      test(boxes_[k], boxes_[m]);
+    }
+  }
+  if (band + 1 >= band_count_) {
+    return;
+  }
+
+  // against the next band each pair is found from the box that starts first, ties go to this band
+  std::size_t const next_first = band_start_[band + 1];
+  std::size_t const next_last = band_start_[band + 2];
+  std::size_t m = next_first;
+  for (std::size_t k = first; k < last; ++k) {
+    swept_box const& a = boxes_[k];
+    while (m < next_last && boxes_[m].min[axis_] < a.min[axis_]) {
+      ++m;
+    }
+    for (std::size_t n = m; n < next_last && boxes_[n].min[axis_] <= a.max[axis_]; ++n) {
+      test(a, boxes_[n]);
+    }
+  }
+  std::size_t k = first;
+  for (std::size_t n = next_first; n < next_last; ++n) {
+    swept_box const& b = boxes_[n];
+    while (k < last && boxes_[k].min[axis_] <= b.min[axis_]) {
+      ++k;
+    }
+    for (std::size_t j = k; j < last && boxes_[j].min[axis_] <= b.max[axis_]; ++j) {
+      test(boxes_[j], b);
+    }
+  }
+}
+
+bool detector::narrow_phase(culling::sphere_batch const& spheres, std::uint32_t a, std::uint32_t b, contact& result) const {
+  // offset of b from a at both ends of the step, the closest approach is the closest point of that segment to zero
+  glm::fvec3 start = previous_[b] - previous_[a];
+  glm::fvec3 end{spheres.x[b] - spheres.x[a], spheres.y[b] - spheres.y[a], spheres.z[b] - spheres.z[a]};
+  glm::fvec3 motion = end - start;
+  float motion_squared = glm::dot(motion, motion);
+  float time = motion_squared > 0.0f ? glm::clamp(-glm::dot(start, motion) / motion_squared, 0.0f, 1.0f) : 1.0f;
+  float distance = glm::length(start + time * motion) - spheres.radius[a] - spheres.radius[b];
+  if (distance > params_.margin) {
+    return false;
+  }
+  result.first = std::min(a, b);
+  result.second = std::max(a, b);
+  result.distance = distance;
+  result.time = time;
+  return true;
+}
+
+}
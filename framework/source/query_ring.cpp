@@ -0,0 +1,51 @@
+#include "query_ring.hpp"
+
+#include <glbinding/gl/functions.h>
+#include <glbinding/gl/enum.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+query_ring::query_ring(GLenum target, std::size_t size)
+ :target_{target}
+ ,queries_(size, 0)
+ ,first_{0}
+ ,count_{0}
+{}
+
+query_ring::~query_ring() {
+  if (queries_.front() != 0) {
+    glDeleteQueries(GLsizei(queries_.size()), queries_.data());
+  }
+}
+
+bool query_ring::begin() {
+  if (count_ == queries_.size()) {
+    return false;
+  }
+  // queries are created on first use, so no context is needed on construction
+  if (queries_.front() == 0) {
+    glGenQueries(GLsizei(queries_.size()), queries_.data());
+  }
+  glBeginQuery(target_, queries_[(first_ + count_) % queries_.size()]);
+  ++count_;
+  return true;
+}
+
+void query_ring::end() {
+  glEndQuery(target_);
+}
+
+bool query_ring::poll(GLuint64& result) {
+  if (count_ == 0) {
+    return false;
+  }
+  GLuint available = 0;
+  glGetQueryObjectuiv(queries_[first_], GL_QUERY_RESULT_AVAILABLE, &available);
+  if (!available) {
+    return false;
+  }
+  glGetQueryObjectui64v(queries_[first_], GL_QUERY_RESULT, &result);
+  first_ = (first_ + 1) % queries_.size();
+  --count_;
+  return true;
+}
@@ -0,0 +1,66 @@
+#include "scene_generator.hpp"
+
+#include "GeometryNode.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace scene_generator {
+
+void add_planets(Node& root, std::shared_ptr<Node> const& root_p, std::shared_ptr<Node> const& sun_p,
+                 model const& planet_model, std::string const& texture_path, std::size_t planets,
+                 unsigned moons_per_planet, unsigned seed) {
+  // maps of the solar system planets, the generated ones cycle through them
+  std::vector<std::string> const maps{"mercurymap", "venusmap", "earthmap", "marsmap", "jupitermap", "saturnmap",
+                                      "uranusmap", "neptunmap"};
+  std::mt19937 random{seed};
+  std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+
+  // the planets share the space between mercury and neptune, so more of them get smaller
+  float const size = std::sqrt(std::min(1.0f, 8.0f / float(planets)));
+
+  for (std::size_t i = 0; i < planets; ++i) {
+    std::string name = "planet" + std::to_string(i);
+    auto holder_p = std::make_shared<Node>(root_p, name + "_h", "root/" + name + "_h", 1, sun_p);
+
+    // textures are loaded once per file with the texture arrays, not with every node
+    auto planet_p = std::make_shared<GeometryNode>(holder_p, name, "root/" + name + "_h/" + name, 2, sun_p);
+    std::string const& map = maps[i % maps.size()];
+    planet_p->setTexPath(texture_path + map + ".png");
+    if (map == "earthmap" || map == "marsmap") {
+      planet_p->setNormalTexPath(texture_path + map.substr(0, map.size() - 3) + "normal.png");
+      planet_p->setHasNormalMapping(true);
+    }
+    planet_p->setSpeed(0.05f + 0.25f * unit(random));
+    planet_p->setDistanceOrigin(glm::fvec3{8.0f + 31.0f * unit(random), 0.0f, 0.0f});
+    planet_p->setRadius(size * (0.4f + 0.8f * unit(random)));
+    planet_p->setSelfRotation(0.4f + 0.4f * unit(random));
+    planet_p->setGeometry(planet_model);
+    planet_p->setColor(glm::fvec3{unit(random), unit(random), unit(random)});
+
+    root.addChildren(holder_p);
+    holder_p->addChildren(planet_p);
+
+    for (unsigned m = 0; m < moons_per_planet; ++m) {
+      std::string moon_name = name + "_moon" + std::to_string(m);
+      auto moon_holder_p = std::make_shared<Node>(holder_p, moon_name + "_h", "root/" + name + "_h/" + moon_name + "_h",
+                                                  3, planet_p);
+      auto moon_p = std::make_shared<GeometryNode>(moon_holder_p, moon_name,
+                                                   "root/" + name + "_h/" + moon_name + "_h/" + moon_name, 4, planet_p);
+      moon_p->setTexPath(texture_path + "moonmap.png");
+      moon_p->setSpeed(0.3f + 0.3f * unit(random));
+      moon_p->setDistanceOrigin(glm::fvec3{planet_p->getRadius() * (2.0f + 1.5f * float(m)), 0.0f, 0.0f});
+      moon_p->setRadius(planet_p->getRadius() * (0.15f + 0.15f * unit(random)));
+      moon_p->setSelfRotation(0.4f);
+      moon_p->setGeometry(planet_model);
+      moon_p->setColor(glm::fvec3{0.956f, 0.956f, 0.956f});
+
+      holder_p->addChildren(moon_holder_p);
+      moon_holder_p->addChildren(moon_p);
+    }
+  }
+}
+
+}
@@ -10,7 +10,10 @@
 // create implementation here
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
+
+#include "trace.hpp"
  
+#include <algorithm>
 #include <cstdint> 
 #include <cstring> 
 #include <stdexcept> 
@@ -18,6 +21,7 @@
 namespace texture_loader {
     
     pixel_data file(std::string const& file_name) {
+        TRACE_ZONE_DETAIL("decode texture", file_name);
         // match to opengl representation
         stbi_set_flip_vertically_on_load(true);
 
@@ -62,4 +66,86 @@ namespace texture_loader {
         return pixel_data{texture_data, pixel_format, GL_UNSIGNED_BYTE, std::size_t(width), std::size_t(height)};
     }
 
+    pixel_data resize(pixel_data const& image, std::size_t width, std::size_t height) {
+        if (image.channel_type != GL_UNSIGNED_BYTE) {
+            throw std::logic_error("texture_loader: only 8 bit images can be resized");
+        }
+        if (image.width == width && image.height == height) {
+            return image;
+        }
+
+        std::size_t num_components = image.pixels.size() / (image.width * image.height);
+        std::vector<uint8_t> texture_data(width * height * num_components);
+
+        for (std::size_t y = 0; y < height; ++y) {
+            // sample at pixel centers
+            float src_y = std::max(0.0f, (float(y) + 0.5f) * float(image.height) / float(height) - 0.5f);
+            std::size_t y0 = std::min(std::size_t(src_y), image.height - 1);
+            std::size_t y1 = std::min(y0 + 1, image.height - 1);
+            float fy = src_y - float(y0);
+
+            for (std::size_t x = 0; x < width; ++x) {
+                float src_x = std::max(0.0f, (float(x) + 0.5f) * float(image.width) / float(width) - 0.5f);
+                std::size_t x0 = std::min(std::size_t(src_x), image.width - 1);
+                std::size_t x1 = std::min(x0 + 1, image.width - 1);
+                float fx = src_x - float(x0);
+
+                for (std::size_t c = 0; c < num_components; ++c) {
+                    float top = float(image.pixels[(y0 * image.width + x0) * num_components + c]) * (1.0f - fx)
+                              + float(image.pixels[(y0 * image.width + x1) * num_components + c]) * fx;
+                    float bottom = float(image.pixels[(y1 * image.width + x0) * num_components + c]) * (1.0f - fx)
+                                 + float(image.pixels[(y1 * image.width + x1) * num_components + c]) * fx;
+                    texture_data[(y * width + x) * num_components + c] = uint8_t(top * (1.0f - fy) + bottom * fy + 0.5f);
+                }
+            }
+        }
+
+        return pixel_data{texture_data, image.channels, image.channel_type, width, height};
+    }
+
+    static std::size_t component_count(GLenum channels) {
+        if (channels == GL_RED) {
+            return 1;
+        }
+        else if (channels == GL_RG) {
+            return 2;
+        }
+        else if (channels == GL_RGB) {
+            return 3;
+        }
+        else if (channels == GL_RGBA) {
+            return 4;
+        }
+        throw std::logic_error("texture_loader: only red, rg, rgb and rgba images can be converted");
+    }
+
+    pixel_data convert(pixel_data const& image, GLenum channels) {
+        if (image.channels == channels) {
+            return image;
+        }
+        if (image.channel_type != GL_UNSIGNED_BYTE) {
+            throw std::logic_error("texture_loader: only 8 bit images can be converted");
+        }
+
+        std::size_t source_components = component_count(image.channels);
+        std::size_t target_components = component_count(channels);
+        std::size_t pixel_count = image.width * image.height;
+        std::vector<uint8_t> texture_data(pixel_count * target_components);
+
+        for (std::size_t i = 0; i < pixel_count; ++i) {
+            uint8_t const* source = &image.pixels[i * source_components];
+            // grey images have one color channel, the second one of GL_RG is their alpha
+            bool grey = source_components < 3;
+            uint8_t rgba[4] = {source[0], grey ? source[0] : source[1], grey ? source[0] : source[2],
+                               source_components % 2 == 0 ? source[source_components - 1] : uint8_t(255)};
+            // a grey target keeps its alpha in the second channel
+            if (target_components == 2) {
+                rgba[1] = rgba[3];
+            }
+            std::copy(rgba, rgba + target_components, &texture_data[i * target_components]);
+        }
+
+        return pixel_data{texture_data, channels, image.channel_type, image.width, image.height};
+    }
+
 }
\ No newline at end of file
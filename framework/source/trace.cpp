@@ -0,0 +1,273 @@
+#include "trace.hpp"
+
+// time stamp counter of the cpu, much cheaper to read than the steady clock
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define TRACE_TSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TRACE_TSC
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace trace {
+
+enum class kind : std::uint8_t {zone, counter, frame};
+
+// zones store their duration, counters and frames their value
+struct event {
+  char const* name;
+  std::uint64_t start;
+  std::uint64_t duration;
+  double value;
+  std::uint32_t detail;
+  kind type;
+};
+
+// events of one thread, only written by the thread that holds it
+struct thread_buffer {
+  std::vector<event> events;
+  // details of the zones one after another, each ended by a zero, zones store the offset of theirs
+  std::string details;
+  std::string name;
+  // tid in the trace, threads that ended hand their buffer and lane to the next new thread
+  std::size_t lane;
+  bool in_use;
+};
+
+static std::uint32_t const no_detail = std::uint32_t(-1);
+// events and detail characters a new buffer has room for before it grows
+static std::size_t const reserved_events = 16384;
+static std::size_t const reserved_details = 65536;
+
+static std::atomic<bool> active{false};
+static std::mutex buffers_mutex{};
+static std::vector<std::unique_ptr<thread_buffer>> buffers{};
+static std::string output_path{};
+static std::uint64_t start_ticks = 0;
+static std::chrono::steady_clock::time_point start_time{};
+static std::uint64_t frame_count = 0;
+
+static inline std::uint64_t ticks() {
+#ifdef TRACE_TSC
+  return __rdtsc();
+#else
+  return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// returns the buffer when its thread ends, so the short lived workers of the parallel loops share lanes
+struct buffer_owner {
+  thread_buffer* buffer = nullptr;
+  ~buffer_owner() {
+    if (buffer) {
+      std::lock_guard<std::mutex> lock{buffers_mutex};
+      buffer->name.clear();
+      buffer->in_use = false;
+    }
+  }
+};
+
+static thread_local buffer_owner owner{};
+// trivial, so reading it needs no check whether the thread local was constructed
+static thread_local thread_buffer* local = nullptr;
+
+static thread_buffer& acquire_buffer() {
+  {
+    std::lock_guard<std::mutex> lock{buffers_mutex};
+    for (auto const& buffer : buffers) {
+      if (!buffer->in_use) {
+        buffer->in_use = true;
+        local = buffer.get();
+        break;
+      }
+    }
+  }
+  if (!local) {
+    // allocated outside the lock, so other threads only wait for the list to take it
+    std::unique_ptr<thread_buffer> buffer{new thread_buffer{}};
+    buffer->events.reserve(reserved_events);
+    buffer->details.reserve(reserved_details);
+    buffer->in_use = true;
+    local = buffer.get();
+    std::lock_guard<std::mutex> lock{buffers_mutex};
+    buffers.push_back(std::move(buffer));
+    local->lane = buffers.size();
+  }
+  owner.buffer = local;
+  return *local;
+}
+
+static inline thread_buffer& local_buffer() {
+  return local ? *local : acquire_buffer();
+}
+
+static std::string json_string(std::string const& text) {
+  std::string quoted{"\""};
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+    }
+    // control characters are not valid in json strings
+    quoted += (static_cast<unsigned char>(c) < 0x20) ? ' ' : c;
+  }
+  return quoted + "\"";
+}
+
+std::string read_options(int& argc, char* argv[]) {
+  std::string file_path{};
+  int kept = 1;
+  for (int i = 1; i < argc; ++i) {
+    std::string argument{argv[i]};
+    if (argument == "--trace") {
+      if (i + 1 >= argc) {
+        throw std::logic_error("trace: --trace needs the file to write");
+      }
+      file_path = argv[++i];
+    }
+    else {
+      argv[kept++] = argv[i];
+    }
+  }
+  argc = kept;
+  return file_path;
+}
+
+void start(std::string const& file_path) {
+  std::lock_guard<std::mutex> lock{buffers_mutex};
+#ifndef TRACING
+  // once per process, tools restart the recording many times
+  static bool warned = false;
+  if (!warned) {
+    std::cerr << "trace: built without ENABLE_TRACING, the trace macros record nothing" << std::endl;
+    warned = true;
+  }
+#endif
+  for (auto const& buffer : buffers) {
+    buffer->events.clear();
+    buffer->details.clear();
+  }
+  output_path = file_path;
+  frame_count = 0;
+  start_time = std::chrono::steady_clock::now();
+  start_ticks = ticks();
+  active.store(true);
+}
+
+void stop() {
+  if (!active.exchange(false)) {
+    return;
+  }
+  // ticks per microsecond over the whole recording
+  std::uint64_t stop_ticks = ticks();
+  double elapsed_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start_time).count();
+  double ticks_per_us = double(stop_ticks - start_ticks) / std::max(elapsed_us, 1.0);
+
+  std::ofstream file(output_path);
+  if (!file) {
+    throw std::logic_error("trace: cannot write " + output_path);
+  }
+  file << std::fixed << std::setprecision(3);
+  file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+  file << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"application\"}}";
+
+  std::size_t written = 0;
+  std::lock_guard<std::mutex> lock{buffers_mutex};
+  for (auto const& buffer : buffers) {
+    std::string name = buffer->name.empty() ? "worker " + std::to_string(buffer->lane) : buffer->name;
+    file << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->lane
+         << ", \"args\": {\"name\": " << json_string(name) << "}}";
+
+    for (auto const& recorded : buffer->events) {
+      // events of zones that started before the recording are clipped to its start
+      double ts = double(recorded.start - std::min(recorded.start, start_ticks)) / ticks_per_us;
+      file << ",\n{\"name\": " << json_string(recorded.name) << ", \"pid\": 1, \"tid\": " << buffer->lane
+           << ", \"ts\": " << ts;
+      if (recorded.type == kind::zone) {
+        file << ", \"ph\": \"X\", \"dur\": " << double(recorded.duration) / ticks_per_us;
+        if (recorded.detail < buffer->details.size()) {
+          file << ", \"args\": {\"detail\": " << json_string(buffer->details.c_str() + recorded.detail) << "}";
+        }
+      }
+      else if (recorded.type == kind::counter) {
+        file << ", \"ph\": \"C\", \"args\": {\"value\": " << recorded.value << "}";
+      }
+      else {
+        file << ", \"ph\": \"i\", \"s\": \"g\", \"args\": {\"frame\": " << std::uint64_t(recorded.value) << "}";
+      }
+      file << "}";
+      ++written;
+    }
+    buffer->events.clear();
+    buffer->details.clear();
+  }
+  file << "\n]}\n";
+  std::cout << "Trace: " << written << " events written to " << output_path << std::endl;
+}
+
+bool recording() {
+  return active.load(std::memory_order_relaxed);
+}
+
+void thread_name(char const* name) {
+  local_buffer().name = name;
+}
+
+void counter(char const* name, double value) {
+  if (!active.load(std::memory_order_relaxed)) {
+    return;
+  }
+  local_buffer().events.push_back(event{name, ticks(), 0, value, no_detail, kind::counter});
+}
+
+void frame_marker() {
+  if (!active.load(std::memory_order_relaxed)) {
+    return;
+  }
+  local_buffer().events.push_back(event{"frame", ticks(), 0, double(frame_count++), no_detail, kind::frame});
+}
+
+zone::zone(char const* name)
+ :name_{name}
+ ,start_{0}
+ ,detail_{no_detail}
+ ,active_{active.load(std::memory_order_relaxed)}
+{
+  if (active_) {
+    start_ = ticks();
+  }
+}
+
+zone::zone(char const* name, std::string const& detail)
+ :name_{name}
+ ,start_{0}
+ ,detail_{no_detail}
+ ,active_{active.load(std::memory_order_relaxed)}
+{
+  if (active_) {
+    thread_buffer& buffer = local_buffer();
+    detail_ = std::uint32_t(buffer.details.size());
+    buffer.details.append(detail).push_back('\0');
+    start_ = ticks();
+  }
+}
+
+zone::~zone() {
+  if (active_) {
+    std::uint64_t end = ticks();
+    local_buffer().events.push_back(event{name_, start_, end - start_, 0.0, detail_, kind::zone});
+  }
+}
+
+}
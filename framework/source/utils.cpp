@@ -2,14 +2,18 @@
 
 #include "pixel_data.hpp"
 #include "structs.hpp"
+#include "texture_loader.hpp"
 
 #include <glbinding/gl/functions.h>
+#include <glbinding/ContextInfo.h>
+#include <glbinding/Version.h>
 // use gl definitions from glbinding 
 using namespace gl;
 
 #include <glm/gtc/type_precision.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <fstream>
@@ -24,6 +28,49 @@ texture_object create_texture_object(pixel_data const& tex) {
   return t_obj;
 }
 
+texture_object create_texture_array(std::vector<pixel_data> const& layers) {
+  if (layers.empty()) {
+    throw std::logic_error("Texture array needs at least one layer");
+  }
+  pixel_data const& first = layers.front();
+
+  // all layers share one format, the one with the color and alpha channels any of them has
+  bool color = false;
+  bool alpha = false;
+  for (auto const& layer : layers) {
+    color = color || layer.channels == GL_RGB || layer.channels == GL_RGBA;
+    alpha = alpha || layer.channels == GL_RG || layer.channels == GL_RGBA;
+  }
+  GLenum channels = color ? (alpha ? GL_RGBA : GL_RGB) : (alpha ? GL_RG : GL_RED);
+
+  texture_object t_obj{};
+  t_obj.target = GL_TEXTURE_2D_ARRAY;
+  glGenTextures(1, &t_obj.handle);
+  glBindTexture(t_obj.target, t_obj.handle);
+
+  glTexParameteri(t_obj.target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(t_obj.target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+  // allocate all layers, then fill them one by one
+  glTexImage3D(t_obj.target, 0, channels, GLsizei(first.width), GLsizei(first.height), GLsizei(layers.size()),
+               0, channels, first.channel_type, nullptr);
+  for (std::size_t i = 0; i < layers.size(); ++i) {
+    if (layers[i].width != first.width || layers[i].height != first.height) {
+      throw std::logic_error("Texture array layer " + std::to_string(i) + " differs in size");
+    }
+    // layers in the common format are uploaded without a copy
+    pixel_data converted{};
+    if (layers[i].channels != channels) {
+      converted = texture_loader::convert(layers[i], channels);
+    }
+    pixel_data const& layer = layers[i].channels == channels ? layers[i] : converted;
+    glTexSubImage3D(t_obj.target, 0, 0, 0, GLint(i), GLsizei(layer.width), GLsizei(layer.height), 1,
+                    layer.channels, layer.channel_type, layer.ptr());
+  }
+
+  return t_obj;
+}
+
 void print_bound_textures() {
   GLint id1, id2, id3, active_unit, texture_units = 0;
   glGetIntegerv(GL_ACTIVE_TEXTURE, &active_unit);
@@ -146,4 +193,26 @@ glm::fmat4 calculate_projection_matrix(float aspect) {
   return glm::perspective(fov_y, aspect, 0.1f, 100.0f);
 }
 
+bool supports(unsigned major, unsigned minor, GLextension extension) {
+  if (glbinding::ContextInfo::version() >= glbinding::Version(static_cast<unsigned char>(major), static_cast<unsigned char>(minor))) {
+    return true;
+  }
+  // core functionality may be exposed as extension in older contexts
+  return glbinding::ContextInfo::supported({extension});
 }
+
+double percentile(std::vector<double> const& sorted, double fraction) {
+  if (sorted.empty()) {
+    return 0.0;
+  }
+  double position = fraction * double(sorted.size() - 1);
+  std::size_t lower = std::size_t(position);
+  std::size_t upper = std::min(lower + 1, sorted.size() - 1);
+  return sorted[lower] + (sorted[upper] - sorted[lower]) * (position - double(lower));
+}
+
+double milliseconds(std::chrono::steady_clock::duration const& duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+}
\ No newline at end of file
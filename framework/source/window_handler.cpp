@@ -3,8 +3,6 @@
 #include <glbinding/gl/gl.h>
 // load glbinding extensions
 #include <glbinding/Binding.h>
-// load meta info extension
-#include <glbinding/Meta.h>
 
 //dont load gl bindings from glfw
 #define GLFW_INCLUDE_NONE
@@ -14,13 +12,16 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "application.hpp"
+#include "gl_validation.hpp"
 
 #include "utils.hpp"
 #include "shader_loader.hpp"
 
 #include <cstdlib>
 #include <functional>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 
 #include <glbinding/Version.h>
 // use gl definitions from glbinding 
@@ -28,16 +29,6 @@ using namespace gl;
 
 // helper functions
 static void glsl_error(int error, const char* description);
-static void watch_gl_errors(bool activate = true);
-static void APIENTRY openglCallbackFunction(
-  GLenum source,
-  GLenum type,
-  GLuint id,
-  GLenum severity,
-  GLsizei length,
-  const GLchar* message,
-  const void* userParam
-);
 
 namespace window_handler {
 
@@ -55,7 +46,7 @@ bool isCore()
     return (value & static_cast<unsigned int>(GL_CONTEXT_CORE_PROFILE_BIT)) > 0;
 }
 
-GLFWwindow* initialize(glm::uvec2 const& resolution, unsigned ver_major, unsigned ver_minor) {
+GLFWwindow* initialize(glm::uvec2 const& resolution, unsigned ver_major, unsigned ver_minor, gl_validation::options const& validation) {
 
   glfwSetErrorCallback(glsl_error);
 
@@ -66,8 +57,8 @@ GLFWwindow* initialize(glm::uvec2 const& resolution, unsigned ver_major, unsigne
   // set OGL version explicitly 
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, ver_major);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, ver_minor);
-  // enable deug support
-  glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, true);
+  // enable debug support only for the validation levels reading the debug output
+  glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, gl_validation::needs_debug_context(validation.mode));
 
   //MacOS requires forward compat core profile
   #ifdef __APPLE__
@@ -90,8 +81,7 @@ GLFWwindow* initialize(glm::uvec2 const& resolution, unsigned ver_major, unsigne
 
   // use the windows context
   glfwMakeContextCurrent(window);
-  // disable vsync
-  glfwSwapInterval(0);
+  // the swap interval is set by the frame pacer
   // initialize glindings in this context
   glbinding::Binding::initialize();
 
@@ -107,18 +97,12 @@ GLFWwindow* initialize(glm::uvec2 const& resolution, unsigned ver_major, unsigne
   std::cout << "Zoom in: i \nZoom out: o \nMove Camera up: w \nMove Camera down: s \n"
   << "Move Camera left: a \nMove Camera right: d\n" 
   << "Default Shading: 1 \nCel Shading: 2 \nNormal Mapping: 3 \nGreyscales: 7 \n"
-  << "Horizontal Mirroring: 8 \nVertical Mirroring: 9 \nGaussian Blur: 0" << std::endl;
+  << "Horizontal Mirroring: 8 \nVertical Mirroring: 9 \nGaussian Blur: 0 \n"
+  << "Pick planet in the screen center: left mouse button \nGPU Picking: 4 \nOcclusion Culling Mode: 5 \nDraw Order: 6 \nImpostor Threshold: [ and ] \nAsteroid Belt Size: b \nN-Body Gravity: g \nGPU Gravity Cloud: c \nOrbit Table: t \nPass Profile Overlay: p \nWrite Pass Profile: f" << std::endl;
 
-  // activate error checking after each gl function call
-  watch_gl_errors();
-
-  // Enable the debug callback
-  glEnable(GL_DEBUG_OUTPUT);
-  glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
-  glDebugMessageCallback(openglCallbackFunction, nullptr);
-  glDebugMessageControl(
-    GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, true
-  );
+  // check the gl calls as far as the validation level asks for
+  gl_validation::enable(validation);
+  std::cout << "\nOpenGL validation: " << gl_validation::name(validation.mode) << std::endl;
 
   return window;
 }
@@ -138,6 +122,11 @@ void set_callback_object(GLFWwindow* window, Application* app) {
         static_cast<Application*>(glfwGetWindowUserPointer(w))->mouse_callback(w, a, b);
   };
   glfwSetCursorPosCallback(window, mouse_func);
+  // register mouse button function
+  auto button_func = [](GLFWwindow* w, int a, int b, int c) {
+        static_cast<Application*>(glfwGetWindowUserPointer(w))->mouse_button_callback(w, a, b, c);
+  };
+  glfwSetMouseButtonCallback(window, button_func);
 
 
   // allow free mouse movement
@@ -149,22 +138,12 @@ void set_callback_object(GLFWwindow* window, Application* app) {
 }
 
 
-// calculate fps and show in m_window title
-void show_fps(GLFWwindow* window) {
-    // variables for fps computation
-  static double m_last_second_time;
-  static unsigned m_frames_per_second;
-
-  ++m_frames_per_second;
-  double current_time = glfwGetTime();
-  if (current_time - m_last_second_time >= 1.0) {
-    std::string title{"OpenGL Framework - "};
-    title += std::to_string(m_frames_per_second) + " fps";
-
-    glfwSetWindowTitle(window, title.c_str());
-    m_frames_per_second = 0;
-    m_last_second_time = current_time;
-  }
+// show frame times in m_window title
+void show_frame_stats(GLFWwindow* window, frame_stats::summary const& stats) {
+  std::ostringstream title{};
+  title << std::fixed << std::setprecision(1) << "OpenGL Framework - " << stats.present.p50 << " ms p50, "
+        << stats.present.p99 << " ms p99, " << stats.hitches << " hitches";
+  glfwSetWindowTitle(window, title.str().c_str());
 }
 
 void close_and_quit(GLFWwindow* window, int status) {
@@ -181,60 +160,3 @@ void close_and_quit(GLFWwindow* window, int status) {
 static void glsl_error(int error, const char* description) {
   std::cerr << "GLSL Error " << error << " : "<< description << std::endl;
 }
-
-static void APIENTRY openglCallbackFunction(
-  GLenum source,
-  GLenum type,
-  GLuint id,
-  GLenum severity,
-  GLsizei length,
-  const GLchar* message,
-  const void* userParam
-){
-  (void)source; (void)type; (void)id; 
-  (void)severity; (void)length; (void)userParam;
-  if (severity == GL_DEBUG_SEVERITY_NOTIFICATION || type == GL_DEBUG_TYPE_PERFORMANCE) {
-    return;
-  }
-  std::cerr << glbinding::Meta::getString(severity) << " - " << glbinding::Meta::getString(type) << ": ";
-  std::cerr << message << std::endl;
-  // if (severity != GL_DEBUG_SEVERITY_NOTIFICATION && type != GL_DEBUG_TYPE_PERFORMANCE) {
-  //   throw std::runtime_error{"OpenGL error"};
-  // }
-}
-
-static void watch_gl_errors(bool activate) {
-  if(activate) {
-    // add callback after each function call
-    glbinding::setCallbackMaskExcept(glbinding::CallbackMask::After | glbinding::CallbackMask::ParametersAndReturnValue, {"glGetError", "glBegin", "glVertex3f", "glColor3f"});
-    glbinding::setAfterCallback(
-      [](glbinding::FunctionCall const& call) {
-        GLenum error = glGetError();
-        if (error != GL_NO_ERROR) {
-          // print name
-          std::cerr <<  "OpenGL Error: " << call.function->name() << "(";
-          // parameters
-          for (unsigned i = 0; i < call.parameters.size(); ++i)
-          {
-            std::cerr << call.parameters[i]->asString();
-            if (i < call.parameters.size() - 1)
-              std::cerr << ", ";
-          }
-          std::cerr << ")";
-          // return value
-          if(call.returnValue) {
-            std::cerr << " -> " << call.returnValue->asString();
-          }
-          // error
-          std::cerr  << " - " << glbinding::Meta::getString(error) << std::endl;
-          // throw exception to allow for backtrace
-          throw std::runtime_error("OpenGl error: " + std::string(call.function->name()));
-          exit(EXIT_FAILURE);
-        }
-      }
-    );
-  }
-  else {
-    glbinding::setCallbackMask(glbinding::CallbackMask::None);
-  }
-}
@@ -0,0 +1,33 @@
+#version 150
+#extension GL_ARB_explicit_attrib_location : require
+
+//diffuse lit rock, the sun is the only light
+in vec3 pass_Normal; //world space
+in vec3 fragment_pos; //world space
+in vec2 tex_coords;
+flat in float texture_layer;
+
+uniform vec3 LightColor;
+uniform float LightIntensity;
+uniform sampler2DArray RockTextures;
+
+vec3 pointlight_pos = vec3(0.0);
+
+//output
+layout(location = 0) out vec4 out_Color;
+
+void main() {
+
+    vec3 tex_color = texture(RockTextures, vec3(tex_coords, texture_layer)).rgb;
+
+    vec3 n = normalize(pass_Normal);
+    vec3 l = pointlight_pos - fragment_pos;
+    float distance_ = length(l);
+    l = l / distance_;
+
+    //same falloff as the planets, rocks only reflect diffuse
+    vec3 beta = (LightColor * LightIntensity) / (3.14159265359 * pow(distance_, 2));
+    float lambertian = max(dot(l, n), 0.0);
+    vec3 color = 0.3 * tex_color + beta * lambertian * tex_color * (18.0 / 3.14159265359);
+    out_Color = vec4(color, 1.0);
+}
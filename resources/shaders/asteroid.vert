@@ -0,0 +1,42 @@
+#version 150
+#extension GL_ARB_explicit_attrib_location : require
+//one rock mesh drawn once per asteroid, the belt is propagated on the cpu
+// vertex attributes of VAO
+layout(location = 0) in vec3 in_Position;
+layout(location = 1) in vec3 in_Normal;
+layout(location = 2) in vec2 in_TexCoords;
+// per asteroid attributes from the belt instance buffer
+layout(location = 10) in vec3 in_AsteroidPosition;
+layout(location = 11) in uint in_AsteroidPacked; // bits 0-15 size, 16-23 spin, 24-31 texture layer
+
+//Matrix Uniforms as specified with glUniformMatrix4fv
+uniform mat4 ViewMatrix;
+uniform mat4 ProjectionMatrix;
+uniform float MaxSize;
+uniform float Time;
+
+//those get passed to fragment shader
+out vec3 pass_Normal;
+out vec3 fragment_pos;
+out vec2 tex_coords;
+flat out float texture_layer;
+
+void main(void)
+{
+	float size = float(in_AsteroidPacked & 0xffffu) / 65535.0 * MaxSize;
+	float spin = float((in_AsteroidPacked >> 16) & 0xffu) / 255.0;
+	texture_layer = float(in_AsteroidPacked >> 24);
+
+	//tumble around an axis chosen by the spin bits, faster for larger values
+	vec3 axis = normalize(vec3(spin - 0.5, 0.5, fract(spin * 7.0) - 0.5));
+	float angle = Time * (0.2 + spin);
+	float c = cos(angle);
+	float s = sin(angle);
+	mat3 rotation = mat3(c) + (1.0 - c) * outerProduct(axis, axis)
+	              + s * mat3(0.0, axis.z, -axis.y,  -axis.z, 0.0, axis.x,  axis.y, -axis.x, 0.0);
+
+	fragment_pos = in_AsteroidPosition + rotation * (in_Position * size);
+	gl_Position = ProjectionMatrix * ViewMatrix * vec4(fragment_pos, 1.0);
+	pass_Normal = rotation * in_Normal;
+	tex_coords = in_TexCoords;
+}
@@ -0,0 +1,51 @@
+#version 150
+#extension GL_ARB_explicit_attrib_location : require
+#include "planet_shading.glsl"
+
+//ray casts the sphere of a distant planet on its impostor quad and shades it like planet.frag,
+//so switching between mesh and impostor is not visible
+in vec3 view_position; //point on the quad in camera space
+flat in vec3 sphere_center; //camera space
+flat in float sphere_radius;
+flat in vec3 light_pos; //camera space
+flat in mat3 normal_matrix; //object to camera space
+flat in vec4 draw_info; //x texture layer, y normal texture layer, z has normal map, w planet id
+
+uniform mat4 ProjectionMatrix;
+
+//output
+layout(location = 0) out vec4 out_Color;
+//id for picking, only stored if the second attachment is enabled
+layout(location = 1) out uint out_Id;
+
+void main() {
+
+    //ray from the camera at the origin through the quad, nearest intersection with the sphere
+    float a = dot(view_position, view_position);
+    float b = dot(view_position, sphere_center);
+    float c = dot(sphere_center, sphere_center) - sphere_radius * sphere_radius;
+    float discriminant = b * b - a * c;
+    if(discriminant < 0.0){
+        discard;
+    }
+    float t = (b - sqrt(discriminant)) / a;
+    vec3 camera_pos = view_position * t;
+
+    //depth of the sphere surface instead of the quad
+    vec4 clip_pos = ProjectionMatrix * vec4(camera_pos, 1.0);
+    gl_FragDepth = 0.5 * clip_pos.z / clip_pos.w + 0.5;
+
+    //same equirectangular mapping and tangent frame as the icosphere mesh
+    vec3 object_normal = normalize(transpose(normal_matrix) * (camera_pos - sphere_center));
+    vec2 texCoords = vec2(0.5 - atan(object_normal.z, object_normal.x) / 6.28318530718,
+                          0.5 + asin(clamp(object_normal.y, -1.0, 1.0)) / 3.14159265359);
+    float longitude = (0.5 - texCoords.x) * 6.28318530718;
+    vec3 object_tangent = vec3(sin(longitude), 0.0, -cos(longitude));
+    vec3 normal = normal_matrix * object_normal;
+    vec3 tangent = normal_matrix * object_tangent;
+    vec3 bitangent = normal_matrix * cross(object_normal, object_tangent);
+
+    vec3 color = shade_planet(normal, tangent, bitangent, texCoords, draw_info, camera_pos, light_pos);
+    out_Color = vec4(color, 1.0);
+    out_Id = uint(draw_info.w);
+}
@@ -0,0 +1,44 @@
+#version 150
+#extension GL_ARB_explicit_attrib_location : require
+//camera facing quad around a distant planet, the sphere itself is ray cast in the fragment shader
+// vertex attributes of VAO, corners of the quad in [-1, 1]
+layout(location = 0) in vec3 in_Position;
+// per planet attributes from the draw record buffer, same records as the mesh path
+layout(location = 5) in mat4 in_ModelMatrix;
+layout(location = 9) in vec4 in_DrawInfo; // x texture layer, y normal texture layer, z has normal map, w planet id
+
+//Matrix Uniforms as specified with glUniformMatrix4fv
+uniform mat4 ViewMatrix;
+uniform mat4 ProjectionMatrix;
+
+//those get passed to fragment shader
+out vec3 view_position; //point on the quad in camera space, the ray from the camera goes through it
+flat out vec3 sphere_center; //camera space
+flat out float sphere_radius;
+flat out vec3 light_pos; //camera space
+flat out mat3 normal_matrix; //object to camera space, rotation and uniform scale
+flat out vec4 draw_info;
+
+void main(void)
+{
+	mat4 model_view = ViewMatrix * in_ModelMatrix;
+	sphere_center = model_view[3].xyz;
+	//planets are only scaled uniformly
+	sphere_radius = length(in_ModelMatrix[0].xyz);
+
+	float distance_ = length(sphere_center);
+	vec3 forward = sphere_center / distance_;
+	vec3 up = abs(forward.y) > 0.99 ? vec3(1.0, 0.0, 0.0) : vec3(0.0, 1.0, 0.0);
+	vec3 right = normalize(cross(forward, up));
+	up = cross(right, forward);
+
+	//the rays touching the sphere cut the plane through its center in a circle of this radius
+	float extent = sphere_radius * distance_ / sqrt(max(distance_ * distance_ - sphere_radius * sphere_radius, 1e-6));
+	view_position = sphere_center + (right * in_Position.x + up * in_Position.y) * extent;
+	gl_Position = ProjectionMatrix * vec4(view_position, 1.0);
+
+	//the sun is at the world origin
+	light_pos = ViewMatrix[3].xyz;
+	normal_matrix = mat3(model_view);
+	draw_info = in_DrawInfo;
+}
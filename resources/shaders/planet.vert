@@ -5,29 +5,41 @@
 layout(location = 0) in vec3 in_Position;
 layout(location = 1) in vec3 in_Normal;
 layout(location = 2) in vec2 in_TexCoords;
+layout(location = 3) in vec3 in_Tangent;
+layout(location = 4) in vec3 in_Bitangent;
+// per planet attributes from the draw record buffer, one record per draw
+layout(location = 5) in mat4 in_ModelMatrix;
+layout(location = 9) in vec4 in_DrawInfo; // x texture layer, y normal texture layer, z has normal map, w planet id
 
 //Matrix Uniforms as specified with glUniformMatrix4fv
-uniform mat4 ModelMatrix;
 uniform mat4 ViewMatrix;
 uniform mat4 ProjectionMatrix;
-uniform mat4 NormalMatrix;
 //uniform vec3 PlanetColor;
 
 //those get passed to fragment shader
 out vec3 pass_Normal; 
+out vec3 pass_Tangent;
+out vec3 pass_Bitangent;
 //out vec3 planet_color;
-out vec3 light_pos;
-out vec3 fragment_pos;
-out vec3 camera_pos;
+out vec3 light_pos; //camera space
+out vec3 camera_pos; //vertex position in camera space
 out vec2 tex_coords;
+flat out vec4 draw_info;
 
 void main(void)
 {
-	gl_Position = (ProjectionMatrix  * ViewMatrix * ModelMatrix) * vec4(in_Position, 1.0);
-	pass_Normal = (NormalMatrix * vec4(in_Normal, 0.0)).xyz;
-	fragment_pos = (ModelMatrix * vec4(in_Position, 1.0)).xyz;
+	gl_Position = (ProjectionMatrix  * ViewMatrix * in_ModelMatrix) * vec4(in_Position, 1.0);
+	//planets are only scaled uniformly, so the upper part of the modelview matrix is a valid normal matrix
+	mat3 NormalMatrix = mat3(ViewMatrix * in_ModelMatrix);
+	pass_Normal = NormalMatrix * in_Normal;
+	pass_Tangent = NormalMatrix * in_Tangent;
+	pass_Bitangent = NormalMatrix * in_Bitangent;
+	vec3 fragment_pos = (in_ModelMatrix * vec4(in_Position, 1.0)).xyz;
 	camera_pos = (ViewMatrix * vec4(fragment_pos,1.0)).xyz; 
+	//the sun is at the world origin
+	light_pos = ViewMatrix[3].xyz;
 	//planet_color = PlanetColor;
 	tex_coords = in_TexCoords;
+	draw_info = in_DrawInfo;
 
 }
@@ -0,0 +1,105 @@
+//shading of the planet surface, included by planet.frag and impostor.frag so meshes and impostors look the same
+//all positions and directions are in camera space
+
+//PointLight
+uniform vec3 LightColor;
+uniform float LightIntensity;
+uniform bool ShaderMode_normal;
+uniform bool ShaderMode_cell;
+uniform sampler2DArray PlanetTextures;
+uniform sampler2DArray NormalTextures;
+
+vec3 specular_light = vec3(0.5);
+
+//Define reflectivity of Planets, defines how much light it reflects
+float reflectivity = 18.0; //rho (slide 7)
+//Shininess = Intensity of the highlight
+float shininess = 24.0; //alpha (slide 8)
+
+//Cel Shading
+float shades = 3; //change for more "shading levels"
+
+//1 = Default (Reset)
+//2 = Cell Shading
+//3 = Normal Mapping
+
+// https://learnopengl.com/Lighting/Basic-Lighting
+// https://learnopengl.com/Advanced-Lighting/Advanced-Lighting
+
+//color of a surface point with its tangent frame and texture coordinates,
+//draw_info of the planet record (x texture layer, y normal texture layer, z has normal map)
+vec3 shade_planet(vec3 normal, vec3 tangent, vec3 bitangent, vec2 tex_coords, vec4 draw_info,
+                  vec3 fragment_pos, vec3 light_pos) {
+
+    vec4 tex_color = texture(PlanetTextures, vec3(tex_coords, draw_info.x));
+
+    //Shades of light
+    vec3 ambient_light = vec3(0.7) * tex_color.rgb;
+    vec3 diffuse_light = tex_color.rgb;
+
+    // Normal
+    vec3 n = normalize(normal);
+
+    //normal mapping
+    if(ShaderMode_normal && draw_info.z > 0.5){
+
+        //tangent space of the surface point, from the mesh vertices or built analytically on impostors
+        vec3 S = normalize(tangent); //horizontal
+        vec3 T = normalize(bitangent); //vertical
+        vec3 N = n; //normal
+
+        vec3 mapN = texture(NormalTextures, vec3(tex_coords, draw_info.y)).xyz * 2.0 -1.0; // "shift" from [0, -1] to [-1, 1]
+        //mapN.xy = 0.5 * mapN.xy;
+        mat3 tsn = mat3 (S, T, N); //new tangent space
+
+        //re-define normal
+        n = normalize (tsn * mapN); // new tangent space mmultiplied by the "Texture Matrix"
+
+    }
+
+    //Vektor from pixel to pointlight
+    vec3 l = light_pos - fragment_pos;
+    //Distance from pixel to pointlight (so the Lightintensity gets smaller the further the planet is away)
+    float distance_ = length(l);
+    //normalize l
+    l = normalize(l);
+
+    //Vektor from pixel to camera, the camera is at the origin of camera space
+    vec3 v = normalize(-fragment_pos);
+
+    //Angle bisector (direction of reflection, halfwayvector)
+    vec3 h = normalize(l + v);
+
+    //Lambertian BRDF
+    //Brightness / Intensity and to determine if it's front or back
+    float lambertian = max(dot(l,n), 0.0);
+    //Intensity of the light that reaches the processed fragment (Slide 6)
+    vec3 beta = (LightColor * LightIntensity) / ((/*4 */ 3.14159265359)* pow(distance_,2));
+
+    //compute diffuse component
+    float diff = max(dot(l, n), 0.0) * (reflectivity / 3.14159265359);
+    vec3 diffuse = diff * diffuse_light;
+
+    //So the light only hits the front of the planet
+    vec3 specular = specular_light;
+    if(lambertian > 0.0){
+        float spec = pow(max(dot(h, v),0.0), 4*shininess);
+        specular = spec * specular;
+    }
+
+    //Celshading: set intensity to one of the levels and draw outline
+    float outline = 1;
+    if(ShaderMode_cell){
+        //no smoothnes, only 3 levels of brightness (defined in shades)
+        float shade = floor(lambertian * shades);
+        lambertian = shade / shades;
+
+        //Outline
+        if(max(dot(n,v),0.0) < 0.35){ //the bigger the threshold the thicker the outline
+            //make the pixel black if normal and view are almost perpendicular
+            outline = 0;
+        }
+    }
+
+    return (ambient_light + (beta * lambertian * (diffuse + specular))) * outline;
+}
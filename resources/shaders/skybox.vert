@@ -14,7 +14,8 @@ void main(){
     //invert view matrix to get the last row as last column, so we can access it 
     vec3 camera_pos = inverse(ViewMatrix)[3].xyz;
 
-    gl_Position = ProjectionMatrix * ViewMatrix * ModelMatrix * vec4(in_Position, 1.0);
+    //depth of w / w = 1, the skybox is always on the far plane
+    gl_Position = (ProjectionMatrix * ViewMatrix * ModelMatrix * vec4(in_Position, 1.0)).xyww;
 
     tex_coords = in_Position;
 
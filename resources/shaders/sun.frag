@@ -1,4 +1,5 @@
 #version 150
+#extension GL_ARB_explicit_attrib_location : require
 //runs for each pixel, determines the color
 //"called" from vertex shader (-> pipeline)
 in vec3 pass_Normal; //normale
@@ -8,6 +9,7 @@ in vec2 tex_coords;
 
 uniform bool ShaderMode_cell;
 uniform sampler2D SunTexture;
+uniform uint BodyId;
 
 //Cel Shading (There is no shade on the sun, so here we only need outlines)
 float outline = 1;
@@ -15,7 +17,9 @@ float outline = 1;
 vec2 texCoords = tex_coords;
 
 //output
-out vec4 out_Color;
+layout(location = 0) out vec4 out_Color;
+//id for picking, only stored if the second attachment is enabled
+layout(location = 1) out uint out_Id;
 
 //1 = Default (Reset)
 //2 = Cell Shading
@@ -39,4 +43,5 @@ void main() {
     }
 
     out_Color = vec4(tex_color.rgb * outline, 1.0);    
+    out_Id = BodyId;
 }